@@ -0,0 +1,53 @@
+#ifndef DIOBJECTSHIFT_H_
+#define DIOBJECTSHIFT_H_
+
+/*
+Kinematics of one di-object in one energy scale variation, stored parallel
+to the di-object collection it was computed from: the scale factors of the
+two legs and the shifted MET
+*/
+
+#include "DataFormats/Candidate/interface/Candidate.h"
+
+#include <cmath>
+
+namespace cmg
+{
+
+  class DiObjectShift{
+  public:
+
+    DiObjectShift():
+      leg1Scale_(1.), leg2Scale_(1.), metPx_(0.), metPy_(0.)
+    {
+    }
+
+    DiObjectShift(float leg1Scale, float leg2Scale, float metPx, float metPy):
+      leg1Scale_(leg1Scale), leg2Scale_(leg2Scale), metPx_(metPx), metPy_(metPy)
+    {
+    }
+
+    float leg1Scale() const {return leg1Scale_;}
+    float leg2Scale() const {return leg2Scale_;}
+    float metPx() const {return metPx_;}
+    float metPy() const {return metPy_;}
+
+    // shifted momenta, from the di-object the shift was computed for
+    reco::Candidate::LorentzVector leg1(const reco::Candidate& diObject) const {return diObject.daughter(0)->p4()*leg1Scale_;}
+    reco::Candidate::LorentzVector leg2(const reco::Candidate& diObject) const {return diObject.daughter(1)->p4()*leg2Scale_;}
+    reco::Candidate::LorentzVector met() const {
+      return reco::Candidate::LorentzVector(metPx_, metPy_, 0., std::sqrt(metPx_*metPx_+metPy_*metPy_));
+    }
+
+  private:
+
+    float leg1Scale_;
+    float leg2Scale_;
+    float metPx_;
+    float metPy_;
+
+  };
+
+}
+
+#endif /*DIOBJECTSHIFT_H_*/
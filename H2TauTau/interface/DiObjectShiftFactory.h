@@ -0,0 +1,126 @@
+#ifndef DIOBJECTSHIFTFACTORY_H_
+#define DIOBJECTSHIFTFACTORY_H_
+
+#include "CMGTools/H2TauTau/interface/DiObjectUpdateFactory.h"
+#include "CMGTools/H2TauTau/interface/DiObjectShift.h"
+
+#include <string>
+#include <vector>
+
+namespace cmg{
+
+  // All the energy scale variations of DiObjectUpdateFactory in one module.
+  // The collections are read and the legs gen matched once per event; for
+  // each variation in the "variations" VPSet (name, nSigma and optionally
+  // any of the shift parameters, the others being taken from the top level)
+  // a std::vector<DiObjectShift> parallel to the input is put in the event
+  // with the variation name as instance label. With produceCollections the
+  // shifted di-object collections, as made by DiObjectUpdateFactory, are put
+  // as well under the same labels.
+  template< typename T, typename U>
+  class DiObjectShiftFactory : public edm::EDProducer  {
+
+  typedef std::vector<DiTauObject> collection;
+  typedef std::vector<DiObjectShift> shift_collection;
+
+  public:
+
+    DiObjectShiftFactory(const edm::ParameterSet& ps):
+      diObjectLabel_     (ps.getParameter<edm::InputTag>("diObjectCollection")),
+      genParticleLabel_  (ps.getParameter<edm::InputTag>("genCollection")),
+      shiftMet_          (ps.getParameter<bool>("shiftMet")),
+      shiftTaus_         (ps.getParameter<bool>("shiftTaus")),
+      produceCollections_(ps.getParameter<bool>("produceCollections"))
+      {
+        const std::vector<edm::ParameterSet> variations = ps.getParameter<std::vector<edm::ParameterSet> >("variations");
+        for(std::vector<edm::ParameterSet>::const_iterator it = variations.begin(); it != variations.end(); ++it){
+          names_.push_back(it->getParameter<std::string>("name"));
+          tauShifts_.push_back(TauEnergyShift(*it, ps));
+          produces<shift_collection>(names_.back());
+          if(produceCollections_)
+            produces<collection>(names_.back());
+        }
+        consumes<collection>(diObjectLabel_);
+        consumes<std::vector<reco::GenParticle> >(genParticleLabel_);
+      }
+
+    void produce(edm::Event&, const edm::EventSetup&);
+
+  private:
+
+    const edm::InputTag diObjectLabel_;
+    const edm::InputTag genParticleLabel_;
+    bool   shiftMet_ ;
+    bool   shiftTaus_ ;
+    bool   produceCollections_ ;
+    std::vector<std::string> names_;
+    std::vector<TauEnergyShift> tauShifts_;
+  };
+
+} // namespace cmg
+
+
+template< typename T, typename U >
+void cmg::DiObjectShiftFactory<T, U>::produce(edm::Event& iEvent, const edm::EventSetup&){
+
+  edm::Handle<collection> diObjects;
+  iEvent.getByLabel(diObjectLabel_,diObjects);
+
+  edm::Handle< std::vector<reco::GenParticle> > genparticles;
+  iEvent.getByLabel(genParticleLabel_, genparticles);
+
+  // gen matching does not depend on the variation
+  GenTauMatcher genTaus(*genparticles);
+  const size_t nDiObjects = diObjects->size();
+  std::vector<bool> l1genMatched(nDiObjects);
+  std::vector<bool> l2genMatched(nDiObjects);
+  for(size_t index = 0; index < nDiObjects; ++index){
+    const DiTauObject& diObject = (*diObjects)[index];
+    l1genMatched[index] = genTaus.matched<T>(*diObject.daughter(0));
+    l2genMatched[index] = genTaus.matched<U>(*diObject.daughter(1));
+  }
+
+  for(size_t iVar = 0; iVar < names_.size(); ++iVar){
+    const TauEnergyShift& tauShift = tauShifts_[iVar];
+
+    std::auto_ptr<shift_collection> shifts(new shift_collection);
+    shifts->reserve(nDiObjects);
+    std::auto_ptr<collection> result(produceCollections_ ? new collection : 0);
+
+    for(size_t index = 0; index < nDiObjects; ++index){
+      const DiTauObject& diObject = (*diObjects)[index];
+
+      float shift1 = tauShift.shift<T>(*diObject.daughter(0));
+      float shift2 = tauShift.shift<U>(*diObject.daughter(1));
+
+      reco::Candidate::LorentzVector leg1Vec, leg2Vec, metVecNew;
+      shiftDiObject(diObject, shift1, l1genMatched[index], shift2, l2genMatched[index], leg1Vec, leg2Vec, metVecNew);
+
+      const reco::Candidate::LorentzVector& metVec = shiftMet_ ? metVecNew : diObject.daughter(2)->p4();
+      shifts->push_back(DiObjectShift((shiftTaus_ && l1genMatched[index]) ? 1. + shift1 : 1.,
+                                      (shiftTaus_ && l2genMatched[index]) ? 1. + shift2 : 1.,
+                                      metVec.px(), metVec.py()));
+
+      if(produceCollections_){
+        T leg1(*dynamic_cast<const T*>(diObject.daughter(0)));
+        U leg2(*dynamic_cast<const U*>(diObject.daughter(1)));
+        reco::MET met(*dynamic_cast<const reco::MET*>(diObject.daughter(2)));
+
+        if (shiftTaus_ ){ leg1.setP4(leg1Vec); }
+        if (shiftTaus_ ){ leg2.setP4(leg2Vec); }
+        if (shiftMet_  ){ met.setP4(metVecNew); }
+
+        result->push_back(diObject);
+
+        DiTauObjectFactory<T, U>::set( std::make_pair(leg1, leg2), met, result->back() );
+      }
+    }
+
+    iEvent.put(shifts, names_[iVar]);
+    if(produceCollections_)
+      iEvent.put(result, names_[iVar]);
+  }
+}
+
+
+#endif /*DIOBJECTSHIFTFACTORY_H_*/
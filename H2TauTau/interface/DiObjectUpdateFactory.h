@@ -7,10 +7,188 @@
 
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+
 namespace cmg{
 
   typedef pat::CompositeCandidate DiTauObject;
 
+  // Tau energy scale shift: nSigma*uncertainty plus the decay mode dependent terms
+  struct TauEnergyShift {
+
+    TauEnergyShift(const edm::ParameterSet& ps):
+      nSigma            (ps.getParameter<double>("nSigma")),
+      uncertainty       (ps.getParameter<double>("uncertainty")),
+      shift1ProngNoPi0  (ps.getParameter<double>("shift1ProngNoPi0")),
+      shift1Prong1Pi0   (ps.getParameter<double>("shift1Prong1Pi0")),
+      ptDependence1Pi0  (ps.getParameter<double>("ptDependence1Pi0")),
+      shift3Prong       (ps.getParameter<double>("shift3Prong")),
+      ptDependence3Prong(ps.getParameter<double>("ptDependence3Prong"))
+      {}
+
+    // the parameters present in variation override the ones in defaults
+    TauEnergyShift(const edm::ParameterSet& variation, const edm::ParameterSet& defaults):
+      nSigma            (variation.getParameter<double>("nSigma")),
+      uncertainty       (param(variation, defaults, "uncertainty")),
+      shift1ProngNoPi0  (param(variation, defaults, "shift1ProngNoPi0")),
+      shift1Prong1Pi0   (param(variation, defaults, "shift1Prong1Pi0")),
+      ptDependence1Pi0  (param(variation, defaults, "ptDependence1Pi0")),
+      shift3Prong       (param(variation, defaults, "shift3Prong")),
+      ptDependence3Prong(param(variation, defaults, "ptDependence3Prong"))
+      {}
+
+    static double param(const edm::ParameterSet& variation, const edm::ParameterSet& defaults, const std::string& name){
+      return variation.exists(name) ? variation.getParameter<double>(name) : defaults.getParameter<double>(name);
+    }
+
+    // relative shift of the leg, only taus are shifted
+    template<typename T>
+    float shift(const reco::Candidate& leg) const {
+      if(typeid(T)!=typeid(pat::Tau))
+        return 0.;
+      float result = (nSigma * uncertainty);
+      const pat::Tau& tau = dynamic_cast<const pat::Tau&>(leg);
+      if((tau.decayMode()==0)&&(shift1ProngNoPi0!=0))
+        result+=shift1ProngNoPi0;
+      //Also allow decay mode 2 according to synchronisation twiki
+      if((tau.decayMode()==1 || tau.decayMode()==2)&&(shift1Prong1Pi0!=0))
+        result+=shift1Prong1Pi0+ptDependence1Pi0*TMath::Min(TMath::Max(leg.pt()-45.,0.),10.);
+      if((tau.decayMode()==10)&&(shift3Prong!=0))
+        result+=shift3Prong+ptDependence3Prong*TMath::Min(TMath::Max(leg.pt()-32.,0.),18.);
+      return result;
+    }
+
+    double nSigma;
+    double uncertainty;
+    double shift1ProngNoPi0;
+    double shift1Prong1Pi0;
+    double ptDependence1Pi0;
+    double shift3Prong;
+    double ptDependence3Prong;
+  };
+
+  // the tauES shift must be applied to *real* taus only: a leg is matched if
+  // it is a tau within deltaR 0.3 of a status 3 generator tau from a Z, h, H
+  // or A. The generator taus are selected once per event and bucketed in
+  // eta-phi cells at least as large as the cone, so a lookup only looks at
+  // the 3x3 cells around the leg; the result is cached per leg direction,
+  // legs shared between di-objects are matched once.
+  class GenTauMatcher {
+  public:
+
+    GenTauMatcher(const std::vector<reco::GenParticle>& genparticles){
+      for ( size_t i=0; i< genparticles.size(); ++i)
+      {
+        const reco::GenParticle &p = genparticles[i];
+        // PDG Id: e 11, mu 13, tau 15, Z 23, h 25, H 35, A 35
+        if ( p.status() != 3 || abs(p.pdgId()) != 15 || p.numberOfMothers()==0 )
+          continue;
+        int motherId = p.mother(0)->pdgId() ;
+        if ( motherId == 23 || motherId == 25 || motherId == 35 || motherId == 36 ){
+          GenTau tau = {cell(p.eta(), p.phi()), p.eta(), p.phi()};
+          taus_.push_back(tau);
+        }
+      }
+      std::sort(taus_.begin(), taus_.end());
+    }
+
+    template<typename T>
+    bool matched(const reco::Candidate& leg){
+      if(typeid(T)!=typeid(pat::Tau) || taus_.empty())
+        return false;
+      const double eta = leg.eta();
+      const double phi = leg.phi();
+      for(size_t i=0; i<cache_.size(); ++i)
+        if(cache_[i].eta==eta && cache_[i].phi==phi)
+          return cache_[i].matched;
+      LegMatch match = {eta, phi, lookup(eta, phi)};
+      cache_.push_back(match);
+      return match.matched;
+    }
+
+  private:
+
+    static const int kNEta = 34;   // cells of 0.3 in |eta|<5.1, the outer ones open
+    static const int kNPhi = 20;   // cells of 2pi/20 > 0.3
+
+    static int etaCell(double eta){
+      if(!(eta > -0.3*(kNEta/2-1))) return 0;
+      if(!(eta < 0.3*(kNEta/2-1))) return kNEta-1;
+      return int(std::floor(eta/0.3)) + kNEta/2;
+    }
+    static int phiCell(double phi){
+      int iphi = int(std::floor((phi+M_PI)*kNPhi/(2*M_PI)));
+      return ((iphi % kNPhi) + kNPhi) % kNPhi;
+    }
+    static int cell(double eta, double phi){ return etaCell(eta)*kNPhi + phiCell(phi); }
+
+    bool lookup(double eta, double phi) const {
+      const int ieta = etaCell(eta);
+      const int iphi = phiCell(phi);
+      for(int deta=-1; deta<=1; ++deta){
+        if(ieta+deta<0 || ieta+deta>=kNEta) continue;
+        for(int dphi=-1; dphi<=1; ++dphi){
+          GenTau key = {(ieta+deta)*kNPhi + (iphi+dphi+kNPhi)%kNPhi, 0., 0.};
+          for(std::vector<GenTau>::const_iterator it = std::lower_bound(taus_.begin(), taus_.end(), key);
+              it != taus_.end() && it->cell == key.cell; ++it)
+            if (deltaR(eta,phi,it->eta,it->phi)<0.3)
+              return true;
+        }
+      }
+      return false;
+    }
+
+    struct GenTau {
+      int cell;
+      double eta;
+      double phi;
+      bool operator<(const GenTau& other) const { return cell < other.cell; }
+    };
+    struct LegMatch {
+      double eta;
+      double phi;
+      bool matched;
+    };
+
+    std::vector<GenTau> taus_;
+    std::vector<LegMatch> cache_;
+  };
+
+  // Shifted leg momenta and MET of a di-object; the legs are scaled by
+  // 1+shift if gen matched and the MET absorbs the transverse momentum change
+  inline void shiftDiObject(const DiTauObject& diObject,
+                            float shift1, bool l1genMatched,
+                            float shift2, bool l2genMatched,
+                            reco::Candidate::LorentzVector& leg1Vec,
+                            reco::Candidate::LorentzVector& leg2Vec,
+                            reco::Candidate::LorentzVector& metVecNew){
+
+    leg1Vec = diObject.daughter(0)->p4();
+    leg2Vec = diObject.daughter(1)->p4();
+    reco::Candidate::LorentzVector metVec = diObject.daughter(2)->p4();
+
+    float dpx = 0.;
+    float dpy = 0.;
+
+    // if genMatched compute the transverse momentum variation 
+    dpx = l1genMatched * leg1Vec.px() * shift1 + l2genMatched * leg2Vec.px() * shift2;
+    dpy = l1genMatched * leg1Vec.py() * shift1 + l2genMatched * leg2Vec.py() * shift2;
+
+    // if genMatched apply the shift 
+    if (l1genMatched) leg1Vec *= (1. + shift1);
+    if (l2genMatched) leg2Vec *= (1. + shift2);
+
+    // apply the tranverse momentum correction to the MET 
+    math::XYZTLorentzVector deltaTauP4(dpx,dpy,0,0);
+    math::XYZTLorentzVector scaledmetP4 = metVec - deltaTauP4;
+
+    TLorentzVector metVecTmp;
+    metVecTmp.SetPtEtaPhiM(scaledmetP4.Pt(),scaledmetP4.Eta(),scaledmetP4.Phi(),0.);
+    metVecNew = reco::Candidate::LorentzVector(metVecTmp.Px(),metVecTmp.Py(),metVecTmp.Pz(),metVecTmp.E());
+  }
+
   template< typename T, typename U>
   class DiObjectUpdateFactory : public edm::EDProducer  {
 
@@ -21,13 +199,7 @@ namespace cmg{
     DiObjectUpdateFactory(const edm::ParameterSet& ps):
       diObjectLabel_     (ps.getParameter<edm::InputTag>("diObjectCollection")),
       genParticleLabel_  (ps.getParameter<edm::InputTag>("genCollection")),
-      nSigma_            (ps.getParameter<double>("nSigma")),
-      uncertainty_       (ps.getParameter<double>("uncertainty")),
-      shift1ProngNoPi0_  (ps.getParameter<double>("shift1ProngNoPi0")),
-      shift1Prong1Pi0_   (ps.getParameter<double>("shift1Prong1Pi0")),
-      ptDependence1Pi0_  (ps.getParameter<double>("ptDependence1Pi0")),
-      shift3Prong_       (ps.getParameter<double>("shift3Prong")),
-      ptDependence3Prong_(ps.getParameter<double>("ptDependence3Prong")),
+      tauShift_          (ps),
       shiftMet_          (ps.getParameter<bool>("shiftMet")),
       shiftTaus_         (ps.getParameter<bool>("shiftTaus"))
       {
@@ -42,13 +214,7 @@ namespace cmg{
 
     const edm::InputTag diObjectLabel_;
     const edm::InputTag genParticleLabel_;
-    double nSigma_;
-    double uncertainty_; 
-    double shift1ProngNoPi0_; 
-    double shift1Prong1Pi0_; 
-    double ptDependence1Pi0_; 
-    double shift3Prong_; 
-    double ptDependence3Prong_; 
+    const TauEnergyShift tauShift_;
     bool   shiftMet_ ;
     bool   shiftTaus_ ;
   };
@@ -64,6 +230,7 @@ void cmg::DiObjectUpdateFactory<T, U>::produce(edm::Event& iEvent, const edm::Ev
 
   edm::Handle< std::vector<reco::GenParticle> > genparticles;
   iEvent.getByLabel(genParticleLabel_, genparticles);
+  GenTauMatcher genTaus(*genparticles);
    
   std::auto_ptr<collection> result(new collection);
   
@@ -75,94 +242,18 @@ void cmg::DiObjectUpdateFactory<T, U>::produce(edm::Event& iEvent, const edm::Ev
     U leg2(*dynamic_cast<const U*>(diObject.daughter(1)));
     reco::MET met(*dynamic_cast<const reco::MET*>(diObject.daughter(2)));
 
-    float shift1 = 0.;
-    float shift2 = 0.;
-    if(typeid(T)==typeid(pat::Tau))
-    {
-     	shift1 = (nSigma_ * uncertainty_);
-      const pat::Tau& tau1 = dynamic_cast<const pat::Tau&>(*diObject.daughter(0));
-     	if((tau1.decayMode()==0)&&(shift1ProngNoPi0_!=0))
-     	    shift1+=shift1ProngNoPi0_;
-        //Also allow decay mode 2 according to synchronisation twiki
-     	if((tau1.decayMode()==1 || tau1.decayMode()==2)&&(shift1Prong1Pi0_!=0))
-     	    shift1+=shift1Prong1Pi0_+ptDependence1Pi0_*TMath::Min(TMath::Max(diObject.daughter(0)->pt()-45.,0.),10.);
-     	if((tau1.decayMode()==10)&&(shift3Prong_!=0))
-     	    shift1+=shift3Prong_+ptDependence3Prong_*TMath::Min(TMath::Max(diObject.daughter(0)->pt()-32.,0.),18.);
-    }
-
-    if(typeid(U)==typeid(pat::Tau))
-    {
-     	shift2 = (nSigma_ * uncertainty_);
-      const pat::Tau& tau2 = dynamic_cast<const pat::Tau&>(*diObject.daughter(1));
-     	if((tau2.decayMode()==0)&&(shift1ProngNoPi0_!=0))
-     	    shift2+=shift1ProngNoPi0_;
-        //Also allow decay mode 2 according to synchronisation twiki
-     	if((tau2.decayMode()==1 || tau2.decayMode()==2)&&(shift1Prong1Pi0_!=0))
-     	    shift2+=shift1Prong1Pi0_+ptDependence1Pi0_*TMath::Min(TMath::Max(diObject.daughter(1)->pt()-45.,0.),10.);
-     	if((tau2.decayMode()==10)&&(shift3Prong_!=0))
-     	    shift2+=shift3Prong_+ptDependence3Prong_*TMath::Min(TMath::Max(diObject.daughter(1)->pt()-32.,0.),18.);
-    }
-
-    // the tauES shift must be applied to *real* taus only
-    bool l1genMatched = false ;
-    bool l2genMatched = false ;
-    
-    for ( size_t i=0; i< genparticles->size(); ++i) 
-    {
-      const reco::GenParticle &p = (*genparticles)[i];
-      int id       = p.pdgId()           ;
-      int status   = p.status()          ;
-      int motherId = 0                   ; 
-      if ( p.numberOfMothers()>0 ) {
-        //std::cout << __LINE__ << "]\tnum of mothers " << p.numberOfMothers() << "\tmy mom " << p.mother()->pdgId() << std::endl ;
-        motherId = p.mother(0)->pdgId() ;
-      }
-      // PDG Id: e 11, mu 13, tau 15, Z 23, h 25, H 35, A 35  
-      if ( status == 3 && abs(id) == 15 && (motherId == 23 || motherId == 25 || motherId == 35 || motherId == 36 )){
-        // match leg 1
-        if(typeid(T)==typeid(pat::Tau)){
-          const pat::Tau& tau1 = dynamic_cast<const pat::Tau&>(*diObject.daughter(0));
-          if (deltaR(tau1.eta(),tau1.phi(),p.eta(),p.phi())<0.3) {
-            l1genMatched = true ;
-            //std::cout << __LINE__ << "]\tleg1 matched to a tau" << std::endl ;
-          }
-        }
-        // match leg 2
-        if(typeid(U)==typeid(pat::Tau)){
-          const pat::Tau& tau2 = dynamic_cast<const pat::Tau&>(*diObject.daughter(1));
-          if (deltaR(tau2.eta(),tau2.phi(),p.eta(),p.phi())<0.3) {
-            l2genMatched = true ;
-            //std::cout << __LINE__ << "]\tleg2 matched to a tau" << std::endl ;
-          }
-        }
-      }
-    }
-
-    reco::Candidate::LorentzVector leg1Vec = diObject.daughter(0)->p4();
-    reco::Candidate::LorentzVector leg2Vec = diObject.daughter(1)->p4();
-    reco::Candidate::LorentzVector metVec = met.p4();
+    float shift1 = tauShift_.shift<T>(*diObject.daughter(0));
+    float shift2 = tauShift_.shift<U>(*diObject.daughter(1));
 
-    float dpx = 0.;
-    float dpy = 0.;
-
-    // if genMatched compute the transverse momentum variation 
-    dpx = l1genMatched * leg1Vec.px() * shift1 + l2genMatched * leg2Vec.px() * shift2;
-    dpy = l1genMatched * leg1Vec.py() * shift1 + l2genMatched * leg2Vec.py() * shift2;
-
-    // if genMatched apply the shift 
-    if (l1genMatched) leg1Vec *= (1. + shift1);
-    if (l2genMatched) leg2Vec *= (1. + shift2);
-
-    // apply the tranverse momentum correction to the MET 
-    math::XYZTLorentzVector deltaTauP4(dpx,dpy,0,0);
-    math::XYZTLorentzVector scaledmetP4 = metVec - deltaTauP4;
+    bool l1genMatched = genTaus.matched<T>(*diObject.daughter(0));
+    bool l2genMatched = genTaus.matched<U>(*diObject.daughter(1));
 
-    TLorentzVector metVecNew;
-    metVecNew.SetPtEtaPhiM(scaledmetP4.Pt(),scaledmetP4.Eta(),scaledmetP4.Phi(),0.);
+    reco::Candidate::LorentzVector leg1Vec, leg2Vec, metVecNew;
+    shiftDiObject(diObject, shift1, l1genMatched, shift2, l2genMatched, leg1Vec, leg2Vec, metVecNew);
         
     if (shiftTaus_ ){ leg1.setP4(leg1Vec); }
     if (shiftTaus_ ){ leg2.setP4(leg2Vec); }
-    if (shiftMet_  ){ met.setP4(reco::Candidate::LorentzVector(metVecNew.Px(),metVecNew.Py(),metVecNew.Pz(),metVecNew.E())); }
+    if (shiftMet_  ){ met.setP4(metVecNew); }
 
     result->push_back(diObject);
 
@@ -13,6 +13,8 @@
 #include "DataFormats/PatCandidates/interface/MET.h"
 #include "DataFormats/METReco/interface/MET.h"
 
+#include "CMGTools/H2TauTau/interface/DiTauPair.h"
+
 #include <algorithm>
 #include <set>
 
@@ -31,9 +33,15 @@ class DiTauObjectFactory : public edm::EDProducer
         DiTauObjectFactory(const edm::ParameterSet& ps) :             
             leg1Label_(ps.getParameter<edm::InputTag>("leg1Collection")),
             leg2Label_(ps.getParameter<edm::InputTag>("leg2Collection")),
-            metLabel_(ps.getParameter<edm::InputTag>("metCollection"))
+            metLabel_(ps.getParameter<edm::InputTag>("metCollection")),
+            lightweight_(ps.getParameter<bool>("lightweight"))
         {
-          produces<std::vector<DiTauObject>>();
+          // lightweight: std::vector<cmg::DiTauPair> referencing the inputs
+          // instead of DiTauObjects holding copies of them
+          if (lightweight_)
+            produces<std::vector<DiTauPair>>();
+          else
+            produces<std::vector<DiTauObject>>();
           consumes<collection1>(leg1Label_);
           consumes<collection2>(leg2Label_);
           consumes<met_collection>(metLabel_);
@@ -47,6 +55,7 @@ class DiTauObjectFactory : public edm::EDProducer
         const edm::InputTag leg1Label_;
         const edm::InputTag leg2Label_;
         const edm::InputTag metLabel_;
+        const bool lightweight_;
 };
 
 ///Make when the types are different
@@ -77,6 +86,13 @@ cmg::DiTauObject makeDiTau(const T& l1, const T& l2){
     return diTauObj;
 }
 
+///Lightweight pair; the legs are sorted by pt as in makeDiTau<T> if sort is set
+inline cmg::DiTauPair makeDiTauPair(const reco::CandidatePtr& l1, const reco::CandidatePtr& l2, const reco::CandidatePtr& met, bool sort){
+    if (sort && l1->pt() < l2->pt())
+        return cmg::DiTauPair(l2, l1, met);
+    return cmg::DiTauPair(l1, l2, met);
+}
+
 template<typename T, typename U>
 void cmg::DiTauObjectFactory<T, U>::set(const std::pair<T, U>& pair, const reco::MET& met, cmg::DiTauObject& obj) {
 
@@ -116,13 +132,14 @@ void cmg::DiTauObjectFactory<T, U>::produce(edm::Event& iEvent, const edm::Event
   }
 
   std::auto_ptr<std::vector<DiTauObject>> result(new std::vector<DiTauObject>);
+  std::auto_ptr<std::vector<DiTauPair>> pairs(new std::vector<DiTauPair>);
 
   bool patMet = false;
 
   const bool sameCollection = (leg1Cands.id () == leg2Cands.id());
   bool found = false;
-  for (auto& metCand : *metCands) {
-    const pat::MET* patMET = dynamic_cast<const pat::MET*>(&metCand);
+  for (size_t iMet = 0; iMet < metCands->size(); ++iMet) {
+    const pat::MET* patMET = dynamic_cast<const pat::MET*>(&(*metCands)[iMet]);
     if (patMET) {
       patMet = true;
       if (! patMET->hasUserCand("lepton0") || ! patMET->hasUserCand("lepton1")) {
@@ -130,24 +147,31 @@ void cmg::DiTauObjectFactory<T, U>::produce(edm::Event& iEvent, const edm::Event
         continue;
       }
       // JAN - not sure how to code this nicer w/o avoiding extra casts...
-      const T* first = dynamic_cast<const T*>(patMET->userCand("lepton0").get());
+      reco::CandidatePtr firstPtr = patMET->userCand("lepton0");
+      const T* first = dynamic_cast<const T*>(firstPtr.get());
       const U* second = nullptr;
       if (!first) {
-        first = dynamic_cast<const T*>(patMET->userCand("lepton1").get());
+        firstPtr = patMET->userCand("lepton1");
+        first = dynamic_cast<const T*>(firstPtr.get());
         if (!first) {
           // edm::LogWarning("produce") << "MET user candidate 0 not of type T" << std::endl;
           continue;
         }
         second = dynamic_cast<const U*>(patMET->userCand("lepton0").get());
       }
-      second = dynamic_cast<const U*>(patMET->userCand("lepton1").get());
+      const reco::CandidatePtr secondPtr = patMET->userCand("lepton1");
+      second = dynamic_cast<const U*>(secondPtr.get());
       if (!second) {
         // edm::LogWarning("produce") << "MET user candidate 1 not of type U" << std::endl;
         continue;
       }
+      found = true;
+      if (lightweight_) {
+        pairs->push_back(cmg::makeDiTauPair(firstPtr, secondPtr, reco::CandidatePtr(metCands->ptrAt(iMet)), sameCollection));
+        continue;
+      }
       cmg::DiTauObject cmgTmp = sameCollection ? cmg::makeDiTau<T>(*first, *second) : cmg::makeDiTau<T, U>(*first, *second); 
       cmg::DiTauObjectFactory<T, U>::set(*patMET, cmgTmp);
-      found = true;
       result->push_back(cmgTmp);
     }
   }
@@ -155,6 +179,7 @@ void cmg::DiTauObjectFactory<T, U>::produce(edm::Event& iEvent, const edm::Event
     edm::LogWarning("produce") << "Did not find suitable user candidates in the pat::MET of types T and U" << std::endl;
 
   if (!patMet) {
+    size_t nMade = 0;
     for (size_t i1 = 0; i1 < leg1Cands->size(); ++i1) {
       for (size_t i2 = 0; i2 < leg2Cands->size(); ++i2) {
 
@@ -162,20 +187,32 @@ void cmg::DiTauObjectFactory<T, U>::produce(edm::Event& iEvent, const edm::Event
         if (sameCollection && (i1 >= i2)) 
           continue;
         
-        //enable sorting only if we are using the same collection - see Savannah #20217
-        cmg::DiTauObject cmgTmp = sameCollection ? cmg::makeDiTau<T>((*leg1Cands)[i1], (*leg2Cands)[i2]) : cmg::makeDiTau<T, U>((*leg1Cands)[i1], (*leg2Cands)[i2]); 
-        
         if (metAvailable && ! metCands->empty()) {
-            if (metCands->size() < result->size()+1)
+            if (metCands->size() < nMade+1)
               edm::LogWarning("produce") << "Fewer MET candidates than leg1/leg2 combinations; are the inputs to the MET producer and the di-tau object producer the same?" << std::endl;
-            cmg::DiTauObjectFactory<T, U>::set(metCands->at(result->size()), cmgTmp);
+            if (lightweight_) {
+              //same bounds check as metCands->at() below
+              if (nMade >= metCands->size())
+                throw cms::Exception("DiTauObjectFactory") << "no MET candidate for leg1/leg2 combination " << nMade;
+              pairs->push_back(cmg::makeDiTauPair(reco::CandidatePtr(leg1Cands->ptrAt(i1)), reco::CandidatePtr(leg2Cands->ptrAt(i2)),
+                                                  reco::CandidatePtr(metCands->ptrAt(nMade)), sameCollection));
+              ++nMade;
+              continue;
+            }
+            //enable sorting only if we are using the same collection - see Savannah #20217
+            cmg::DiTauObject cmgTmp = sameCollection ? cmg::makeDiTau<T>((*leg1Cands)[i1], (*leg2Cands)[i2]) : cmg::makeDiTau<T, U>((*leg1Cands)[i1], (*leg2Cands)[i2]); 
+            cmg::DiTauObjectFactory<T, U>::set(metCands->at(nMade), cmgTmp);
             result->push_back(cmgTmp);
+            ++nMade;
         }
       }
     }
   }
 
-  iEvent.put(result); 
+  if (lightweight_)
+    iEvent.put(pairs);
+  else
+    iEvent.put(result); 
 }
 
 } // namespace cmg
@@ -0,0 +1,84 @@
+#ifndef DITAUPAIR_H_
+#define DITAUPAIR_H_
+
+/*
+Lightweight di-tau candidate: references to the two legs and the MET in
+their original collections, and the pair quantities computed when the pair
+is made. The legs and the MET are only read when accessed, so the
+collections they point to must be kept along with the pairs.
+*/
+
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "DataFormats/Candidate/interface/CandidateFwd.h"
+#include "DataFormats/Math/interface/deltaPhi.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include <cmath>
+
+namespace cmg
+{
+
+  class DiTauPair{
+  public:
+
+    DiTauPair():
+      mass_(0.), pt_(0.), deltaR_(0.), mtLeg1_(0.), mtLeg2_(0.), charge_(0)
+    {
+    }
+
+    DiTauPair(const reco::CandidatePtr& leg1, const reco::CandidatePtr& leg2, const reco::CandidatePtr& met):
+      leg1_(leg1), leg2_(leg2), met_(met)
+    {
+      const reco::Candidate::LorentzVector p4 = leg1->p4() + leg2->p4();
+      mass_ = p4.mass();
+      pt_ = p4.pt();
+      deltaR_ = reco::deltaR(*leg1, *leg2);
+      charge_ = leg1->charge() + leg2->charge();
+      mtLeg1_ = met.isNonnull() ? mT(*leg1, *met) : 0.;
+      mtLeg2_ = met.isNonnull() ? mT(*leg2, *met) : 0.;
+    }
+
+    const reco::Candidate& leg1() const {return *leg1_;}
+    const reco::Candidate& leg2() const {return *leg2_;}
+    const reco::Candidate& met() const {return *met_;}
+    const reco::CandidatePtr& leg1Ptr() const {return leg1_;}
+    const reco::CandidatePtr& leg2Ptr() const {return leg2_;}
+    const reco::CandidatePtr& metPtr() const {return met_;}
+
+    // the legs and the MET as their concrete types, 0 if of another type
+    template<typename T> const T* leg1As() const {return dynamic_cast<const T*>(leg1_.get());}
+    template<typename T> const T* leg2As() const {return dynamic_cast<const T*>(leg2_.get());}
+    template<typename T> const T* metAs() const {return dynamic_cast<const T*>(met_.get());}
+
+    reco::Candidate::LorentzVector p4() const {return leg1_->p4() + leg2_->p4();}
+
+    float mass() const {return mass_;}
+    float pt() const {return pt_;}
+    int charge() const {return charge_;}
+    float deltaR() const {return deltaR_;}
+    // transverse mass of each leg with the MET
+    float mtLeg1() const {return mtLeg1_;}
+    float mtLeg2() const {return mtLeg2_;}
+
+    static float mT(const reco::Candidate& leg, const reco::Candidate& met){
+      return std::sqrt(2.*leg.pt()*met.pt()*(1.-std::cos(reco::deltaPhi(leg.phi(), met.phi()))));
+    }
+
+  private:
+
+    reco::CandidatePtr leg1_;
+    reco::CandidatePtr leg2_;
+    reco::CandidatePtr met_;
+
+    float mass_;
+    float pt_;
+    float deltaR_;
+    float mtLeg1_;
+    float mtLeg2_;
+    int charge_;
+
+  };
+
+}
+
+#endif /*DITAUPAIR_H_*/
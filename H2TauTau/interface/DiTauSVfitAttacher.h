@@ -0,0 +1,73 @@
+#ifndef DITAUSVFITATTACHER_H_
+#define DITAUSVFITATTACHER_H_
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/Common/interface/ValueMap.h"
+#include "DataFormats/PatCandidates/interface/CompositeCandidate.h"
+
+#include "CMGTools/H2TauTau/interface/SVfitResult.h"
+
+#include <vector>
+
+// Makes the di-object collection that DiTauWithSVFitProducer writes with
+// outputMode "collection" from its "valueMap" or "vector" output, so that the
+// copy with the SVfit user floats is only made by the jobs that need it.
+// svfitSrc is read as an edm::ValueMap<cmg::SVfitResult> if there is one,
+// as a std::vector<cmg::SVfitResult> aligned with diTauSrc otherwise.
+class DiTauSVfitAttacher : public edm::EDProducer {
+
+  typedef pat::CompositeCandidate DiTauObject;
+  typedef std::vector<DiTauObject> DiTauCollection;
+
+public:
+  explicit DiTauSVfitAttacher(const edm::ParameterSet& iConfig) :
+    diTauSrc_(iConfig.getParameter<edm::InputTag>("diTauSrc")),
+    svfitSrc_(iConfig.getParameter<edm::InputTag>("svfitSrc"))
+  {
+    produces<DiTauCollection>();
+    consumes<DiTauCollection>(diTauSrc_);
+    mayConsume<edm::ValueMap<cmg::SVfitResult> >(svfitSrc_);
+    mayConsume<std::vector<cmg::SVfitResult> >(svfitSrc_);
+  }
+  virtual ~DiTauSVfitAttacher() {}
+
+private:
+  void produce(edm::Event& iEvent, const edm::EventSetup&) {
+    edm::Handle<DiTauCollection> diTauH;
+    iEvent.getByLabel(diTauSrc_, diTauH);
+
+    std::auto_ptr<DiTauCollection> pOut(new DiTauCollection());
+    pOut->reserve(diTauH->size());
+
+    edm::Handle<edm::ValueMap<cmg::SVfitResult> > svfitMapH;
+    iEvent.getByLabel(svfitSrc_, svfitMapH);
+    if (svfitMapH.isValid()) {
+      for (size_t i = 0; i < diTauH->size(); ++i) {
+        pOut->push_back((*diTauH)[i]);
+        (*svfitMapH)[edm::Ref<DiTauCollection>(diTauH, i)].attach(pOut->back());
+      }
+    }
+    else {
+      edm::Handle<std::vector<cmg::SVfitResult> > svfitH;
+      iEvent.getByLabel(svfitSrc_, svfitH);
+      if (svfitH->size() != diTauH->size())
+        throw cms::Exception("DiTauSVfitAttacher") << svfitSrc_ << " has " << svfitH->size() << " SVfit results for " << diTauH->size() << " di-objects in " << diTauSrc_;
+      for (size_t i = 0; i < diTauH->size(); ++i) {
+        pOut->push_back((*diTauH)[i]);
+        (*svfitH)[i].attach(pOut->back());
+      }
+    }
+
+    iEvent.put(pOut);
+  }
+
+  edm::InputTag diTauSrc_;
+  edm::InputTag svfitSrc_;
+};
+
+#endif /*DITAUSVFITATTACHER_H_*/
@@ -7,6 +7,7 @@
 #include "FWCore/Utilities/interface/Exception.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 
+#include "DataFormats/Common/interface/ValueMap.h"
 #include "DataFormats/METReco/interface/MET.h"
 #include "DataFormats/PatCandidates/interface/CompositeCandidate.h"
 #include "DataFormats/PatCandidates/interface/Tau.h"
@@ -14,6 +15,7 @@
 #include "DataFormats/PatCandidates/interface/Muon.h"
 
 #include "CMGTools/SVfitStandalone/interface/SVfitStandaloneAlgorithm.h"
+#include "CMGTools/H2TauTau/interface/SVfitResult.h"
 
 #include <sstream>
 
@@ -31,10 +33,16 @@ public:
 
 private:
   void produce(edm::Event& iEvent, const edm::EventSetup& iSetup);
+  cmg::SVfitResult fit(const DiTauObject& diTau, svFitStandalone::kDecayType leg1type, svFitStandalone::kDecayType leg2type) const;
 
   /// source diobject inputtag
   edm::InputTag diTauSrc_;
 
+  /// "collection": copies of the di-objects with the results as user floats,
+  /// "valueMap": edm::ValueMap<cmg::SVfitResult> on the input collection,
+  /// "vector": std::vector<cmg::SVfitResult> aligned with the input collection
+  std::string outputMode_;
+
   unsigned warningNumbers_;
   bool verbose_;
   int SVFitVersion_;
@@ -49,6 +57,7 @@ private:
 template< typename T, typename U >
 DiTauWithSVFitProducer<T, U>::DiTauWithSVFitProducer(const edm::ParameterSet& iConfig) :
   diTauSrc_(iConfig.getParameter<edm::InputTag>("diTauSrc")),
+  outputMode_(iConfig.getParameter<std::string>("outputMode")),
   warningNumbers_(0),
   verbose_(iConfig.getUntrackedParameter<bool>("verbose", false)),
   SVFitVersion_(iConfig.getParameter<int>("SVFitVersion")),
@@ -61,8 +70,15 @@ DiTauWithSVFitProducer<T, U>::DiTauWithSVFitProducer(const edm::ParameterSet& iC
   inputFile_visPtResolution_ = std::unique_ptr<TFile>(new TFile(inputFileName_visPtResolution.fullPath().data()));
 
   // will produce a collection containing a copy of each di-object in input,
-  // with the SVFit mass set.
-  produces<std::vector<DiTauObject>>();
+  // with the SVFit mass set, or only the fit results.
+  if (outputMode_ == "collection")
+    produces<std::vector<DiTauObject>>();
+  else if (outputMode_ == "valueMap")
+    produces<edm::ValueMap<cmg::SVfitResult>>();
+  else if (outputMode_ == "vector")
+    produces<std::vector<cmg::SVfitResult>>();
+  else
+    throw cms::Exception("DiTauWithSVFitProducer") << "unknown outputMode " << outputMode_ << ", should be collection, valueMap or vector";
   consumes<DiTauCollection>(diTauSrc_);
 }
 
@@ -113,27 +129,16 @@ void DiTauWithSVFitProducer<T, U>::produce(edm::Event& iEvent, const edm::EventS
     warningNumbers_ += 1;
   }
 
-  OutPtr pOut(new DiTauCollection());
+  std::vector<cmg::SVfitResult> results;
+  results.reserve(diTauH->size());
 
   if(verbose_ && !diTauH->empty()) {
     std::cout << "Looping on " << diTauH->size() << " input di-objects:" << std::endl;
   }
 
-  for (auto& diTauOriginal : *diTauH) {
-    DiTauObject diTau(diTauOriginal);
-    const reco::MET& met(dynamic_cast<const reco::MET&>(*diTau.daughter(2)));
-
-    const auto& smsig = met.getSignificanceMatrix();
-
-    TMatrixD tmsig(2, 2);
-    // tmsig.SetMatrixArray(smsig.Array());
-    // Set elements by hand to avoid array gymnastics/assumptions
-    tmsig(0,0) = smsig(0,0);
-    tmsig(0,1) = smsig(0,1);
-    tmsig(1,0) = smsig(1,0);
-    tmsig(1,1) = smsig(1,1);
-
+  for (auto& diTau : *diTauH) {
     if(verbose_) {
+      const reco::MET& met(dynamic_cast<const reco::MET&>(*diTau.daughter(2)));
       std::cout << "  ---------------- " << std::endl;
       std::cout << "\trec boson: " << diTau << std::endl;
       std::cout << "\t\tleg1: " << *diTau.daughter(0) << std::endl;
@@ -141,94 +146,120 @@ void DiTauWithSVFitProducer<T, U>::produce(edm::Event& iEvent, const edm::EventS
       std::cout << "\t\tMET = " << met.et() << ", phi_MET = " << met.phi() << std::endl;
     }
 
-    double massSVFit = 0.;
-    float det = tmsig.Determinant();
-    if(det > 1e-8) {
-      if (SVFitVersion_ >= 1) {
-        //Note that this works only for di-objects where the tau is the leg1 and mu is leg2
-        std::vector<svFitStandalone::MeasuredTauLepton> measuredTauLeptons;
-        int leg1DecayMode = -1;
-        int leg2DecayMode = -1;
-        auto leg2Mass = diTau.daughter(1)->mass();
-        auto leg1Mass = diTau.daughter(0)->mass();
-
-        if (leg1type == svFitStandalone::kTauToHadDecay) {
-          leg1DecayMode = static_cast<pat::Tau*>(diTau.daughter(0))->decayMode();
-        }
-        else if (leg1type == svFitStandalone::kTauToElecDecay)
-        {
-          // Reconstructed GSF electrons have non-fixed mass in CMS
-          leg1Mass = 0.000511;
-        }
-        else if (leg1type == svFitStandalone::kTauToMuDecay)
-        {
-          // Muons may sometimes have the charged pion mass
-          leg1Mass = 0.10566;
-        }
-
-        if (leg2type == svFitStandalone::kTauToHadDecay) {
-          leg2DecayMode = static_cast<pat::Tau*>(diTau.daughter(1))->decayMode();
-        }
-        else if (leg2type == svFitStandalone::kTauToElecDecay)
-        {
-          leg2Mass = 0.000511;
-        }
-        else if (leg2type == svFitStandalone::kTauToMuDecay)
-        {
-          leg2Mass = 0.10566;
-        }
-
-        measuredTauLeptons.push_back(svFitStandalone::MeasuredTauLepton(leg2type, diTau.daughter(1)->pt(), diTau.daughter(1)->eta(), diTau.daughter(1)->phi(), leg2Mass, leg2DecayMode));
-        measuredTauLeptons.push_back(svFitStandalone::MeasuredTauLepton(leg1type, diTau.daughter(0)->pt(), diTau.daughter(0)->eta(), diTau.daughter(0)->phi(), leg1Mass, leg1DecayMode));
-        SVfitStandaloneAlgorithm algo(measuredTauLeptons, met.px(), met.py(), tmsig, 0);
-        algo.addLogM(false);
-        
-        
-        algo.shiftVisPt(integrateOverP4_, &*inputFile_visPtResolution_);
-        
-        if (fitAlgo_ == "VEGAS")
-          algo.integrateVEGAS();
-        else if (fitAlgo_ == "MC")
-          algo.integrateMarkovChain();
-        else
-          algo.integrate();
-
-        massSVFit = algo.mass();
-        diTau.addUserFloat("transverseMass", algo.transverseMass());
-
-        // Add more fit results as user floats
-        diTau.addUserFloat("massUncert", algo.massUncert());
-
-        if (fitAlgo_ == "MC"){
-          diTau.addUserFloat("pt"        , algo.pt()        );
-          diTau.addUserFloat("ptUncert"  , algo.ptUncert()  );
-          diTau.addUserFloat("fittedEta" , algo.eta()       );
-          diTau.addUserFloat("fittedPhi" , algo.phi()       );
-        }
-        else {
-          diTau.addUserFloat("pt"        , -99.);
-          diTau.addUserFloat("ptUncert"  , -99.);
-          diTau.addUserFloat("fittedEta" , -99.);
-          diTau.addUserFloat("fittedPhi" , -99.);
-        }
-
-      }
-    }
-    // This is now handled via the user floats so we can keep the visible mass
-    diTau.addUserFloat("mass", massSVFit);
-
-
-    pOut->push_back(diTau);
+    results.push_back(fit(diTau, leg1type, leg2type));
 
     if(verbose_) {
-      std::cout << "\tm_vis = " << diTau.mass() << ", m_svfit = " << massSVFit << std::endl;
+      std::cout << "\tm_vis = " << diTau.mass() << ", m_svfit = " << results.back().mass << std::endl;
     }
   }
 
-  iEvent.put(pOut);
+  if (outputMode_ == "collection") {
+    OutPtr pOut(new DiTauCollection());
+    pOut->reserve(diTauH->size());
+    for (size_t i = 0; i < diTauH->size(); ++i) {
+      pOut->push_back((*diTauH)[i]);
+      results[i].attach(pOut->back());
+    }
+    iEvent.put(pOut);
+  }
+  else if (outputMode_ == "valueMap") {
+    std::auto_ptr<edm::ValueMap<cmg::SVfitResult>> pOut(new edm::ValueMap<cmg::SVfitResult>());
+    edm::ValueMap<cmg::SVfitResult>::Filler filler(*pOut);
+    filler.insert(diTauH, results.begin(), results.end());
+    filler.fill();
+    iEvent.put(pOut);
+  }
+  else {
+    std::auto_ptr<std::vector<cmg::SVfitResult>> pOut(new std::vector<cmg::SVfitResult>());
+    pOut->swap(results);
+    iEvent.put(pOut);
+  }
 
   if(verbose_ && !diTauH->empty()) {
     std::cout << "DiTauWithSVFitProducer done" << std::endl;
     std::cout << "***" << std::endl;
   }
 }
+
+
+template<typename T, typename U>
+cmg::SVfitResult DiTauWithSVFitProducer<T, U>::fit(const DiTauObject& diTau, svFitStandalone::kDecayType leg1type, svFitStandalone::kDecayType leg2type) const {
+
+  cmg::SVfitResult result;
+
+  const reco::MET& met(dynamic_cast<const reco::MET&>(*diTau.daughter(2)));
+
+  const auto& smsig = met.getSignificanceMatrix();
+
+  // Set elements by hand to avoid array gymnastics/assumptions
+  svFitStandalone::CovMatrix covMET;
+  covMET(0,0) = smsig(0,0);
+  covMET(0,1) = smsig(0,1);
+  covMET(1,1) = smsig(1,1);
+
+  float det = smsig(0,0)*smsig(1,1) - smsig(0,1)*smsig(1,0);
+  if(det > 1e-8) {
+    if (SVFitVersion_ >= 1) {
+      //Note that this works only for di-objects where the tau is the leg1 and mu is leg2
+      std::vector<svFitStandalone::MeasuredTauLepton> measuredTauLeptons;
+      int leg1DecayMode = -1;
+      int leg2DecayMode = -1;
+      auto leg2Mass = diTau.daughter(1)->mass();
+      auto leg1Mass = diTau.daughter(0)->mass();
+
+      if (leg1type == svFitStandalone::kTauToHadDecay) {
+        leg1DecayMode = static_cast<const pat::Tau*>(diTau.daughter(0))->decayMode();
+      }
+      else if (leg1type == svFitStandalone::kTauToElecDecay)
+      {
+        // Reconstructed GSF electrons have non-fixed mass in CMS
+        leg1Mass = 0.000511;
+      }
+      else if (leg1type == svFitStandalone::kTauToMuDecay)
+      {
+        // Muons may sometimes have the charged pion mass
+        leg1Mass = 0.10566;
+      }
+
+      if (leg2type == svFitStandalone::kTauToHadDecay) {
+        leg2DecayMode = static_cast<const pat::Tau*>(diTau.daughter(1))->decayMode();
+      }
+      else if (leg2type == svFitStandalone::kTauToElecDecay)
+      {
+        leg2Mass = 0.000511;
+      }
+      else if (leg2type == svFitStandalone::kTauToMuDecay)
+      {
+        leg2Mass = 0.10566;
+      }
+
+      measuredTauLeptons.push_back(svFitStandalone::MeasuredTauLepton(leg2type, diTau.daughter(1)->pt(), diTau.daughter(1)->eta(), diTau.daughter(1)->phi(), leg2Mass, leg2DecayMode));
+      measuredTauLeptons.push_back(svFitStandalone::MeasuredTauLepton(leg1type, diTau.daughter(0)->pt(), diTau.daughter(0)->eta(), diTau.daughter(0)->phi(), leg1Mass, leg1DecayMode));
+      SVfitStandaloneAlgorithm algo(measuredTauLeptons, met.px(), met.py(), covMET, 0);
+      algo.addLogM(false);
+
+      algo.shiftVisPt(integrateOverP4_, &*inputFile_visPtResolution_);
+
+      if (fitAlgo_ == "VEGAS")
+        algo.integrateVEGAS();
+      else if (fitAlgo_ == "MC")
+        algo.integrateMarkovChain();
+      else
+        algo.integrate();
+
+      result.fitted = true;
+      result.mass = algo.mass();
+      result.transverseMass = algo.transverseMass();
+      result.massUncert = algo.massUncert();
+
+      if (fitAlgo_ == "MC"){
+        result.pt         = algo.pt();
+        result.ptUncert   = algo.ptUncert();
+        result.fittedEta  = algo.eta();
+        result.fittedPhi  = algo.phi();
+      }
+    }
+  }
+
+  return result;
+}
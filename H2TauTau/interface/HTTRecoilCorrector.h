@@ -5,17 +5,27 @@
 #include <TRandom.h>
 #include <TMath.h>
 #include <assert.h>
+#include <cstddef>
 #include <utility>
+#include <vector>
+
+#include "CMGTools/RootTools/interface/CalibrationPayload.h"
 
 class HTTRecoilCorrector {
-  
+
  public:
+  // fileName is relative to $CMSSW_BASE/src and is either the ROOT file
+  // with the recoil fits or a payload made by WritePayload
   HTTRecoilCorrector(TString fileName);
   ~HTTRecoilCorrector();
 
+  // Compile the ROOT file with the recoil fits into a binary payload,
+  // with the response functions tabulated and their moments precomputed
+  static void WritePayload(TString rootFileName, TString payloadFileName);
+
   void Correct(float MetPx,
 	       float MetPy,
-	       float genZPx, 
+	       float genZPx,
 	       float genZPy,
 	       float diLepPx,
 	       float diLepPy,
@@ -25,7 +35,7 @@ class HTTRecoilCorrector {
 
   void CorrectByMeanResolution(float MetPx,
              float MetPy,
-             float genZPx, 
+             float genZPx,
              float genZPy,
              float diLepPx,
              float diLepPy,
@@ -35,7 +45,7 @@ class HTTRecoilCorrector {
 
   std::pair<float, float> Correct(float MetPx,
          float MetPy,
-         float genZPx, 
+         float genZPx,
          float genZPy,
          float diLepPx,
          float diLepPy,
@@ -48,7 +58,7 @@ class HTTRecoilCorrector {
 
     std::pair<float, float> CorrectByMeanResolution(float MetPx,
          float MetPy,
-         float genZPx, 
+         float genZPx,
          float genZPy,
          float diLepPx,
          float diLepPy,
@@ -58,49 +68,62 @@ class HTTRecoilCorrector {
     CorrectByMeanResolution(MetPx, MetPy, genZPx, genZPy, diLepPx, diLepPy, njets, px, py);
     return std::make_pair(px, py);
   }
-  
+
+  // Batch versions over n events: all input arrays have length n,
+  // MetCorrPx and MetCorrPy are filled with the corrected MET.
+  // The category lookup is done once per event up front and the
+  // kinematics is evaluated in closed form, so the rotations vectorize.
+  void Correct(const float * MetPx,
+	       const float * MetPy,
+	       const float * genZPx,
+	       const float * genZPy,
+	       const float * diLepPx,
+	       const float * diLepPy,
+	       const int * njets,
+	       size_t n,
+	       float * MetCorrPx,
+	       float * MetCorrPy);
+
+  void CorrectByMeanResolution(const float * MetPx,
+	       const float * MetPy,
+	       const float * genZPx,
+	       const float * genZPy,
+	       const float * diLepPx,
+	       const float * diLepPy,
+	       const int * njets,
+	       size_t n,
+	       float * MetCorrPx,
+	       float * MetCorrPy);
+
  private:
 
-  int binNumber(float x, const std::vector<float> bins) const
+  HTTRecoilCorrector(const HTTRecoilCorrector &);
+  HTTRecoilCorrector & operator=(const HTTRecoilCorrector &);
+
+  // one recoil component (U1 or U2, data or MC) in one (Z pt, njets) category
+  struct RecoilShape {
+    cmg::PayloadFunction func;
+    float xmin;
+    float xmax;
+    float mean;
+    float rms;
+  };
+
+  int binNumber(float x, const std::vector<float>& bins) const
   {
-    for (size_t iB=0; iB<bins.size(); ++iB)
+    for (size_t iB=0; iB+1<bins.size(); ++iB)
       if (x>=bins[iB]&&x<bins[iB+1])
 	return iB;
     return 0;
   }
 
-  int binNumber(float x, int nbins, const float * bins) {
-
-    int binN = 0;
-
-    for (int iB=0; iB<nbins; ++iB) {
-      if (x>=bins[iB]&&x<bins[iB+1]) {
-	binN = iB;
-	break;
-      }
-    }
-    
-    return binN;
-
-  }
-
   TString _fileName;
 
-  void InitMEtWeights(TFile * file,
-		      TString  _perpZStr,
-		      TString  _paralZStr,
-		      int nZPtBins,
-		      float * ZPtBins,
-		      TString * _ZPtStr,
-		      int nJetsBins,
-		      TString * _nJetsStr);
-
-  void InitMEtWeights(TFile * file,
-		      const std::vector<float>& ZPtBins,
-		      const std::string _perpZStr,
-		      const std::string _paralZStr,
-		      const std::vector<std::string>& _ZPtStr,
-		      const std::vector<std::string>& _nJetsStr);
+  static void FillPayload(TFile * file,
+			  const TString & fileName,
+			  cmg::CalibrationPayloadWriter & writer);
+
+  void InitMEtWeights(const cmg::CalibrationPayload & payload);
 
   void CalculateU1U2FromMet(float MetPx,
 			    float MetPy,
@@ -126,73 +149,71 @@ class HTTRecoilCorrector {
 			       int nZptBin,
 			       int njets);
 
-  float CorrectionsBySampling(float x, TF1 * funcMC, TF1 * funcData);
+  void  U1U2CorrectionsBySampling(float & U1, float & U2,
+				  int ZptBin,
+				  int njets);
+
+  float CorrectionsBySampling(float x, const RecoilShape & shapeMC, const RecoilShape & shapeData);
+
+  // flat index ZptBin*_nJetsBins+njets of the (Z pt, njets) category
+  void  CategoryIndices(const float * genZPx,
+			const float * genZPy,
+			const int * njets,
+			size_t n,
+			int * ZptBin,
+			int * jetBin) const;
+
+  void  U1U2FromMetBatch(const float * metPx,
+			 const float * metPy,
+			 const float * genZPx,
+			 const float * genZPy,
+			 const float * diLepPx,
+			 const float * diLepPy,
+			 size_t n,
+			 float * U1,
+			 float * U2) const;
+
+  void  MetFromU1U2Batch(const float * U1,
+			 const float * U2,
+			 const float * genZPx,
+			 const float * genZPy,
+			 const float * diLepPx,
+			 const float * diLepPy,
+			 size_t n,
+			 float * metPx,
+			 float * metPy) const;
 
   float rescale(float x,
-		float meanData, 
+		float meanData,
 		float meanMC,
 		float resolutionData,
 		float resolutionMC);
-    
 
-  //float * _ZPtBins;
+
+  cmg::CalibrationPayload * _payload;
+
   std::vector<float> _ZPtBins;
 
-  Double_t 	_epsrel;
-  Double_t 	_epsabs;
-  Double_t   	_error;
   float _range;
 
   int _nZPtBins;
   int _nJetsBins;
 
-  TF1 * _metZParalData[5][3];
-  TF1 * _metZPerpData[5][3];
-  TF1 * _metZParalMC[5][3];
-  TF1 * _metZPerpMC[5][3];
-
-  TH1F * _metZParalDataHist[5][3];
-  TH1F * _metZPerpDataHist[5][3];
-  TH1F * _metZParalMCHist[5][3];
-  TH1F * _metZPerpMCHist[5][3];
-
-  float _meanMetZParalData[5][3];
-  float _meanMetZParalMC[5][3];
-  float _meanMetZPerpData[5][3];
-  float _meanMetZPerpMC[5][3];
-  
-  float _rmsMetZParalData[5][3];
-  float _rmsLeftMetZParalData[5][3];
-  float _rmsRightMetZParalData[5][3];
-  
-  float _rmsMetZParalMC[5][3];
-  float _rmsLeftMetZParalMC[5][3];
-  float _rmsRightMetZParalMC[5][3];
-
-  float _rmsMetZPerpData[5][3];
-  float _rmsLeftMetZPerpData[5][3];
-  float _rmsRightMetZPerpData[5][3];
-  
-  float _rmsMetZPerpMC[5][3];
-  float _rmsLeftMetZPerpMC[5][3];
-  float _rmsRightMetZPerpMC[5][3];
-  
-  float _xminMetZPerp[5][3];
-  float _xmaxMetZPerp[5][3];
-
-  float _xminMetZPerpData[5][3];
-  float _xmaxMetZPerpData[5][3];
-
-  float _xminMetZPerpMC[5][3];
-  float _xmaxMetZPerpMC[5][3];
-
-  float _xminMetZParal[5][3];
-  float _xmaxMetZParal[5][3];
-
-  float _xminMetZParalData[5][3];
-  float _xmaxMetZParalData[5][3];
-
-  float _xminMetZParalMC[5][3];
-  float _xmaxMetZParalMC[5][3];
+  // indexed by ZPtBin*_nJetsBins+jetBin
+  std::vector<RecoilShape> _metZParalData;
+  std::vector<RecoilShape> _metZPerpData;
+  std::vector<RecoilShape> _metZParalMC;
+  std::vector<RecoilShape> _metZPerpMC;
+
+  std::vector<float> _xminMetZParal;
+  std::vector<float> _xmaxMetZParal;
+  std::vector<float> _xminMetZPerp;
+  std::vector<float> _xmaxMetZPerp;
+
+  // linear coefficients of U1U2CorrectionsByWidth per flat category index:
+  // U1 -> _offsetU1 + _scaleU1*U1, U2 -> _scaleU2*U2
+  std::vector<float> _offsetU1;
+  std::vector<float> _scaleU1;
+  std::vector<float> _scaleU2;
 
 };
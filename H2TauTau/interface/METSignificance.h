@@ -2,36 +2,58 @@
 #define METSignificance_H_
 
 /*
-Class to just encapsulate a 2x2 TMatrixD to put into edm Event
+Class to just encapsulate the 2x2 MET covariance matrix to put into edm Event
 */
 
 #include <TMatrixD.h>
+#include <Math/SMatrix.h>
 
 namespace cmg
 {
-  
+
   class METSignificance{
   public:
-    
-    METSignificance():
-      significance_(TMatrixD(2,2))
+
+    typedef ROOT::Math::SMatrix<double,2,2,ROOT::Math::MatRepSym<double,2> > Matrix;
+
+    METSignificance()
     {
     }
 
-    METSignificance(const TMatrixD & matrix):
-      significance_(TMatrixD(2,2))
+    METSignificance(const Matrix & matrix):
+      significance_(matrix)
     {
-      significance_ = matrix;
+    }
+
+    // the off-diagonal elements of the TMatrixD are averaged
+    METSignificance(const TMatrixD & matrix)
+    {
+      significance_(0,0) = matrix(0,0);
+      significance_(0,1) = 0.5*(matrix(0,1) + matrix(1,0));
+      significance_(1,1) = matrix(1,1);
     }
 
     virtual ~METSignificance(){
     }
-    
-    const TMatrixD& significance() const {return significance_;}
+
+    const Matrix& matrix() const {return significance_;}
+
+    // copy as a TMatrixD, for the code still using that interface
+    TMatrixD significance() const {
+      TMatrixD result(2,2);
+      result(0,0) = significance_(0,0);
+      result(0,1) = significance_(0,1);
+      result(1,0) = significance_(1,0);
+      result(1,1) = significance_(1,1);
+      return result;
+    }
 
   private:
 
-    TMatrixD significance_;
+    // was a TMatrixD: there is no schema evolution rule, so cmgMETSignificances
+    // written before the change cannot be read back; the dictionary of the
+    // matrix comes from DataFormats/Math
+    Matrix significance_;
 
   };
 
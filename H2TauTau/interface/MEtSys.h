@@ -5,12 +5,21 @@
 #include <TRandom.h>
 #include <TMath.h>
 #include <assert.h>
+#include <cstddef>
+#include <vector>
+
+#include "CMGTools/RootTools/interface/CalibrationPayload.h"
 
 class MEtSys {
   
  public:
+  // fileName is relative to $CMSSW_BASE/src and is either the ROOT file
+  // with the response histograms or a payload made by WritePayload
   MEtSys(TString fileName);
-  ~MEtSys(){};
+  ~MEtSys();
+
+  // Compile the ROOT file with the response histograms into a binary payload
+  static void WritePayload(TString rootFileName, TString payloadFileName);
 
   void ShiftMEt(float metPx,
 		float metPy,
@@ -50,11 +59,35 @@ class MEtSys {
 			  float & metShiftPx,
 			  float & metShiftPy);
 
+  // Batch version over n events: all input arrays have length n, the
+  // shifted MET is written to metShiftPx/metShiftPy. The response lookup
+  // is done in a first pass, the recoil rotation in a vectorizable second one.
+  void ShiftMEt(const float * metPx,
+		const float * metPy,
+		const float * genVPx,
+		const float * genVPy,
+		const float * visVPx,
+		const float * visVPy,
+		const int * njets,
+		size_t n,
+		int bkgdType,
+		int sysType,
+		float sysShift,
+		float * metShiftPx,
+		float * metShiftPy);
+
   enum BkgdType{EWK=0, TOP=1};
   enum SysType{Response=0, Resolution=1};
 
  private:
 
+  MEtSys(const MEtSys &);
+  MEtSys & operator=(const MEtSys &);
+
+  static void FillPayload(TFile * file,
+			  const TString & fileName,
+			  cmg::CalibrationPayloadWriter & writer);
+
   void ComputeHadRecoilFromMet(float metX,
 			       float metY,
 			       float genVPx, 
@@ -75,9 +108,12 @@ class MEtSys {
 			       float & metY);
   
   
+  cmg::CalibrationPayload * payload;
+
   int nBkgdTypes;
   int nJetBins;
-  TH1D * responseHist[2][5];
+  // indexed by bkgdType*nJetBins+njets
+  std::vector<cmg::PayloadHistogram> responseHist;
 
 
 };
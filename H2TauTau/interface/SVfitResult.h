@@ -0,0 +1,52 @@
+#ifndef SVFITRESULT_H_
+#define SVFITRESULT_H_
+
+/*
+SVfit result for one di-object, as written by DiTauWithSVFitProducer in the
+valueMap and vector output modes instead of a copy of the di-object with
+user floats. attach() adds the same user floats as the collection output
+mode to a di-object, for code that still needs them.
+*/
+
+#include "DataFormats/PatCandidates/interface/CompositeCandidate.h"
+
+namespace cmg
+{
+
+  struct SVfitResult{
+
+    SVfitResult():
+      fitted(false), mass(0.), massUncert(0.), transverseMass(0.),
+      pt(-99.), ptUncert(-99.), fittedEta(-99.), fittedPhi(-99.)
+    {
+    }
+
+    // adds "mass" and, if the fit was run, "transverseMass", "massUncert",
+    // "pt", "ptUncert", "fittedEta" and "fittedPhi"
+    void attach(pat::CompositeCandidate& diTau) const {
+      if (fitted) {
+        diTau.addUserFloat("transverseMass", transverseMass);
+        diTau.addUserFloat("massUncert", massUncert);
+        diTau.addUserFloat("pt"        , pt        );
+        diTau.addUserFloat("ptUncert"  , ptUncert  );
+        diTau.addUserFloat("fittedEta" , fittedEta );
+        diTau.addUserFloat("fittedPhi" , fittedPhi );
+      }
+      diTau.addUserFloat("mass", mass);
+    }
+
+    // false if the fit was not run (singular MET covariance), only mass is then set
+    bool fitted;
+    float mass;
+    float massUncert;
+    float transverseMass;
+    // -99 unless the fit is run with the MC algorithm
+    float pt;
+    float ptUncert;
+    float fittedEta;
+    float fittedPhi;
+  };
+
+}
+
+#endif /*SVFITRESULT_H_*/
@@ -4,6 +4,9 @@
 #include <math.h> 
 #include "TMath.h" 
 #include <limits>
+#include <map>
+#include <string>
+#include <vector>
 #include <TH1.h> 
 
 
@@ -17,6 +20,34 @@ public:
   TH1* chi2FunctorHisto;  
   float xmin_; float xmax_;
 
+  ////Batch fitting of many turn-on curves, one job per histogram
+  struct FitJob {
+    FitJob() : xmin(0.), xmax(0.) {}
+    FitJob(const std::string& n, const std::string& f, const std::string& h="efficiency", float lo=0., float hi=0.) :
+      name(n), fileName(f), histName(h), xmin(lo), xmax(hi) {}
+    std::string name;      // key of the curve in the parameter table
+    std::string fileName;
+    std::string histName;
+    float xmin; float xmax;  // fit range in bin centres, 0 for no limit
+  };
+  struct FitResult {
+    std::string name;
+    double par[5];         // m0, sigma, alpha, n, norm as in efficiency()
+    double err[5];
+    double chi2;
+    int ndf;
+    int status;            // minimizer status, -1 if the histogram was not found
+  };
+  //Fits the jobs concurrently on nThreads threads (0: one per core), with the
+  //analytic gradient of the turn-on; same starting point and chi2 as fitEfficiency
+  static std::vector<FitResult> fitEfficiencies(const std::vector<FitJob>& jobs, unsigned int nThreads=0);
+  //Parameter table, one line per fitted curve: name, the five parameters,
+  //their errors, chi2, ndf, status
+  static bool writeParameters(const char* filename, const std::vector<FitResult>& results);
+  bool loadParameters(const char* filename);
+  bool hasParameters(const std::string& name) const { return fitted_.find(name)!=fitted_.end(); }
+  double effFitted(const std::string& name, double pt) const;
+
 
   //trigger lumi weighting done according to this table from:
   //https://twiki.cern.ch/twiki/bin/viewauth/CMS/HToTauTauPlusTwoJets
@@ -1178,6 +1209,9 @@ private:
 
   //function definition taken from AN-11-390 v4
   double efficiency(double m, double m0, double sigma, double alpha,double n, double norm) const;
+
+  //curves read by loadParameters, (m0, sigma, alpha, n, norm) by name
+  std::map<std::string, std::vector<double> > fitted_;
 } ;
 #endif 
 
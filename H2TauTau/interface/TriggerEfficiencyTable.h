@@ -0,0 +1,79 @@
+#ifndef CMGTools_H2TauTau_TriggerEfficiencyTable_H
+#define CMGTools_H2TauTau_TriggerEfficiencyTable_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "CMGTools/H2TauTau/interface/TriggerEfficiency.h"
+
+//
+// One of the TriggerEfficiency curves, e.g. effTau2011AB, tabulated in pt
+// for each eta region at construction.
+//
+// The exact curve is sampled, so the lumi weights of the combined curves
+// are folded into a single table. In each pt segment the grid is refined
+// until linear interpolation agrees with the exact curve within half the
+// tolerance at the quarter points of every cell; the cells that still fail
+// at the finest grid (near-step turn-ons) are evaluated exactly. Values of
+// pt outside [1, 1000] GeV and eta exactly on a region boundary are also
+// evaluated exactly, so the boundary conventions of the curves are kept.
+//
+// usage:
+//    TriggerEfficiencyTable tauEff("effTau2011AB");
+//    double w = tauEff(pt, eta);
+//    tauEff.eval(pts, etas, n, weights);
+//
+class TriggerEfficiencyTable {
+ public:
+  typedef double (TriggerEfficiency::*Curve)(double pt, double eta);
+
+  // name is the TriggerEfficiency member function, e.g. "effMu2012AB"
+  TriggerEfficiencyTable(const std::string & name, double tolerance = 1e-5);
+  TriggerEfficiencyTable(Curve curve, double tolerance = 1e-5);
+
+  static bool hasCurve(const std::string & name);
+  static std::vector<std::string> curveNames();
+
+  double eval(double pt, double eta) const;
+  double operator()(double pt, double eta) const { return eval(pt, eta); }
+
+  // eff[i] = eval(pt[i], eta[i]) for i < n
+  void eval(const double * pt, const double * eta, size_t n, double * eff) const;
+
+  double exact(double pt, double eta) const { return (trigEff_.*curve_)(pt, eta); }
+
+  double tolerance() const { return tolerance_; }
+  // number of tabulated points and of cells evaluated exactly, summed over the tables
+  size_t nPoints() const { return values_.size(); }
+  size_t nExactCells() const;
+
+ private:
+  struct Segment {
+    double invStep;
+    unsigned int nCells;
+    unsigned int offset;  // of the first node in values_
+  };
+
+  void build();
+  void buildSegment(double eta, double lo, double hi, Segment & segment);
+  int region(double eta) const;
+  int segment(double pt) const;
+  double lookup(double pt, int table, int seg) const;
+
+  mutable TriggerEfficiency trigEff_;
+  Curve curve_;
+  double tolerance_;
+
+  // pt segment for each half GeV
+  std::vector<unsigned char> ptSegment_;
+  // index of the table used in each eta region, regions with the same curve share it
+  std::vector<int> regionTable_;
+  // indexed by table*nSegments+segment
+  std::vector<Segment> segments_;
+  std::vector<double> values_;
+  // parallel to values_, one flag per cell
+  std::vector<char> exactCell_;
+};
+
+#endif
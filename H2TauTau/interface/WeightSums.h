@@ -0,0 +1,111 @@
+#ifndef WEIGHTSUMS_H_
+#define WEIGHTSUMS_H_
+
+/*
+Sums of the generator weight variations of the events in a run or a
+luminosity block, as written by GenEvtWeightCounter with sumVariations set.
+
+For each variation the sum of the weights, the sum of their squares and the
+number of negative weights are kept. The sums are compensated (Neumaier), the
+compensation terms are stored with them so that merging the products of
+several jobs (mergeProduct, called by the framework when runs or lumis from
+different files are merged) stays as precise as a single long job.
+*/
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace cmg
+{
+
+  class WeightSums{
+  public:
+
+    WeightSums(): nEvents_(0) {}
+
+    explicit WeightSums(const std::vector<std::string>& names):
+      names_(names),
+      sumW_(names.size(), 0.), sumWComp_(names.size(), 0.),
+      sumW2_(names.size(), 0.), sumW2Comp_(names.size(), 0.),
+      nNegative_(names.size(), 0),
+      nEvents_(0)
+    {
+    }
+
+    // weights[i] is the weight of variation i in this event
+    void add(const std::vector<double>& weights){
+      if (weights.size() != names_.size())
+        throw cms::Exception("WeightSums") << "event has " << weights.size() << " weight variations, expected " << names_.size();
+      for (size_t i = 0; i < weights.size(); ++i) {
+        const double w = weights[i];
+        add(sumW_[i], sumWComp_[i], w);
+        add(sumW2_[i], sumW2Comp_[i], w*w);
+        if (w < 0.)
+          ++nNegative_[i];
+      }
+      ++nEvents_;
+    }
+
+    bool mergeProduct(const WeightSums& other){
+      // lumis and runs without events put an empty product
+      if (other.names_.empty())
+        return true;
+      if (other.names_ != names_) {
+        if (!names_.empty())
+          throw cms::Exception("WeightSums") << "cannot merge sums of different weight variations";
+        *this = other;
+        return true;
+      }
+      for (size_t i = 0; i < names_.size(); ++i) {
+        add(sumW_[i], sumWComp_[i], other.sumW_[i]);
+        add(sumW_[i], sumWComp_[i], other.sumWComp_[i]);
+        add(sumW2_[i], sumW2Comp_[i], other.sumW2_[i]);
+        add(sumW2_[i], sumW2Comp_[i], other.sumW2Comp_[i]);
+        nNegative_[i] += other.nNegative_[i];
+      }
+      nEvents_ += other.nEvents_;
+      return true;
+    }
+
+    size_t size() const {return names_.size();}
+    const std::vector<std::string>& names() const {return names_;}
+    const std::string& name(size_t i) const {return names_[i];}
+    // index of the variation called name, size() if there is none
+    size_t index(const std::string& name) const {
+      for (size_t i = 0; i < names_.size(); ++i)
+        if (names_[i] == name) return i;
+      return names_.size();
+    }
+
+    double sumW(size_t i) const {return sumW_[i] + sumWComp_[i];}
+    double sumW2(size_t i) const {return sumW2_[i] + sumW2Comp_[i];}
+    unsigned long long nNegative(size_t i) const {return nNegative_[i];}
+    unsigned long long nEvents() const {return nEvents_;}
+
+  private:
+
+    static void add(double& sum, double& comp, double x){
+      const double t = sum + x;
+      if (std::abs(sum) >= std::abs(x))
+        comp += (sum - t) + x;
+      else
+        comp += (x - t) + sum;
+      sum = t;
+    }
+
+    std::vector<std::string> names_;
+    std::vector<double> sumW_;
+    std::vector<double> sumWComp_;
+    std::vector<double> sumW2_;
+    std::vector<double> sumW2Comp_;
+    std::vector<unsigned long long> nNegative_;
+    unsigned long long nEvents_;
+
+  };
+
+}
+
+#endif /*WEIGHTSUMS_H_*/
@@ -8,6 +8,7 @@ DEFINE_FWK_MODULE(TauEleWithSVFitProducer);
 DEFINE_FWK_MODULE(MuEleWithSVFitProducer); 
 DEFINE_FWK_MODULE(TauTauWithSVFitProducer); 
 DEFINE_FWK_MODULE(DiMuWithSVFitProducer); 
+DEFINE_FWK_MODULE(DiTauSVfitAttacher);
 
 DEFINE_FWK_MODULE(TauMuPOProducer);
 DEFINE_FWK_MODULE(TauElePOProducer);
@@ -20,3 +21,9 @@ DEFINE_FWK_MODULE(TauEleUpdateProducer);
 DEFINE_FWK_MODULE(MuEleUpdateProducer);
 DEFINE_FWK_MODULE(DiTauUpdateProducer);
 DEFINE_FWK_MODULE(DiMuUpdateProducer);
+
+DEFINE_FWK_MODULE(TauMuShiftProducer);
+DEFINE_FWK_MODULE(TauEleShiftProducer);
+DEFINE_FWK_MODULE(MuEleShiftProducer);
+DEFINE_FWK_MODULE(DiTauShiftProducer);
+DEFINE_FWK_MODULE(DiMuShiftProducer);
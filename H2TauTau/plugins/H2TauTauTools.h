@@ -1,6 +1,8 @@
 #include "CMGTools/H2TauTau/interface/DiTauWithSVFitProducer.h"
+#include "CMGTools/H2TauTau/interface/DiTauSVfitAttacher.h"
 
 #include "CMGTools/H2TauTau/interface/DiObjectUpdateFactory.h"
+#include "CMGTools/H2TauTau/interface/DiObjectShiftFactory.h"
 #include "CMGTools/H2TauTau/interface/DiTauObjectFactory.h"
 
 
@@ -18,6 +20,12 @@ typedef DiObjectUpdateFactory< pat::Muon, pat::Electron  > MuEleUpdateProducer;
 typedef DiObjectUpdateFactory< pat::Tau, pat::Tau> DiTauUpdateProducer;
 typedef DiObjectUpdateFactory< pat::Muon, pat::Muon > DiMuUpdateProducer;
 
+typedef DiObjectShiftFactory< pat::Tau, pat::Muon > TauMuShiftProducer;
+typedef DiObjectShiftFactory< pat::Tau, pat::Electron > TauEleShiftProducer;
+typedef DiObjectShiftFactory< pat::Muon, pat::Electron  > MuEleShiftProducer;
+typedef DiObjectShiftFactory< pat::Tau, pat::Tau> DiTauShiftProducer;
+typedef DiObjectShiftFactory< pat::Muon, pat::Muon > DiMuShiftProducer;
+
 }
 
 typedef DiTauWithSVFitProducer< pat::Tau, pat::Muon > TauMuWithSVFitProducer;
@@ -96,7 +96,10 @@ def createProcess(runOnMC=True, channel='tau-mu', runSVFit=False,
     if runOnMC:
         process.genEvtWeightsCounter = cms.EDProducer(
             'GenEvtWeightCounter',
-            verbose = cms.untracked.bool(False)
+            verbose = cms.untracked.bool(False),
+            # sums of all the scale/PDF weight variations per run and lumi
+            sumVariations = cms.bool(False),
+            lheSrc = cms.InputTag('externalLHEProducer'),
         )
 
     if numberOfFilesToProcess > 0:
@@ -5,4 +5,6 @@ cmgDiMu = cms.EDProducer(
     leg1Collection=cms.InputTag('muonPreSelectionDiMu'),
     leg2Collection=cms.InputTag('muonPreSelectionDiMu'),
     metCollection=cms.InputTag('mvaMETDiMu'),
+    # references to the legs and MET instead of copies, see cmg::DiTauPair
+    lightweight=cms.bool(False),
     )
@@ -0,0 +1,57 @@
+import FWCore.ParameterSet.Config as cms
+
+# All tau energy scale variations in one module per channel, replacing one
+# *UpdateProducer instance per variation. For each variation a vector of
+# cmg::DiObjectShift (leg scale factors and shifted MET) parallel to the
+# input di-objects is produced with the variation name as instance label;
+# with produceCollections the full shifted collections are produced as well.
+# The shift parameters at the top level are the defaults of the variations.
+
+tauEnergyScaleVariations = cms.VPSet(
+    cms.PSet(name = cms.string('tauUp'), nSigma = cms.double(1.)),
+    cms.PSet(name = cms.string('tauDown'), nSigma = cms.double(-1.)),
+)
+
+diObjectShiftParameters = cms.PSet(
+    genCollection       = cms.InputTag('prunedGenParticles'),
+    uncertainty         = cms.double(0.03), # 2012: 0.03
+    shift1ProngNoPi0    = cms.double(0.),
+    shift1Prong1Pi0     = cms.double(0.), # 2012: 0.012
+    ptDependence1Pi0    = cms.double(0.),
+    shift3Prong         = cms.double(0.), # 2012: 0.012
+    ptDependence3Prong  = cms.double(0.),
+    shiftMet            = cms.bool(True),
+    shiftTaus           = cms.bool(True),
+    produceCollections  = cms.bool(False),
+    variations          = tauEnergyScaleVariations
+)
+
+cmgTauMuShift = cms.EDProducer(
+    "TauMuShiftProducer",
+    diObjectShiftParameters,
+    diObjectCollection  = cms.InputTag('cmgTauMu')
+)
+
+cmgTauEleShift = cms.EDProducer(
+    "TauEleShiftProducer",
+    diObjectShiftParameters,
+    diObjectCollection  = cms.InputTag('cmgTauEle')
+)
+
+cmgMuEleShift = cms.EDProducer(
+    "MuEleShiftProducer",
+    diObjectShiftParameters,
+    diObjectCollection  = cms.InputTag('cmgMuEle')
+)
+
+cmgDiTauShift = cms.EDProducer(
+    "DiTauShiftProducer",
+    diObjectShiftParameters,
+    diObjectCollection  = cms.InputTag('cmgDiTau')
+)
+
+cmgDiMuShift = cms.EDProducer(
+    "DiMuShiftProducer",
+    diObjectShiftParameters,
+    diObjectCollection  = cms.InputTag('cmgDiMu')
+)
@@ -4,5 +4,7 @@ cmgDiTau = cms.EDProducer(
     "DiTauPOProducer",
     leg1Collection = cms.InputTag("tauPreSelectionDiTau"),
     leg2Collection = cms.InputTag("tauPreSelectionDiTau"),
-    metCollection = cms.InputTag('mvaMETDiTau') 
+    metCollection = cms.InputTag('mvaMETDiTau'),
+    # references to the legs and MET instead of copies, see cmg::DiTauPair
+    lightweight = cms.bool(False)
     )
@@ -5,4 +5,6 @@ cmgMuEle = cms.EDProducer(
     leg1Collection=cms.InputTag('muonPreSelectionMuEle'),
     leg2Collection=cms.InputTag('electronPreSelectionMuEle'),
     metCollection=cms.InputTag('mvaMETMuEle'),
+    # references to the legs and MET instead of copies, see cmg::DiTauPair
+    lightweight=cms.bool(False),
     )
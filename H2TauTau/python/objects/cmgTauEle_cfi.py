@@ -5,4 +5,6 @@ cmgTauEle = cms.EDProducer(
     leg1Collection=cms.InputTag('tauPreSelectionTauEle'),
     leg2Collection=cms.InputTag('electronPreSelectionTauEle'),
     metCollection=cms.InputTag('mvaMETTauEle'),
+    # references to the legs and MET instead of copies, see cmg::DiTauPair
+    lightweight=cms.bool(False),
     )
@@ -5,4 +5,6 @@ cmgTauMu = cms.EDProducer(
     leg1Collection=cms.InputTag('tauPreSelectionTauMu'),
     leg2Collection=cms.InputTag('muonPreSelectionTauMu'),
     metCollection=cms.InputTag('mvaMETTauMu'),
+    # references to the legs and MET instead of copies, see cmg::DiTauPair
+    lightweight=cms.bool(False),
     )
@@ -5,6 +5,7 @@ diMuSVFit = cms.EDProducer(
     diTauSrc = cms.InputTag("cmgDiMuTauPtSel"),
     SVFitVersion =  cms.int32(2), # 1 for 2011 version, 2 for new 2012 (slow) version
     fitAlgo = cms.string('MC'),
+    outputMode = cms.string('collection'), # 'valueMap' or 'vector' to write only cmg::SVfitResult
     verbose = cms.untracked.bool(False),
     p4TransferFunctionFile = cms.untracked.string('CMGTools/SVfitStandalone/data/svFitVisMassAndPtResolutionPDF.root'),
     integrateOverP4 = cms.untracked.bool(False),
@@ -0,0 +1,9 @@
+import FWCore.ParameterSet.Config as cms
+
+# copies of the di-objects with the SVfit results as user floats, from an
+# SVFit producer run with outputMode 'valueMap' or 'vector'
+diTauSVfitAttacher = cms.EDProducer(
+    "DiTauSVfitAttacher",
+    diTauSrc = cms.InputTag("cmgTauMuTauPtSel"),
+    svfitSrc = cms.InputTag("tauMuSVFit"),
+    )
@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+'''Compares timing and results of the per-event and the array interfaces
+of HTTRecoilCorrector and MEtSys on randomly generated events.
+
+Usage: benchmarkRecoilCorrector.py [-n nEvents] [-r recoilFile] [-s sysFile]
+'''
+import time
+import numpy as np
+
+import ROOT
+from optparse import OptionParser
+
+ROOT.gSystem.Load('libCMGToolsH2TauTau')
+from ROOT import HTTRecoilCorrector, MEtSys
+
+parser = OptionParser(usage=__doc__)
+parser.add_option('-n', '--nevents', dest='nevents', type='int', default=100000)
+parser.add_option('-r', '--recoil', dest='recoil', default='CMGTools/H2TauTau/data/recoilMvaMEt_76X_newTraining_MG5.root')
+parser.add_option('-s', '--sys', dest='sys', default=None, help='MEtSys input file, skipped if not given')
+(options, args) = parser.parse_args()
+
+def randomEvents(n):
+    rng = np.random.RandomState(12345)
+    gen_pt = rng.exponential(30., n)
+    gen_phi = rng.uniform(-np.pi, np.pi, n)
+    vis_frac = rng.uniform(0.3, 1., n)
+    vis_dphi = rng.normal(0., 0.3, n)
+    met_px = rng.normal(0., 20., n)
+    met_py = rng.normal(0., 20., n)
+    ev = {}
+    ev['metPx'] = met_px.astype(np.float32)
+    ev['metPy'] = met_py.astype(np.float32)
+    ev['genPx'] = (gen_pt*np.cos(gen_phi)).astype(np.float32)
+    ev['genPy'] = (gen_pt*np.sin(gen_phi)).astype(np.float32)
+    ev['visPx'] = (vis_frac*gen_pt*np.cos(gen_phi+vis_dphi)).astype(np.float32)
+    ev['visPy'] = (vis_frac*gen_pt*np.sin(gen_phi+vis_dphi)).astype(np.float32)
+    ev['njets'] = rng.poisson(0.8, n).astype(np.int32)
+    return ev
+
+def report(name, t_single, t_batch, single, batch):
+    dev = max(np.max(np.abs(single[0]-batch[0])), np.max(np.abs(single[1]-batch[1])))
+    print '{:<32} per-event {:8.3f} s   batch {:8.3f} s   speed-up {:6.1f}   max |dMET| {:.2e} GeV'.format(
+        name, t_single, t_batch, t_single/max(t_batch, 1e-9), dev)
+
+def run(name, n, ev, single_call, batch_call):
+    out_single = (np.zeros(n, np.float32), np.zeros(n, np.float32))
+    t0 = time.time()
+    for i in xrange(n):
+        px, py = single_call(i)
+        out_single[0][i] = px
+        out_single[1][i] = py
+    t_single = time.time() - t0
+
+    out_batch = (np.zeros(n, np.float32), np.zeros(n, np.float32))
+    t0 = time.time()
+    batch_call(out_batch)
+    t_batch = time.time() - t0
+    report(name, t_single, t_batch, out_single, out_batch)
+
+ev = randomEvents(options.nevents)
+n = options.nevents
+args = [ev[k] for k in ['metPx', 'metPy', 'genPx', 'genPy', 'visPx', 'visPy']]
+
+rc = HTTRecoilCorrector(options.recoil)
+
+def singleMeanRes(i):
+    res = rc.CorrectByMeanResolution(*([float(a[i]) for a in args] + [int(ev['njets'][i])]))
+    return res.first, res.second
+
+run('CorrectByMeanResolution', n, ev, singleMeanRes,
+    lambda out: rc.CorrectByMeanResolution(*(args + [ev['njets'], n, out[0], out[1]])))
+
+def singleSampling(i):
+    res = rc.Correct(*([float(a[i]) for a in args] + [int(ev['njets'][i])]))
+    return res.first, res.second
+
+run('Correct', n, ev, singleSampling,
+    lambda out: rc.Correct(*(args + [ev['njets'], n, out[0], out[1]])))
+
+if options.sys:
+    sys = MEtSys(options.sys)
+    for sysType, sysName in [(MEtSys.Response, 'Response'), (MEtSys.Resolution, 'Resolution')]:
+        px, py = ROOT.Float(0.), ROOT.Float(0.)
+        def singleSys(i):
+            sys.ShiftMEt(*([float(a[i]) for a in args] + [int(ev['njets'][i]), MEtSys.EWK, sysType, 1.05, px, py]))
+            return px, py
+        run('ShiftMEt ' + sysName, n, ev, singleSys,
+            lambda out: sys.ShiftMEt(*(args + [ev['njets'], n, MEtSys.EWK, sysType, 1.05, out[0], out[1]])))
@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+'''Compares timing and results of the exact TriggerEfficiency curves and
+their TriggerEfficiencyTable on random legs.
+
+Usage: benchmarkTriggerEfficiency.py [-n nLegs] [-t tolerance] [curve1 curve2 ...]
+
+All the curves are checked if none is given.
+'''
+import time
+import numpy as np
+
+import ROOT
+from optparse import OptionParser
+
+ROOT.gSystem.Load('libCMGToolsH2TauTau')
+from ROOT import TriggerEfficiency, TriggerEfficiencyTable
+
+parser = OptionParser(usage=__doc__)
+parser.add_option('-n', '--nlegs', dest='nlegs', type='int', default=100000)
+parser.add_option('-t', '--tolerance', dest='tolerance', type='float', default=1e-5)
+(options, args) = parser.parse_args()
+
+n = options.nlegs
+rng = np.random.RandomState(12345)
+pt = 15. + rng.exponential(25., n)
+eta = rng.uniform(-2.5, 2.5, n)
+
+curves = args if args else list(TriggerEfficiencyTable.curveNames())
+exact = TriggerEfficiency()
+
+t_exact_tot = 0.
+t_table_tot = 0.
+for name in curves:
+    t0 = time.time()
+    table = TriggerEfficiencyTable(name, options.tolerance)
+    t_build = time.time() - t0
+
+    fun = getattr(exact, name)
+    eff_exact = np.zeros(n)
+    t0 = time.time()
+    for i in xrange(n):
+        eff_exact[i] = fun(pt[i], eta[i])
+    t_exact = time.time() - t0
+
+    eff_table = np.zeros(n)
+    t0 = time.time()
+    table.eval(pt, eta, n, eff_table)
+    t_table = time.time() - t0
+
+    t_exact_tot += t_exact
+    t_table_tot += t_table
+    dev = np.max(np.abs(eff_exact - eff_table))
+    flag = '' if dev <= options.tolerance else '   <-- above tolerance'
+    print '{:<40} build {:6.3f} s  points {:6d}  exact cells {:4d}  max |deff| {:.2e}{}'.format(
+        name, t_build, table.nPoints(), table.nExactCells(), dev, flag)
+
+print 'total: exact {:.3f} s  table {:.3f} s  speed-up {:.1f}'.format(
+    t_exact_tot, t_table_tot, t_exact_tot/max(t_table_tot, 1e-9))
@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+'''Fits the crystal-ball turn-on of TriggerEfficiency to many efficiency
+histograms in parallel and writes the parameter table, which can be read
+back with TriggerEfficiency.loadParameters.
+
+Usage: fitTriggerEfficiencies.py [-j nThreads] jobs.txt parameters.txt
+
+Each line of jobs.txt is
+    name file.root [histogram [xmin xmax]]
+with histogram "efficiency" and no fit range by default; # starts a comment.
+'''
+import sys
+import time
+
+import ROOT
+from optparse import OptionParser
+
+ROOT.gSystem.Load('libCMGToolsH2TauTau')
+from ROOT import TriggerEfficiency, std
+
+parser = OptionParser(usage=__doc__)
+parser.add_option('-j', '--threads', dest='threads', type='int', default=0,
+                  help='number of threads, 0 for one per core')
+(options, args) = parser.parse_args()
+if len(args) != 2:
+    parser.print_help()
+    sys.exit(1)
+
+jobs = std.vector(TriggerEfficiency.FitJob)()
+for line in open(args[0]):
+    fields = line.split('#')[0].split()
+    if not fields:
+        continue
+    if len(fields) not in (2, 3, 5):
+        print 'cannot parse job line:', line.strip()
+        sys.exit(1)
+    hist = fields[2] if len(fields) > 2 else 'efficiency'
+    xmin, xmax = (float(fields[3]), float(fields[4])) if len(fields) == 5 else (0., 0.)
+    jobs.push_back(TriggerEfficiency.FitJob(fields[0], fields[1], hist, xmin, xmax))
+
+t0 = time.time()
+results = TriggerEfficiency.fitEfficiencies(jobs, options.threads)
+print 'fitted {} curves in {:.1f} s'.format(jobs.size(), time.time() - t0)
+
+for r in results:
+    if r.status < 0:
+        print '{:<40} histogram not found'.format(r.name)
+    else:
+        print '{:<40} chi2/ndf {:8.2f}/{:<3d} status {}'.format(r.name, r.chi2, r.ndf, r.status)
+
+if not TriggerEfficiency.writeParameters(args[1], results):
+    print 'cannot write', args[1]
+    sys.exit(1)
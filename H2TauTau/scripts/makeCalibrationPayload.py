@@ -0,0 +1,36 @@
+#!/usr/bin/env python
+'''Compiles the ROOT inputs of the recoil and MET systematics correctors
+into flat binary payloads that the correctors mmap at construction.
+
+Usage: makeCalibrationPayload.py <type> <input.root> <output.bin>
+
+where <type> is one of
+  htt     HTTRecoilCorrector (e.g. data/recoilMvaMEt_76X_newTraining_MG5.root)
+  metsys  MEtSys
+  recoil  RecoilCorrector from CMGTools/RootTools
+
+The payload can be passed to the corrector constructor in place of the ROOT file.
+'''
+import sys
+
+import ROOT
+
+if len(sys.argv) != 4 or sys.argv[1] not in ['htt', 'metsys', 'recoil']:
+    print __doc__
+    sys.exit(1)
+
+kind, inFile, outFile = sys.argv[1:]
+
+ROOT.gROOT.SetBatch(True)
+if kind == 'recoil':
+    ROOT.gSystem.Load('libCMGToolsRootTools')
+    ROOT.RecoilCorrector.WritePayload(inFile, outFile)
+else:
+    ROOT.gSystem.Load('libCMGToolsH2TauTau')
+    if kind == 'htt':
+        ROOT.HTTRecoilCorrector.WritePayload(inFile, outFile)
+    else:
+        ROOT.MEtSys.WritePayload(inFile, outFile)
+
+payload = ROOT.cmg.CalibrationPayload(outFile)
+print 'Wrote', outFile, 'with', payload.names().size(), 'objects'
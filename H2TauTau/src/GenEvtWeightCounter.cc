@@ -7,6 +7,11 @@
 
  Description: saves a collection of generator weights at the end of a Run (or at least at each job)
 
+ With sumVariations set, the sums of all the GenEventInfoProduct weights and,
+ if lheSrc is given, of all the LHEEventProduct weights (scale and PDF
+ variations) are also put in each luminosity block and each run as a
+ cmg::WeightSums, with instance label "genWeightVariations".
+
 */
 //
 // Original Author:  Riccardo Manzoni
@@ -18,6 +23,7 @@
 #include <memory>
 #include <iostream>
 #include <string>
+#include <sstream>
 
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/one/EDProducer.h"
@@ -29,9 +35,12 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
+
+#include "CMGTools/H2TauTau/interface/WeightSums.h"
 
 
-class GenEvtWeightCounter : public edm::one::EDProducer<edm::EndRunProducer>{
+class GenEvtWeightCounter : public edm::one::EDProducer<edm::EndRunProducer, edm::EndLuminosityBlockProducer>{
     public:
         explicit GenEvtWeightCounter(const edm::ParameterSet&);
         ~GenEvtWeightCounter();
@@ -42,20 +51,41 @@ class GenEvtWeightCounter : public edm::one::EDProducer<edm::EndRunProducer>{
         virtual void beginRun(edm::Run const&, edm::EventSetup const&); 
         virtual void endRun(edm::Run const&, edm::EventSetup const&); 
         virtual void endRunProduce(edm::Run& iRun, edm::EventSetup const&);
+        virtual void endLuminosityBlockProduce(edm::LuminosityBlock& iLumi, edm::EventSetup const&);
+
+        void sumVariations(const edm::Event& iEvent, const GenEventInfoProduct& genInfo);
                 
         bool verbose_;
+        bool sumVariations_;
+        edm::InputTag lheSrc_;
         std::vector<double> weights_;
         double sumWeights_;
         double sumUnityWeights_;
+
+        // all the weights of the current event, and their names
+        std::vector<double> variations_;
+        std::vector<std::string> variationNames_;
+        cmg::WeightSums lumiSums_;
+        cmg::WeightSums runSums_;
 };
 
 GenEvtWeightCounter::GenEvtWeightCounter(const edm::ParameterSet& iConfig):
-    verbose_  (iConfig.getUntrackedParameter<bool>("verbose", false)), sumWeights_(0.), sumUnityWeights_(0.)
+    verbose_  (iConfig.getUntrackedParameter<bool>("verbose", false)),
+    sumVariations_(iConfig.getParameter<bool>("sumVariations")),
+    lheSrc_   (iConfig.getParameter<edm::InputTag>("lheSrc")),
+    sumWeights_(0.), sumUnityWeights_(0.)
 {
    // produces<std::vector<double>, edm::InRun>("genWeight");
     produces<double, edm::InRun>();
     produces<double, edm::InRun>("sumUnityGenWeights");
     consumes<GenEventInfoProduct>(edm::InputTag("generator"));
+    if (sumVariations_)
+    {
+        produces<cmg::WeightSums, edm::InRun>("genWeightVariations");
+        produces<cmg::WeightSums, edm::InLumi>("genWeightVariations");
+        if (!lheSrc_.label().empty())
+            consumes<LHEEventProduct>(lheSrc_);
+    }
 }
 
 
@@ -98,10 +128,59 @@ GenEvtWeightCounter::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
     }
     
     weights_.push_back(genInfo -> weight());
+
+    if (sumVariations_)
+        sumVariations(iEvent, *genInfo);
     
 }
 
 
+void
+GenEvtWeightCounter::sumVariations(const edm::Event& iEvent, const GenEventInfoProduct& genInfo)
+{
+    const std::vector<double>& genWeights = genInfo.weights();
+    const LHEEventProduct* lheInfo = 0;
+    if (!lheSrc_.label().empty())
+    {
+        edm::Handle<LHEEventProduct> lheInfoHandle;
+        iEvent.getByLabel(lheSrc_, lheInfoHandle);
+        lheInfo = lheInfoHandle.product();
+    }
+
+    variations_.assign(genWeights.begin(), genWeights.end());
+    if (lheInfo)
+        for (std::vector<LHEEventProduct::WGT>::const_iterator iweight  = lheInfo->weights().begin();
+                                                           iweight != lheInfo->weights().end()  ;
+                                                           iweight++)
+            variations_.push_back(iweight->wgt);
+
+    // the names are set by the first event of the luminosity block or run
+    if (lumiSums_.size() == 0 || runSums_.size() == 0)
+    {
+        variationNames_.clear();
+        for (size_t i = 0; i < genWeights.size(); ++i)
+        {
+            std::ostringstream name;
+            name << "gen_" << i;
+            variationNames_.push_back(name.str());
+        }
+        if (lheInfo)
+            for (std::vector<LHEEventProduct::WGT>::const_iterator iweight  = lheInfo->weights().begin();
+                                                               iweight != lheInfo->weights().end()  ;
+                                                               iweight++)
+                variationNames_.push_back("lhe_" + iweight->id);
+
+        if (lumiSums_.size() == 0)
+            lumiSums_ = cmg::WeightSums(variationNames_);
+        if (runSums_.size() == 0)
+            runSums_ = cmg::WeightSums(variationNames_);
+    }
+
+    lumiSums_.add(variations_);
+    runSums_.add(variations_);
+}
+
+
 void
 GenEvtWeightCounter::beginRun(edm::Run const& iRun, edm::EventSetup const& iSetup)
 {
@@ -126,7 +205,25 @@ GenEvtWeightCounter::endRunProduce(edm::Run& iRun, edm::EventSetup const& iSetup
     iRun.put(sumW);
     iRun.put(sumUW, "sumUnityGenWeights");
     sumW.reset();
+
+    if (sumVariations_)
+    {
+        std::auto_ptr<cmg::WeightSums> sums(new cmg::WeightSums(runSums_));
+        iRun.put(sums, "genWeightVariations");
+        runSums_ = cmg::WeightSums();
+    }
     return;
 }
 
+void
+GenEvtWeightCounter::endLuminosityBlockProduce(edm::LuminosityBlock& iLumi, edm::EventSetup const& iSetup)
+{
+    if (sumVariations_)
+    {
+        std::auto_ptr<cmg::WeightSums> sums(new cmg::WeightSums(lumiSums_));
+        iLumi.put(sums, "genWeightVariations");
+        lumiSums_ = cmg::WeightSums();
+    }
+}
+
 DEFINE_FWK_MODULE(GenEvtWeightCounter);
@@ -1,22 +1,80 @@
 #include "CMGTools/H2TauTau/interface/HTTRecoilCorrector.h"
 
-HTTRecoilCorrector::HTTRecoilCorrector(TString fileName) {
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+  // grid points used to tabulate each recoil response function
+  const unsigned int kNPoints = 2000;
+
+  const char * kShapeNames[4] = {"paralData", "perpData", "paralMC", "perpMC"};
+
+  std::string shapeName(const char * shape, int category) {
+    std::stringstream lSS; lSS << shape << "_" << category;
+    return lSS.str();
+  }
+
+}
+
+HTTRecoilCorrector::HTTRecoilCorrector(TString fileName) :
+  _payload(0) {
 
   TString cmsswBase = TString( getenv ("CMSSW_BASE") );
   TString baseDir = cmsswBase + "/src";
 
   _fileName = baseDir+"/"+fileName;
-  TFile * file = new TFile(_fileName);
-  if (file->IsZombie()) {
-    std::cout << "file " << _fileName << " is not found...   quitting " << std::endl;
-    exit(-1);
+
+  if (cmg::CalibrationPayload::isPayload(std::string(_fileName))) {
+    _payload = new cmg::CalibrationPayload(std::string(_fileName));
   }
+  else {
+    TFile * file = new TFile(_fileName);
+    if (file->IsZombie())
+      throw cms::Exception("HTTRecoilCorrector") << "file " << _fileName << " is not found";
+    cmg::CalibrationPayloadWriter writer;
+    FillPayload(file, _fileName, writer);
+    file->Close();
+    delete file;
+    std::vector<char> image = writer.image();
+    _payload = new cmg::CalibrationPayload(image);
+  }
+
+  InitMEtWeights(*_payload);
+
+  _range = 0.95;
+
+}
+
+HTTRecoilCorrector::~HTTRecoilCorrector() {
+
+  delete _payload;
+
+}
+
+void HTTRecoilCorrector::WritePayload(TString rootFileName, TString payloadFileName) {
+
+  TFile * file = new TFile(rootFileName);
+  if (file->IsZombie())
+    throw cms::Exception("HTTRecoilCorrector") << "file " << rootFileName << " is not found";
+  cmg::CalibrationPayloadWriter writer;
+  FillPayload(file, rootFileName, writer);
+  file->Close();
+  delete file;
+  writer.write(std::string(payloadFileName));
+
+}
+
+void HTTRecoilCorrector::FillPayload(TFile * file,
+				     const TString & fileName,
+				     cmg::CalibrationPayloadWriter & writer) {
 
   TH1D * projH = (TH1D*)file->Get("projH");
-  if (projH==NULL) {
-    std::cout << "File should contain histogram with the name projH " << std::endl;
-    std::cout << "Check content of the file " << _fileName << std::endl;
-  }
+  if (projH==NULL)
+    throw cms::Exception("HTTRecoilCorrector") << "File should contain histogram with the name projH, "
+					       << "check content of the file " << fileName;
 
   TString firstBinStr  = projH->GetXaxis()->GetBinLabel(1);
   TString secondBinStr = projH->GetXaxis()->GetBinLabel(2);
@@ -31,184 +89,111 @@ HTTRecoilCorrector::HTTRecoilCorrector(TString fileName) {
   std::cout << "Perpendicular component (U2) : " << perpZStr << std::endl;
 
   TH1D * ZPtBinsH = (TH1D*)file->Get("ZPtBinsH");
-  if (ZPtBinsH==NULL) {
-    std::cout << "File should contain histogram with the name ZPtBinsH " << std::endl;
-    std::cout << "Check content of the file " << _fileName << std::endl;
-    exit(-1);
-  }
+  if (ZPtBinsH==NULL)
+    throw cms::Exception("HTTRecoilCorrector") << "File should contain histogram with the name ZPtBinsH, "
+					       << "check content of the file " << fileName;
   int nZPtBins = ZPtBinsH->GetNbinsX();
-  float ZPtBins[10];
-  TString ZPtStr[10];
+  std::vector<double> ZPtBins;
+  std::vector<TString> ZPtStr;
   for (int i=0; i<=nZPtBins; ++i) {
-    ZPtBins[i] = ZPtBinsH->GetXaxis()->GetBinLowEdge(i+1);
+    ZPtBins.push_back(ZPtBinsH->GetXaxis()->GetBinLowEdge(i+1));
     if (i<nZPtBins)
-      ZPtStr[i] = ZPtBinsH->GetXaxis()->GetBinLabel(i+1);
+      ZPtStr.push_back(ZPtBinsH->GetXaxis()->GetBinLabel(i+1));
   }
 
   TH1D * nJetBinsH = (TH1D*)file->Get("nJetBinsH");
-  if (nJetBinsH==NULL) {
-    std::cout << "File should contain histogram with the name nJetBinsH" << std::endl;
-    std::cout << "Check content of the file " << _fileName << std::endl;
-    exit(-1);
-  }
+  if (nJetBinsH==NULL)
+    throw cms::Exception("HTTRecoilCorrector") << "File should contain histogram with the name nJetBinsH, "
+					       << "check content of the file " << fileName;
   int nJetsBins = nJetBinsH->GetNbinsX();
-  TString nJetsStr[5];
+  std::vector<TString> nJetsStr;
   for (int i=0; i<nJetsBins; ++i) {
-    nJetsStr[i] = nJetBinsH->GetXaxis()->GetBinLabel(i+1);
+    nJetsStr.push_back(nJetBinsH->GetXaxis()->GetBinLabel(i+1));
   }
 
-  InitMEtWeights(file,
-		 perpZStr,
-		 paralZStr,
-		 nZPtBins,
-		 ZPtBins,
-		 ZPtStr,
-		 nJetsBins,
-		 nJetsStr);
-
-  _epsrel = 5e-4;
-  _epsabs = 5e-4;
-  _range = 0.95;
-
-}
+  writer.addScalars("ZPtBins", ZPtBins);
+  writer.addScalars("nJetsBins", std::vector<double>(1, nJetsBins));
+
+  // mean and rms of each shape per category, the perpendicular means are 0 by construction
+  std::vector<double> moments[4];
+
+  for (int ZPtBin=0; ZPtBin<nZPtBins; ++ZPtBin) {
+    for (int jetBin=0; jetBin<nJetsBins; ++jetBin) {
+
+      TString binStr = "_" + nJetsStr[jetBin] + ZPtStr[ZPtBin];
+      TString funcNames[4] = {paralZStr + binStr + "_data",
+			      perpZStr  + binStr + "_data",
+			      paralZStr + binStr + "_mc",
+			      perpZStr  + binStr + "_mc"};
+
+      std::cout << ZPtStr[ZPtBin] << " : " << nJetsStr[jetBin] << std::endl;
+
+      for (int iShape=0; iShape<4; ++iShape) {
+	TF1 * func = (TF1*)file->Get(funcNames[iShape]);
+	if (func==NULL)
+	  throw cms::Exception("HTTRecoilCorrector") << "Function with name " << funcNames[iShape]
+						     << " is not found in file " << fileName;
+	double xminD,xmaxD;
+	func->GetRange(xminD,xmaxD);
+	bool perp = (iShape%2==1);
+	moments[iShape].push_back(perp ? 0. : func->Mean(xminD,xmaxD));
+	moments[iShape].push_back(TMath::Sqrt(func->CentralMoment(2,xminD,xmaxD)));
+	writer.addFunction(shapeName(kShapeNames[iShape], ZPtBin*nJetsBins+jetBin), *func, kNPoints);
+      }
 
-HTTRecoilCorrector::~HTTRecoilCorrector() {
+    }
+  }
 
-}
+  for (int iShape=0; iShape<4; ++iShape)
+    writer.addScalars(std::string(kShapeNames[iShape]) + "_moments", moments[iShape]);
 
-void HTTRecoilCorrector::InitMEtWeights(TFile * _file,
-				     TString  _perpZStr,
-				     TString  _paralZStr,
-				     int nZPtBins,
-				     float * ZPtBins,
-				     TString * _ZPtStr,
-				     int nJetsBins,
-				     TString * _nJetsStr) {
-
-	std::vector<float> newZPtBins;
-	std::vector<std::string> newZPtStr;
-	std::vector<std::string> newNJetsStr;
-
-	std::string newPerpZStr  = std::string(_perpZStr);
-	std::string newParalZStr = std::string(_paralZStr);
-
-	for (int idx=0; idx<nZPtBins+1; ++idx) 
-	  newZPtBins.push_back(ZPtBins[idx]);
-	for (int idx=0; idx<nZPtBins; ++idx ) 
-	  newZPtStr.push_back(std::string(_ZPtStr[idx]));
-
-	for (int idx=0; idx<nJetsBins; ++idx)
-	  newNJetsStr.push_back(std::string(_nJetsStr[idx]));
-
-	InitMEtWeights(_file,
-		       newZPtBins,
-		       newPerpZStr,
-		       newParalZStr,
-		       newZPtStr,
-		       newNJetsStr);
 }
 
-
-void HTTRecoilCorrector::InitMEtWeights(TFile * _fileMet,
-				     const std::vector<float>& ZPtBins,
-				     const std::string _perpZStr,
-				     const std::string _paralZStr,
-				     const std::vector<std::string>& _ZPtStr,
-				     const std::vector<std::string>& _nJetsStr)
+void HTTRecoilCorrector::InitMEtWeights(const cmg::CalibrationPayload & payload)
 {
 
-  // checking files
-  //  if (_fileMet->IsZombie()) {
-  //    std::cout << "File " << _fileName << " is not found in directory " << _baseDir << std::endl;
-  //    std::cout << "quitting program..." << std::endl;
-  //    exit(-1);
-  //  }
-
+  std::vector<double> ZPtBins = payload.scalars("ZPtBins");
+  _ZPtBins.assign(ZPtBins.begin(), ZPtBins.end());
   _nZPtBins = ZPtBins.size()-1; // the -1 is on purpose!
-  _nJetsBins = _nJetsStr.size();
-  
-  _ZPtBins = ZPtBins;
-
-  for (int ZPtBin=0; ZPtBin<_nZPtBins; ++ZPtBin) {
-    for (int jetBin=0; jetBin<_nJetsBins; ++jetBin) {
-
-      TString binStrPerpData  = _perpZStr  + "_" + _nJetsStr[jetBin] + _ZPtStr[ZPtBin] + "_data";
-      TString binStrParalData = _paralZStr + "_" + _nJetsStr[jetBin] + _ZPtStr[ZPtBin] + "_data";
-      TString binStrPerpMC    = _perpZStr  + "_" + _nJetsStr[jetBin] + _ZPtStr[ZPtBin] + "_mc";
-      TString binStrParalMC   = _paralZStr + "_" + _nJetsStr[jetBin] + _ZPtStr[ZPtBin] + "_mc";
-
-      _metZParalData[ZPtBin][jetBin] = (TF1*)_fileMet->Get(binStrParalData);
-      _metZPerpData[ZPtBin][jetBin]  = (TF1*)_fileMet->Get(binStrPerpData);
-      _metZParalMC[ZPtBin][jetBin]   = (TF1*)_fileMet->Get(binStrParalMC);
-      _metZPerpMC[ZPtBin][jetBin]    = (TF1*)_fileMet->Get(binStrPerpMC);
-
-
-
-      // checking functions
-      if (_metZParalData[ZPtBin][jetBin]==NULL) {
-	std::cout << "Function with name " << binStrParalData
-		  << " is not found in file " << _fileName << "... quitting program..." << std::endl;
-	exit(-1);
-
-      }
-      if (_metZPerpData[ZPtBin][jetBin]==NULL) {
-	std::cout << "Function with name " << binStrPerpData
-		  << " is not found in file " << _fileName << "... quitting program..." << std::endl;
-	exit(-1);
-	
-      }
-
-      if (_metZParalMC[ZPtBin][jetBin]==NULL) {
-	std::cout << "Function with name " << binStrParalMC
-		  << " is not found in file " << _fileName << "... quitting program..." << std::endl;
-	exit(-1);
-
-      }
-      if (_metZPerpMC[ZPtBin][jetBin]==NULL) {
-	std::cout << "Function with name " << binStrPerpMC
-		  << " is not found in file " << _fileName << "... quitting program..." << std::endl;
-	exit(-1);
-	
-      }
-
-      std::cout << _ZPtStr[ZPtBin] << " : " << _nJetsStr[jetBin] << std::endl;
-      
-      double xminD,xmaxD;
-
-      _metZParalData[ZPtBin][jetBin]->GetRange(xminD,xmaxD);
-      _xminMetZParalData[ZPtBin][jetBin] = float(xminD);
-      _xmaxMetZParalData[ZPtBin][jetBin] = float(xmaxD);
-
-      _metZPerpData[ZPtBin][jetBin]->GetRange(xminD,xmaxD);
-      _xminMetZPerpData[ZPtBin][jetBin] = float(xminD);
-      _xmaxMetZPerpData[ZPtBin][jetBin] = float(xmaxD);
-
-      _metZParalMC[ZPtBin][jetBin]->GetRange(xminD,xmaxD);
-      _xminMetZParalMC[ZPtBin][jetBin] = float(xminD);
-      _xmaxMetZParalMC[ZPtBin][jetBin] = float(xmaxD);
-
-      _metZPerpMC[ZPtBin][jetBin]->GetRange(xminD,xmaxD);
-      _xminMetZPerpMC[ZPtBin][jetBin] = float(xminD);
-      _xmaxMetZPerpMC[ZPtBin][jetBin] = float(xmaxD);
-
-      _xminMetZParal[ZPtBin][jetBin] = TMath::Max(_xminMetZParalData[ZPtBin][jetBin],_xminMetZParalMC[ZPtBin][jetBin]);
-      _xmaxMetZParal[ZPtBin][jetBin] = TMath::Min(_xmaxMetZParalData[ZPtBin][jetBin],_xmaxMetZParalMC[ZPtBin][jetBin]);
+  _nJetsBins = int(payload.scalars("nJetsBins").at(0));
+
+  int nCategories = _nZPtBins*_nJetsBins;
+  std::vector<RecoilShape> * shapes[4] = {&_metZParalData, &_metZPerpData, &_metZParalMC, &_metZPerpMC};
+
+  for (int iShape=0; iShape<4; ++iShape) {
+    std::vector<double> moments = payload.scalars(std::string(kShapeNames[iShape]) + "_moments");
+    if (int(moments.size())!=2*nCategories)
+      throw cms::Exception("HTTRecoilCorrector") << "inconsistent number of categories for " << kShapeNames[iShape]
+						 << " in " << _fileName;
+    shapes[iShape]->resize(nCategories);
+    for (int iCat=0; iCat<nCategories; ++iCat) {
+      RecoilShape & shape = (*shapes[iShape])[iCat];
+      shape.func = payload.function(shapeName(kShapeNames[iShape], iCat));
+      shape.xmin = float(shape.func.xmin());
+      shape.xmax = float(shape.func.xmax());
+      shape.mean = float(moments[2*iCat]);
+      shape.rms  = float(moments[2*iCat+1]);
+    }
+  }
 
-      _xminMetZPerp[ZPtBin][jetBin] = TMath::Max(_xminMetZPerpData[ZPtBin][jetBin],_xminMetZPerpMC[ZPtBin][jetBin]);
-      _xmaxMetZPerp[ZPtBin][jetBin] = TMath::Min(_xmaxMetZPerpData[ZPtBin][jetBin],_xmaxMetZPerpMC[ZPtBin][jetBin]);
-      
-      _meanMetZParalData[ZPtBin][jetBin] = _metZParalData[ZPtBin][jetBin]->Mean(_xminMetZParalData[ZPtBin][jetBin],_xmaxMetZParalData[ZPtBin][jetBin]);
-      _rmsMetZParalData[ZPtBin][jetBin] = TMath::Sqrt(_metZParalData[ZPtBin][jetBin]->CentralMoment(2,_xminMetZParalData[ZPtBin][jetBin],_xmaxMetZParalData[ZPtBin][jetBin]));
-      _meanMetZPerpData[ZPtBin][jetBin] = 0;
-      _rmsMetZPerpData[ZPtBin][jetBin] = TMath::Sqrt(_metZPerpData[ZPtBin][jetBin]->CentralMoment(2,_xminMetZPerpData[ZPtBin][jetBin],_xmaxMetZPerpData[ZPtBin][jetBin]));
+  _xminMetZParal.resize(nCategories);
+  _xmaxMetZParal.resize(nCategories);
+  _xminMetZPerp.resize(nCategories);
+  _xmaxMetZPerp.resize(nCategories);
+  _offsetU1.resize(nCategories);
+  _scaleU1.resize(nCategories);
+  _scaleU2.resize(nCategories);
 
-      _meanMetZParalMC[ZPtBin][jetBin] = _metZParalMC[ZPtBin][jetBin]->Mean(_xminMetZParalMC[ZPtBin][jetBin],_xmaxMetZParalMC[ZPtBin][jetBin]);
-      _rmsMetZParalMC[ZPtBin][jetBin] = TMath::Sqrt(_metZParalMC[ZPtBin][jetBin]->CentralMoment(2,_xminMetZParalMC[ZPtBin][jetBin],_xmaxMetZParalMC[ZPtBin][jetBin]));
-      _meanMetZPerpMC[ZPtBin][jetBin] = 0;
-      _rmsMetZPerpMC[ZPtBin][jetBin] = TMath::Sqrt(_metZPerpMC[ZPtBin][jetBin]->CentralMoment(2,_xminMetZPerpMC[ZPtBin][jetBin],_xmaxMetZPerpMC[ZPtBin][jetBin]));
+  for (int iCat=0; iCat<nCategories; ++iCat) {
+    _xminMetZParal[iCat] = TMath::Max(_metZParalData[iCat].xmin,_metZParalMC[iCat].xmin);
+    _xmaxMetZParal[iCat] = TMath::Min(_metZParalData[iCat].xmax,_metZParalMC[iCat].xmax);
 
+    _xminMetZPerp[iCat] = TMath::Max(_metZPerpData[iCat].xmin,_metZPerpMC[iCat].xmin);
+    _xmaxMetZPerp[iCat] = TMath::Min(_metZPerpData[iCat].xmax,_metZPerpMC[iCat].xmax);
 
-    }
+    _scaleU1[iCat] = _metZParalData[iCat].rms/_metZParalMC[iCat].rms;
+    _offsetU1[iCat] = _metZParalData[iCat].mean - _scaleU1[iCat]*_metZParalMC[iCat].mean;
+    _scaleU2[iCat] = _metZPerpData[iCat].rms/_metZPerpMC[iCat].rms;
   }
 
 }
@@ -255,78 +240,11 @@ void HTTRecoilCorrector::Correct(float MetPx,
 
   int ZptBin = binNumber(Zpt, _ZPtBins);
 
-  
-  TF1 * metZParalData = _metZParalData[ZptBin][njets];
-  TF1 * metZPerpData  = _metZPerpData[ZptBin][njets];
-  
-  TF1 * metZParalMC   = _metZParalMC[ZptBin][njets];
-  TF1 * metZPerpMC     = _metZPerpMC[ZptBin][njets];
-  
-  if (U1>_range*_xminMetZParal[ZptBin][njets]&&U1<_range*_xmaxMetZParal[ZptBin][njets]) {
-    
-    int nSumProb = 1;
-    double q[1];
-    double sumProb[1];
-    
-    sumProb[0] = metZParalMC->IntegralOneDim(_xminMetZParalMC[ZptBin][njets],U1,_epsrel,_epsabs,_error);
-    
-    if (sumProb[0]<0) {
-      //	std::cout << "Warning ! ProbSum[0] = " << sumProb[0] << std::endl;
-      sumProb[0] = 1e-5;
-    }
-    if (sumProb[0]>1) {
-      //	std::cout << "Warning ! ProbSum[0] = " << sumProb[0] << std::endl;
-      sumProb[0] = 1.0 - 1e-5;
-    }
-    
-      
-    metZParalData->GetQuantiles(nSumProb,q,sumProb);
-
-    float U1reco = float(q[0]);
-    U1 = U1reco;
-    
-  }
-  else {
-    float U1reco = rescale(U1,
-			   _meanMetZParalData[ZptBin][njets],
-			   _meanMetZParalMC[ZptBin][njets],
-			   _rmsMetZParalData[ZptBin][njets],
-			   _rmsMetZParalMC[ZptBin][njets]);
-    U1 = U1reco;
-  }
-
-  if (U2>_range*_xminMetZPerp[ZptBin][njets]&&U2<_range*_xmaxMetZPerp[ZptBin][njets]) {
-    
-    int nSumProb = 1;
-    double q[1];
-    double sumProb[1];
-    
-    sumProb[0] = metZPerpMC->IntegralOneDim(_xminMetZPerpMC[ZptBin][njets],U2,_epsrel,_epsabs,_error);
-    
-    if (sumProb[0]<0) {
-      //	std::cout << "Warning ! ProbSum[0] = " << sumProb[0] << std::endl;
-      sumProb[0] = 1e-5;
-    }
-    if (sumProb[0]>1) {
-      //	std::cout << "Warning ! ProbSum[0] = " << sumProb[0] << std::endl;
-      sumProb[0] = 1.0 - 1e-5;
-    }
-    
-    metZPerpData->GetQuantiles(nSumProb,q,sumProb);
+  U1U2CorrectionsBySampling(U1,
+			    U2,
+			    ZptBin,
+			    njets);
 
-    float U2reco = float(q[0]);
-    U2 = U2reco;
-      
-  }
-  else {
-    float U2reco = rescale(U2,
-			   _meanMetZPerpData[ZptBin][njets],
-			   _meanMetZPerpMC[ZptBin][njets],
-			   _rmsMetZPerpData[ZptBin][njets],
-			   _rmsMetZPerpMC[ZptBin][njets]);
-    U2 = U2reco;
-  }
-  
   CalculateMetFromU1U2(U1,U2,genVPx,genVPy,visVPx,visVPy,MetCorrPx,MetCorrPy);
 
 }
@@ -382,28 +300,48 @@ void HTTRecoilCorrector::CorrectByMeanResolution(float MetPx,
 
 }
 
-float HTTRecoilCorrector::CorrectionsBySampling(float x, TF1 * funcMC, TF1 * funcData) {
-
-  int nSumProb = 1;
-  double q[1];
-  double sumProb[1];
-  
-  double xD = double(x);
+void HTTRecoilCorrector::U1U2CorrectionsBySampling(float & U1,
+						float & U2,
+						int ZptBin,
+						int njets) {
+
+  int iCat = ZptBin*_nJetsBins + njets;
+
+  if (U1>_range*_xminMetZParal[iCat]&&U1<_range*_xmaxMetZParal[iCat])
+    U1 = CorrectionsBySampling(U1, _metZParalMC[iCat], _metZParalData[iCat]);
+  else
+    U1 = rescale(U1,
+		 _metZParalData[iCat].mean,
+		 _metZParalMC[iCat].mean,
+		 _metZParalData[iCat].rms,
+		 _metZParalMC[iCat].rms);
+
+  if (U2>_range*_xminMetZPerp[iCat]&&U2<_range*_xmaxMetZPerp[iCat])
+    U2 = CorrectionsBySampling(U2, _metZPerpMC[iCat], _metZPerpData[iCat]);
+  else
+    U2 = rescale(U2,
+		 _metZPerpData[iCat].mean,
+		 _metZPerpMC[iCat].mean,
+		 _metZPerpData[iCat].rms,
+		 _metZPerpMC[iCat].rms);
 
-  double xminD = 0;
-  double xmaxD = 0;
-
-  funcMC->GetRange(xminD,xmaxD);
+}
 
-  float xmin = float(xminD);
+float HTTRecoilCorrector::CorrectionsBySampling(float x, const RecoilShape & shapeMC, const RecoilShape & shapeData) {
 
-  sumProb[0] = funcMC->IntegralOneDim(xmin,xD,_epsrel,_epsabs,_error);
-  
-  funcData->GetQuantiles(nSumProb,q,sumProb);
+  // cumulative probability of x in MC, mapped to the same quantile of data
+  double sumProb = shapeMC.func.integral(x);
 
-  float output = float(q[0]);
+  if (sumProb<0) {
+    //	std::cout << "Warning ! ProbSum[0] = " << sumProb << std::endl;
+    sumProb = 1e-5;
+  }
+  if (sumProb>1) {
+    //	std::cout << "Warning ! ProbSum[0] = " << sumProb << std::endl;
+    sumProb = 1.0 - 1e-5;
+  }
 
-  return output;
+  return float(shapeData.func.quantile(sumProb));
 
 }
 
@@ -414,17 +352,19 @@ void HTTRecoilCorrector::U1U2CorrectionsByWidth(float & U1,
 
   if (njets>=_nJetsBins)
     njets = _nJetsBins - 1;
-    
+
+  int iCat = ZptBin*_nJetsBins + njets;
+
   // ********* U1 *************
 
-  float width = U1 - _meanMetZParalMC[ZptBin][njets];
-  width *= _rmsMetZParalData[ZptBin][njets]/_rmsMetZParalMC[ZptBin][njets];
-  U1 = _meanMetZParalData[ZptBin][njets] + width;
+  float width = U1 - _metZParalMC[iCat].mean;
+  width *= _metZParalData[iCat].rms/_metZParalMC[iCat].rms;
+  U1 = _metZParalData[iCat].mean + width;
 
   // ********* U2 *************
 
   width = U2;
-  width *= _rmsMetZPerpData[ZptBin][njets]/_rmsMetZPerpMC[ZptBin][njets];
+  width *= _metZPerpData[iCat].rms/_metZPerpMC[iCat].rms;
   U2 = width;
 
 }
@@ -500,3 +440,124 @@ void HTTRecoilCorrector::CalculateMetFromU1U2(float U1,
   metPx = hadRecX + genZPx - diLepPx;
   metPy = hadRecY + genZPy - diLepPy;
 }
+
+void HTTRecoilCorrector::CategoryIndices(const float * genZPx,
+					 const float * genZPy,
+					 const int * njets,
+					 size_t n,
+					 int * ZptBin,
+					 int * jetBin) const {
+
+  for (size_t i=0; i<n; ++i) {
+    float Zpt = TMath::Sqrt(genZPx[i]*genZPx[i] + genZPy[i]*genZPy[i]);
+    if (Zpt>1000)
+      Zpt = 999;
+    ZptBin[i] = binNumber(Zpt, _ZPtBins);
+    jetBin[i] = njets[i]>=_nJetsBins ? _nJetsBins - 1 : njets[i];
+  }
+
+}
+
+void HTTRecoilCorrector::U1U2FromMetBatch(const float * metPx,
+					  const float * metPy,
+					  const float * genZPx,
+					  const float * genZPy,
+					  const float * diLepPx,
+					  const float * diLepPy,
+					  size_t n,
+					  float * U1,
+					  float * U2) const {
+
+  // same as CalculateU1U2FromMet, projecting the hadronic recoil on the
+  // unit vector along the boson (and its normal) instead of going through
+  // atan2/cos/sin; a boson at rest is taken along x, as atan2(0,0)=0
+  for (size_t i=0; i<n; ++i) {
+    float hadRecX = metPx[i] + diLepPx[i] - genZPx[i];
+    float hadRecY = metPy[i] + diLepPy[i] - genZPy[i];
+    float Zpt = std::sqrt(genZPx[i]*genZPx[i] + genZPy[i]*genZPy[i]);
+    float invZpt = Zpt>0 ? 1.f/Zpt : 0.f;
+    float unitX = Zpt>0 ? genZPx[i]*invZpt : 1.f;
+    float unitY = genZPy[i]*invZpt;
+    U1[i] = hadRecX*unitX + hadRecY*unitY;
+    U2[i] = hadRecY*unitX - hadRecX*unitY;
+  }
+
+}
+
+void HTTRecoilCorrector::MetFromU1U2Batch(const float * U1,
+					  const float * U2,
+					  const float * genZPx,
+					  const float * genZPy,
+					  const float * diLepPx,
+					  const float * diLepPy,
+					  size_t n,
+					  float * metPx,
+					  float * metPy) const {
+
+  for (size_t i=0; i<n; ++i) {
+    float Zpt = std::sqrt(genZPx[i]*genZPx[i] + genZPy[i]*genZPy[i]);
+    float invZpt = Zpt>0 ? 1.f/Zpt : 0.f;
+    float unitX = Zpt>0 ? genZPx[i]*invZpt : 1.f;
+    float unitY = genZPy[i]*invZpt;
+    float hadRecX = U1[i]*unitX - U2[i]*unitY;
+    float hadRecY = U1[i]*unitY + U2[i]*unitX;
+    metPx[i] = hadRecX + genZPx[i] - diLepPx[i];
+    metPy[i] = hadRecY + genZPy[i] - diLepPy[i];
+  }
+
+}
+
+void HTTRecoilCorrector::Correct(const float * MetPx,
+				 const float * MetPy,
+				 const float * genVPx,
+				 const float * genVPy,
+				 const float * visVPx,
+				 const float * visVPy,
+				 const int * njets,
+				 size_t n,
+				 float * MetCorrPx,
+				 float * MetCorrPy) {
+
+  std::vector<int> ZptBin(n), jetBin(n);
+  std::vector<float> U1(n), U2(n);
+
+  CategoryIndices(genVPx, genVPy, njets, n, ZptBin.data(), jetBin.data());
+  U1U2FromMetBatch(MetPx, MetPy, genVPx, genVPy, visVPx, visVPy, n, U1.data(), U2.data());
+
+  // the quantile mapping needs the TF1 integrals, so this stays per event
+  for (size_t i=0; i<n; ++i)
+    U1U2CorrectionsBySampling(U1[i], U2[i], ZptBin[i], jetBin[i]);
+
+  MetFromU1U2Batch(U1.data(), U2.data(), genVPx, genVPy, visVPx, visVPy, n, MetCorrPx, MetCorrPy);
+
+}
+
+void HTTRecoilCorrector::CorrectByMeanResolution(const float * MetPx,
+						 const float * MetPy,
+						 const float * genVPx,
+						 const float * genVPy,
+						 const float * visVPx,
+						 const float * visVPy,
+						 const int * njets,
+						 size_t n,
+						 float * MetCorrPx,
+						 float * MetCorrPy) {
+
+  std::vector<int> ZptBin(n), jetBin(n);
+  std::vector<float> U1(n), U2(n);
+
+  CategoryIndices(genVPx, genVPy, njets, n, ZptBin.data(), jetBin.data());
+  U1U2FromMetBatch(MetPx, MetPy, genVPx, genVPy, visVPx, visVPy, n, U1.data(), U2.data());
+
+  const float * offsetU1 = _offsetU1.data();
+  const float * scaleU1 = _scaleU1.data();
+  const float * scaleU2 = _scaleU2.data();
+  for (size_t i=0; i<n; ++i) {
+    int idx = ZptBin[i]*_nJetsBins + jetBin[i];
+    U1[i] = offsetU1[idx] + scaleU1[idx]*U1[i];
+    U2[i] = scaleU2[idx]*U2[i];
+  }
+
+  MetFromU1U2Batch(U1.data(), U2.data(), genVPx, genVPy, visVPx, visVPy, n, MetCorrPx, MetCorrPy);
+
+}
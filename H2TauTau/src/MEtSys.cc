@@ -1,50 +1,105 @@
 #include "CMGTools/H2TauTau/interface/MEtSys.h"
 
-MEtSys::MEtSys(TString fileName) {
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+  std::string responseName(int bkgdType, int jetBin) {
+    std::stringstream lSS; lSS << "response_" << bkgdType << "_" << jetBin;
+    return lSS.str();
+  }
+
+}
+
+MEtSys::MEtSys(TString fileName) :
+  payload(0) {
 
   TString cmsswBase = TString( getenv ("CMSSW_BASE") );
   TString baseDir = cmsswBase + "/src";
   TString _fileName = baseDir+"/"+fileName;
-  TFile * file = new TFile(_fileName);
-  if (file->IsZombie()) {
-    std::cout << "file " << _fileName << " is not found...   quitting " << std::endl;
-    exit(-1);
+
+  if (cmg::CalibrationPayload::isPayload(std::string(_fileName))) {
+    payload = new cmg::CalibrationPayload(std::string(_fileName));
   }
-  TH1D * typeBkgdH = (TH1D*)file->Get("typeBkgdH");
-  if (typeBkgdH==NULL) {
-    std::cout << "Histogram typeBkgdH should be contained in file " << fileName << std::endl;
-    std::cout << "Check content of the file " << _fileName << std::endl;
-    exit(-1);
+  else {
+    TFile * file = new TFile(_fileName);
+    if (file->IsZombie())
+      throw cms::Exception("MEtSys") << "file " << _fileName << " is not found";
+    cmg::CalibrationPayloadWriter writer;
+    FillPayload(file, _fileName, writer);
+    file->Close();
+    delete file;
+    std::vector<char> image = writer.image();
+    payload = new cmg::CalibrationPayload(image);
   }
+
+  std::vector<double> dims = payload->scalars("dimensions");
+  nBkgdTypes = int(dims.at(0));
+  nJetBins = int(dims.at(1));
+  for (int i=0; i<nBkgdTypes; ++i)
+    for (int j=0; j<nJetBins; ++j)
+      responseHist.push_back(payload->histogram(responseName(i,j)));
+
+}
+
+MEtSys::~MEtSys() {
+
+  delete payload;
+
+}
+
+void MEtSys::WritePayload(TString rootFileName, TString payloadFileName) {
+
+  TFile * file = new TFile(rootFileName);
+  if (file->IsZombie())
+    throw cms::Exception("MEtSys") << "file " << rootFileName << " is not found";
+  cmg::CalibrationPayloadWriter writer;
+  FillPayload(file, rootFileName, writer);
+  file->Close();
+  delete file;
+  writer.write(std::string(payloadFileName));
+
+}
+
+void MEtSys::FillPayload(TFile * file,
+			 const TString & fileName,
+			 cmg::CalibrationPayloadWriter & writer) {
+
+  TH1D * typeBkgdH = (TH1D*)file->Get("typeBkgdH");
+  if (typeBkgdH==NULL)
+    throw cms::Exception("MEtSys") << "Histogram typeBkgdH should be contained in file " << fileName;
   TH1D * jetBinsH = (TH1D*)file->Get("jetBinsH");
-  if (jetBinsH==NULL) {
-    std::cout << "Histogram jetBinsH should be contained in file " << fileName << std::endl;
-    std::cout << "Check content of the file " << _fileName << std::endl;
-    exit(-1);
-  }
+  if (jetBinsH==NULL)
+    throw cms::Exception("MEtSys") << "Histogram jetBinsH should be contained in file " << fileName;
 
-  nBkgdTypes = typeBkgdH->GetNbinsX();
+  int nBkgd = typeBkgdH->GetNbinsX();
   std::vector<TString> Bkgd; Bkgd.clear();
-  nJetBins = jetBinsH->GetNbinsX();
+  int nJets = jetBinsH->GetNbinsX();
   std::vector<TString> JetBins; JetBins.clear();
-  for (int i=0; i<nBkgdTypes; ++i) {
+  for (int i=0; i<nBkgd; ++i) {
     Bkgd.push_back(typeBkgdH->GetXaxis()->GetBinLabel(i+1));
   }
-  for (int i=0; i<nJetBins; ++i) {
+  for (int i=0; i<nJets; ++i) {
     JetBins.push_back(jetBinsH->GetXaxis()->GetBinLabel(i+1));
   }
 
-  for (int i=0; i<nBkgdTypes; ++i) {
-    for (int j=0; j<nJetBins; ++j) {
+  std::vector<double> dims;
+  dims.push_back(nBkgd);
+  dims.push_back(nJets);
+  writer.addScalars("dimensions", dims);
+
+  for (int i=0; i<nBkgd; ++i) {
+    for (int j=0; j<nJets; ++j) {
       TString histName = Bkgd[i]+"_"+JetBins[j];
       std::cout << histName << std::endl;
-      responseHist[i][j] = (TH1D*)file->Get(histName);
-      if (responseHist[i][j]==NULL) {
-	std::cout << "Histogram " << histName << " should be contained in file " << fileName << std::endl;
-	std::cout << "Check content of the file " << fileName << std::endl;
-	exit(-1);
-      }
-
+      TH1D * hist = (TH1D*)file->Get(histName);
+      if (hist==NULL)
+	throw cms::Exception("MEtSys") << "Histogram " << histName << " should be contained in file " << fileName;
+      writer.addHistogram(responseName(i,j), *hist);
     }
   }
 }
@@ -119,7 +174,7 @@ void MEtSys::ShiftResponseMet(float metPx,
   ComputeHadRecoilFromMet(metPx,metPy,genVPx,genVPy,visVPx,visVPy,Hparal,Hperp);
 
   int jets = njets; 
-  if (jets>2) jets = 2; 
+  if (jets>nJetBins-1) jets = nJetBins-1; 
   if (jets<0) {
     std::cout << "Number of jets is negative ! Setting number of jets to 0" << std::endl;
     jets = 0;
@@ -130,12 +185,12 @@ void MEtSys::ShiftResponseMet(float metPx,
     bkgdType=0;
   }
   
-  if (bkgdType>1) { 
-    std::cout << "Background type > 2 ! Setting background type to 2 " << std::endl;
-    bkgdType=1;
+  if (bkgdType>nBkgdTypes-1) { 
+    std::cout << "Background type > " << nBkgdTypes-1 << " ! Setting background type to " << nBkgdTypes-1 << std::endl;
+    bkgdType=nBkgdTypes-1;
   }
 
-  float mean = -responseHist[bkgdType][jets]->Interpolate(genVPt)*genVPt;
+  float mean = -responseHist[bkgdType*nJetBins+jets].interpolate(genVPt)*genVPt;
   float shift = sysShift*mean;
   Hparal = Hparal + (shift-mean);
 
@@ -163,7 +218,7 @@ void MEtSys::ShiftResolutionMet(float metPx,
   ComputeHadRecoilFromMet(metPx,metPy,genVPx,genVPy,visVPx,visVPy,Hparal,Hperp);
 
   int jets = njets; 
-  if (jets>2) jets = 2; 
+  if (jets>nJetBins-1) jets = nJetBins-1; 
   if (jets<0) {
     std::cout << "Number of jets is negative ! Setting number of jets to 0" << std::endl;
     jets = 0;
@@ -174,12 +229,12 @@ void MEtSys::ShiftResolutionMet(float metPx,
     bkgdType=0;
   }
   
-  if (bkgdType>1) { 
-    std::cout << "Background type > 2 ! Setting background type to 2 " << std::endl;
-    bkgdType=1;
+  if (bkgdType>nBkgdTypes-1) { 
+    std::cout << "Background type > " << nBkgdTypes-1 << " ! Setting background type to " << nBkgdTypes-1 << std::endl;
+    bkgdType=nBkgdTypes-1;
   }
 
-  float mean = -responseHist[bkgdType][jets]->Interpolate(genVPt)*genVPt;
+  float mean = -responseHist[bkgdType*nJetBins+jets].interpolate(genVPt)*genVPt;
   Hperp = sysShift*Hperp;
   Hparal = mean + (Hparal-mean)*sysShift;
 
@@ -231,3 +286,83 @@ void MEtSys::ShiftMEt(float metPx,
 
 
 }
+
+void MEtSys::ShiftMEt(const float * metPx,
+		      const float * metPy,
+		      const float * genVPx,
+		      const float * genVPy,
+		      const float * visVPx,
+		      const float * visVPy,
+		      const int * njets,
+		      size_t n,
+		      int bkgdType,
+		      int sysType,
+		      float sysShift,
+		      float * metShiftPx,
+		      float * metShiftPy) {
+
+  if (sysType!=0 && sysType!=1) {
+    for (size_t i=0; i<n; ++i) {
+      metShiftPx[i] = metPx[i];
+      metShiftPy[i] = metPy[i];
+    }
+    return;
+  }
+
+  if (bkgdType<0) { 
+    std::cout << "Background type < 0 ! Setting background type to 0 " << std::endl;
+    bkgdType=0;
+  }
+  
+  if (bkgdType>nBkgdTypes-1) { 
+    std::cout << "Background type > " << nBkgdTypes-1 << " ! Setting background type to " << nBkgdTypes-1 << std::endl;
+    bkgdType=nBkgdTypes-1;
+  }
+
+  // first pass: mean response per event, the only step needing the histograms
+  const cmg::PayloadHistogram * hists = &responseHist[bkgdType*nJetBins];
+  std::vector<float> mean(n);
+  int nNegative = 0;
+  for (size_t i=0; i<n; ++i) {
+    float genVPt = std::sqrt(genVPx[i]*genVPx[i]+genVPy[i]*genVPy[i]);
+    int jets = njets[i];
+    if (jets>nJetBins-1) jets = nJetBins-1;
+    if (jets<0) {
+      ++nNegative;
+      jets = 0;
+    }
+    mean[i] = -hists[jets].interpolate(genVPt)*genVPt;
+  }
+  if (nNegative>0)
+    std::cout << "Number of jets is negative in " << nNegative << " events ! Setting number of jets to 0" << std::endl;
+
+  // second pass: same as ComputeHadRecoilFromMet/ComputeMetFromHadRecoil,
+  // using the normal (-unitY,unitX) instead of cos/sin of phi+pi/2
+  bool response = (sysType==0);
+  for (size_t i=0; i<n; ++i) {
+    float genVPt = std::sqrt(genVPx[i]*genVPx[i]+genVPy[i]*genVPy[i]);
+    float unitX = genVPx[i]/genVPt;
+    float unitY = genVPy[i]/genVPt;
+
+    float Hx = -metPx[i] - visVPx[i];
+    float Hy = -metPy[i] - visVPy[i];
+
+    float Hparal = Hx*unitX + Hy*unitY;
+    float Hperp = Hy*unitX - Hx*unitY;
+
+    if (response) {
+      Hparal = Hparal + (sysShift-1)*mean[i];
+    }
+    else {
+      Hperp = sysShift*Hperp;
+      Hparal = mean[i] + (Hparal-mean[i])*sysShift;
+    }
+
+    Hx = Hparal*unitX - Hperp*unitY;
+    Hy = Hparal*unitY + Hperp*unitX;
+
+    metShiftPx[i] = -Hx - visVPx[i];
+    metShiftPy[i] = -Hy - visVPy[i];
+  }
+
+}
@@ -3,7 +3,174 @@
 #include "Math/Minimizer.h"
 #include "Math/Factory.h"
 #include "Math/Functor.h"
+#include "Math/IFunction.h"
 #include <TGraph.h>
+#include <TROOT.h>
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+  //efficiency() for par = (m0, sigma, alpha, n, norm) and, if grad is not null,
+  //its derivatives with respect to the parameters
+  double turnOn(double m, const double* par, double* grad) {
+    if(grad) std::fill(grad, grad+5, 0.);
+    if(m<1. || 1000.<m)return 0.;
+
+    const double sqrtPiOver2 = 1.2533141373;
+    const double sqrt2 = 1.4142135624;
+    const double sigma = par[1], alpha = par[2], n = par[3], norm = par[4];
+    double sig = fabs(sigma);
+    double t = (m - par[0])/sig;
+    if(alpha < 0)
+      t = -t;
+    double absAlpha = fabs(alpha/sig);
+    double gaussAlpha = exp(-0.5*absAlpha*absAlpha);
+    double a = TMath::Power(n/absAlpha,n)*gaussAlpha;
+    double b = absAlpha - n/absAlpha;
+    double arg = absAlpha / sqrt2;
+    bool clampedAlpha = arg > 5. || arg < -5.;
+    double ApproxErf = arg > 5. ? 1 : (arg < -5. ? -1 : TMath::Erf(arg));
+    double leftArea = (1 + ApproxErf) * sqrtPiOver2;
+    double rightArea = ( a * 1/TMath::Power(absAlpha - b,n-1)) / (n - 1);
+    double area = leftArea + rightArea;
+
+    double num = 0.;
+    //derivatives of the numerator with respect to t, |alpha/sigma| and n
+    double dNum_dt = 0., dNum_dA = 0., dNum_dn = 0.;
+    if( t <= absAlpha ){
+      arg = t / sqrt2;
+      bool clamped = arg > 5. || arg < -5.;
+      ApproxErf = arg > 5. ? 1 : (arg < -5. ? -1 : TMath::Erf(arg));
+      num = (1 + ApproxErf) * sqrtPiOver2;
+      if(!grad) return norm * num / area;
+      dNum_dt = clamped ? 0. : exp(-0.5*t*t);
+    }
+    else{
+      num = leftArea + a * (1/TMath::Power(t-b,n-1) -  1/TMath::Power(absAlpha - b,n-1)) / (1 - n);
+      if(!grad) return norm * num / area;
+      //tail term (q-p)/(1-n) with q = a*(t-b)^(1-n) and p = a*(|alpha/sigma|-b)^(1-n)
+      double u = t - b;
+      double q = a / TMath::Power(u,n-1);
+      double p = n / absAlpha * gaussAlpha;
+      double dq_dA = q * ( -n/absAlpha - absAlpha + (1-n)*(-1 - n/(absAlpha*absAlpha))/u );
+      double dq_dn = q * ( log(n/absAlpha) + 1 - log(u) + (1-n)/(absAlpha*u) );
+      double dp_dA = p * ( -1/absAlpha - absAlpha );
+      double dp_dn = p / n;
+      dNum_dt = q / u;
+      dNum_dA = (clampedAlpha ? 0. : gaussAlpha) + (dq_dA - dp_dA)/(1 - n);
+      dNum_dn = (dq_dn - dp_dn)/(1 - n) + (q - p)/((1 - n)*(1 - n));
+    }
+
+    //rightArea = n/|alpha/sigma| exp(-alpha^2/2sigma^2) / (n-1)
+    double dArea_dA = (clampedAlpha ? 0. : gaussAlpha)
+      - n * gaussAlpha * (1/(absAlpha*absAlpha) + 1) / (n - 1);
+    double dArea_dn = -gaussAlpha / absAlpha / ((n - 1)*(n - 1));
+
+    double dEff_dt = norm * dNum_dt / area;
+    double dEff_dA = norm * (dNum_dA*area - num*dArea_dA) / (area*area);
+    double dEff_dn = norm * (dNum_dn*area - num*dArea_dn) / (area*area);
+
+    double signAlpha = alpha < 0 ? -1. : 1.;
+    double signSigma = sigma < 0 ? -1. : 1.;
+    grad[0] = -dEff_dt * signAlpha / sig;
+    grad[1] = -(dEff_dt * t + dEff_dA * absAlpha) * signSigma / sig;
+    grad[2] = dEff_dA * signAlpha / sig;
+    grad[3] = dEff_dn;
+    grad[4] = num / area;
+    return norm * num / area;
+  }
+
+  //bins entering the chi2, stored contiguously
+  struct FitData {
+    std::vector<double> x;     // bin centres
+    std::vector<double> y;     // contents
+    std::vector<double> w;     // 1/error^2
+  };
+
+  class TurnOnChi2 : public ROOT::Math::IMultiGradFunction {
+  public:
+    explicit TurnOnChi2(const FitData* data) : data_(data) {}
+    ROOT::Math::IMultiGradFunction* Clone() const { return new TurnOnChi2(data_); }
+    unsigned int NDim() const { return 5; }
+
+    void Gradient(const double* par, double* grad) const {
+      double chi2 = 0.;
+      FdF(par, chi2, grad);
+    }
+
+    void FdF(const double* par, double& chi2, double* grad) const {
+      chi2 = 0.;
+      std::fill(grad, grad+5, 0.);
+      double g[5];
+      for(size_t i=0; i<data_->x.size(); ++i){
+	double diff = data_->y[i] - turnOn(data_->x[i], par, g);
+	chi2 += diff*diff*data_->w[i];
+	for(int k=0; k<5; ++k)
+	  grad[k] -= 2.*diff*data_->w[i]*g[k];
+      }
+    }
+
+  private:
+    double DoEval(const double* par) const {
+      double chi2 = 0.;
+      for(size_t i=0; i<data_->x.size(); ++i){
+	double diff = data_->y[i] - turnOn(data_->x[i], par, 0);
+	chi2 += diff*diff*data_->w[i];
+      }
+      return chi2;
+    }
+
+    double DoDerivative(const double* par, unsigned int icoord) const {
+      double grad[5];
+      Gradient(par, grad);
+      return grad[icoord];
+    }
+
+    const FitData* data_;
+  };
+
+  void fitOne(ROOT::Math::Minimizer* min, const FitData& data, TriggerEfficiency::FitResult& result) {
+    TurnOnChi2 chi2(&data);
+    min->SetFunction(chi2);
+
+    double step[5] = {0.001,0.001,0.001,0.001,0.001};
+    double variable[5] = {18,0.19,0.19,1.8,0.9};
+    for(int k=0; k<5; ++k){
+      std::ostringstream name;
+      name<<"v"<<k;
+      min->SetVariable(k,name.str(),variable[k],step[k]);
+    }
+
+    min->Minimize();
+    if(min->MinValue()>20) min->Minimize();
+
+    for(int k=0; k<5; ++k){
+      result.par[k] = min->X()[k];
+      result.err[k] = min->Errors() ? min->Errors()[k] : 0.;
+    }
+    result.chi2 = min->MinValue();
+    result.ndf = int(data.x.size()) - 5;
+    result.status = min->Status();
+  }
+
+  struct FitWorker {
+    std::atomic<size_t>* next;
+    const std::vector<ROOT::Math::Minimizer*>* minimizers;
+    const std::vector<FitData>* data;
+    std::vector<TriggerEfficiency::FitResult>* results;
+
+    void operator()() const {
+      for(size_t i = (*next)++; i < data->size(); i = (*next)++)
+	if((*minimizers)[i]) fitOne((*minimizers)[i], (*data)[i], (*results)[i]);
+    }
+  };
+}
 
 
 double TriggerEfficiency::efficiency(double m, double m0, double sigma, double alpha,double n, double norm) const {
@@ -127,3 +294,111 @@ bool TriggerEfficiency::fitEfficiency(const char* filename,float xmin,float xmax
 
   return 1;
 }
+
+std::vector<TriggerEfficiency::FitResult> TriggerEfficiency::fitEfficiencies(const std::vector<FitJob>& jobs, unsigned int nThreads){
+
+  std::vector<FitData> data(jobs.size());
+  std::vector<FitResult> results(jobs.size());
+  std::vector<ROOT::Math::Minimizer*> minimizers(jobs.size(), (ROOT::Math::Minimizer*)0);
+
+  //histograms are read and minimizers created here, neither ROOT I/O nor
+  //the plugin manager are to be used from the worker threads
+  for(size_t j=0;j<jobs.size();j++){
+    FitResult& result = results[j];
+    result.name = jobs[j].name;
+    std::fill(result.par, result.par+5, 0.);
+    std::fill(result.err, result.err+5, 0.);
+    result.chi2 = 0.;
+    result.ndf = 0;
+    result.status = -1;
+
+    TFile File(jobs[j].fileName.c_str(),"read");
+    TH1* histo = File.IsZombie() ? 0 : (TH1*)File.Get(jobs[j].histName.c_str());
+    if(!histo) continue;
+
+    const float xmin = jobs[j].xmin;
+    const float xmax = jobs[j].xmax;
+    for(int b=1;b<=histo->GetNbinsX();b++){
+      double center = histo->GetBinCenter(b);
+      double error = histo->GetBinError(b);
+      if(error>0
+	 && histo->GetBinContent(b)>0
+	 && (center>xmin || xmin==0.)
+	 && (center<xmax || xmax==0.)
+	 ){//same bins as in operator()
+	data[j].x.push_back(center);
+	data[j].y.push_back(histo->GetBinContent(b));
+	data[j].w.push_back(1./(error*error));
+      }
+    }
+    File.Close();
+
+    ROOT::Math::Minimizer* min = ROOT::Math::Factory::CreateMinimizer("Minuit2","");
+    min->SetMaxFunctionCalls(200000);
+    min->SetMaxIterations(100000);
+    min->SetTolerance(0.0001);
+    min->SetPrintLevel(0);
+    minimizers[j] = min;
+  }
+
+  ROOT::EnableThreadSafety();
+
+  if(nThreads==0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+  nThreads = std::min<size_t>(nThreads, std::max<size_t>(jobs.size(), 1));
+
+  std::atomic<size_t> next(0);
+  FitWorker worker = {&next, &minimizers, &data, &results};
+  std::vector<std::thread> threads;
+  for(unsigned int t=1;t<nThreads;t++)
+    threads.push_back(std::thread(worker));
+  worker();
+  for(size_t t=0;t<threads.size();t++)
+    threads[t].join();
+
+  for(size_t j=0;j<minimizers.size();j++)
+    delete minimizers[j];
+
+  return results;
+}
+
+bool TriggerEfficiency::writeParameters(const char* filename, const std::vector<FitResult>& results){
+
+  std::ofstream out(filename);
+  if(!out) return 0;
+  out<<"# name m0 sigma alpha n norm, their errors, chi2 ndf status"<<std::endl;
+  out.precision(10);
+  for(size_t j=0;j<results.size();j++){
+    const FitResult& r = results[j];
+    if(r.status<0) continue;//histogram not found
+    out<<r.name;
+    for(int k=0;k<5;k++) out<<" "<<r.par[k];
+    for(int k=0;k<5;k++) out<<" "<<r.err[k];
+    out<<" "<<r.chi2<<" "<<r.ndf<<" "<<r.status<<std::endl;
+  }
+  return bool(out);
+}
+
+bool TriggerEfficiency::loadParameters(const char* filename){
+
+  std::ifstream in(filename);
+  if(!in) return 0;
+  std::string line;
+  while(std::getline(in,line)){
+    if(line.empty() || line[0]=='#') continue;
+    std::istringstream fields(line);
+    std::string name;
+    std::vector<double> par(5);
+    fields>>name>>par[0]>>par[1]>>par[2]>>par[3]>>par[4];
+    if(!fields) return 0;
+    fitted_[name] = par;
+  }
+  return 1;
+}
+
+double TriggerEfficiency::effFitted(const std::string& name, double pt) const {
+  std::map<std::string, std::vector<double> >::const_iterator it = fitted_.find(name);
+  if(it==fitted_.end())
+    throw cms::Exception("TriggerEfficiency") << "no fitted parameters for " << name;
+  const std::vector<double>& p = it->second;
+  return efficiency(pt,p[0],p[1],p[2],p[3],p[4]);
+}
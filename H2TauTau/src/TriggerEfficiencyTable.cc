@@ -0,0 +1,349 @@
+#include "CMGTools/H2TauTau/interface/TriggerEfficiencyTable.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  // pt segments, finer where the turn-ons are
+  const double kPtEdges[] = {1., 10., 15., 17.5, 20., 22.5, 25., 30., 35., 40., 45., 50.,
+			     60., 80., 100., 150., 200., 300., 500., 1000.};
+  const int kNSegments = sizeof(kPtEdges)/sizeof(kPtEdges[0]) - 1;
+  const unsigned int kMinCells = 4;
+  const unsigned int kMaxCells = 1024;
+
+  // all pt edges are multiples of this, for the segment index
+  const double kPtEdgeStepInv = 2.;
+
+  // |eta| boundaries used by the curves, on top of eta=0;
+  // 3 is where abs() truncated to int exceeds 2.1
+  const double kAbsEtaEdges[] = {0.8, 1.2, 1.4, 1.479, 1.5, 2.1, 3.};
+  const int kNAbsEtaEdges = sizeof(kAbsEtaEdges)/sizeof(kAbsEtaEdges[0]);
+
+  struct NamedCurve {
+    const char * name;
+    TriggerEfficiencyTable::Curve curve;
+  };
+
+#define CURVE(name) { #name, &TriggerEfficiency::name }
+  const NamedCurve kCurves[] = {
+    CURVE(effTau2011A),
+    CURVE(effTau2011B),
+    CURVE(effTau2011AB),
+    CURVE(effMu2011A),
+    CURVE(effMu2011B),
+    CURVE(effMu2011AB),
+    CURVE(effLooseTau10),
+    CURVE(effLooseTau15),
+    CURVE(effLooseTau20),
+    CURVE(effLooseTau20_TauEle),
+    CURVE(effLooseTau15MC),
+    CURVE(effTightIsoTau20),
+    CURVE(effMediumIsoTau20),
+    CURVE(effMediumIsoTau20MC),
+    CURVE(effIsoMu12),
+    CURVE(effIsoMu15),
+    CURVE(effIsoMu15eta2p1),
+    CURVE(effIsoMu15MC),
+    CURVE(effEle15),
+    CURVE(effEle18),
+    CURVE(effEle20),
+    CURVE(effEle18MC),
+    CURVE(eff2012ATau20),
+    CURVE(eff2012BTau20),
+    CURVE(eff2012MCTau20),
+    CURVE(effTau2012MC),
+    CURVE(effTau2012A),
+    CURVE(effTau2012B),
+    CURVE(effTau2012AB),
+    CURVE(eff2012AMu18),
+    CURVE(eff2012BMu17),
+    CURVE(effMu2012MC),
+    CURVE(effMu2012A),
+    CURVE(effMu2012B),
+    CURVE(effMu2012AB),
+    CURVE(eff2012CMu17),
+    CURVE(effMu2012ABC),
+    CURVE(effMu2012MC53X),
+    CURVE(effTau2012ABC),
+    CURVE(effTau2012MC53X),
+    CURVE(eff_2012_Rebecca_TauMu_IsoMu18A),
+    CURVE(eff_2012_Rebecca_TauMu_IsoMu17B),
+    CURVE(eff_2012_Rebecca_TauMu_IsoMu17C),
+    CURVE(eff_2012_Rebecca_TauMu_IsoMu1753XMC),
+    CURVE(effMu2012_Rebecca_TauMu_ABC),
+    CURVE(effMu_muTau_Data_2012D),
+    CURVE(effTau_muTau_Data_2012D),
+    CURVE(effTau_muTau_MC_2012D),
+    CURVE(effMu_muTau_Data_2012ABCD),
+    CURVE(effMu_muTau_MC_2012ABCD),
+    CURVE(effTau_muTau_Data_2012ABCD),
+    CURVE(effTau_muTau_MC_2012ABCD),
+    CURVE(effMu_muTau_Data_2012ABCDSummer13),
+    CURVE(effTau_muTau_Data_2012ABCDSummer13),
+    CURVE(effTau_muTau_MC_2012ABCDSummer13),
+    CURVE(effEle2012AB),
+    CURVE(effTau2012AB_TauEle),
+    CURVE(eff2012AEle20),
+    CURVE(eff2012BEle22),
+    CURVE(eff2012Ele20MC),
+    CURVE(eff2012ATau20_TauEle),
+    CURVE(eff2012BTau20_TauEle),
+    CURVE(eff2012Tau20MC_TauEle),
+    CURVE(eff_2012_Rebecca_TauEle_Ele20A),
+    CURVE(eff_2012_Rebecca_TauEle_Ele22B),
+    CURVE(eff_2012_Rebecca_TauEle_Ele22C),
+    CURVE(eff_2012_Rebecca_TauEle_Ele22BC),
+    CURVE(eff_2012_Rebecca_TauEle_Ele2253XMC),
+    CURVE(effEle2012_Rebecca_TauEle_ABC),
+    CURVE(eff2012CEle22),
+    CURVE(effEle2012ABC),
+    CURVE(effEle2012MC53X),
+    CURVE(effTau2012ABC_TauEle),
+    CURVE(eff2012Tau20MC53X_TauEle),
+    CURVE(effEle_eTau_Data_2012D),
+    CURVE(effTau_eTau_Data_2012D),
+    CURVE(effTau_eTau_MC_2012D),
+    CURVE(effEle_eTau_Data_2012ABCD),
+    CURVE(effEle_eTau_MC_2012ABCD),
+    CURVE(effTau_eTau_Data_2012ABCD),
+    CURVE(effTau_eTau_MC_2012ABCD),
+    CURVE(effEle_eTau_Data_2012ABCDSummer13),
+    CURVE(effTau_eTau_Data_2012ABCDSummer13),
+    CURVE(effTau_eTau_MC_2012ABCDSummer13),
+    CURVE(effIsoTau20),
+    CURVE(effIsoTau25),
+    CURVE(effIsoTau35),
+    CURVE(effIsoTau45),
+    CURVE(effTau1fb),
+    CURVE(effTau5fb),
+    CURVE(eff2012IsoTau25),
+    CURVE(eff2012IsoTau30),
+    CURVE(eff2012IsoTau1_6fb),
+    CURVE(eff2012IsoTau5_1fb),
+    CURVE(eff2012Jet30),
+    CURVE(eff2012Jet5fb),
+    CURVE(eff2012IsoTau5fb),
+    CURVE(eff2012IsoTau5fbUp),
+    CURVE(eff2012IsoTau5fbDown),
+    CURVE(eff2012IsoTau5fbUpSlope),
+    CURVE(eff2012IsoTau5fbDownSlope),
+    CURVE(eff2012IsoTau5fbUpPlateau),
+    CURVE(eff2012IsoTau5fbDownPlateau),
+    CURVE(eff2012IsoTau5fbCrystalBall),
+    CURVE(eff2012IsoTau5fbFitFrom30),
+    CURVE(eff2012IsoTau12fb),
+    CURVE(eff2012Jet12fb),
+    CURVE(eff2012Jet19fb),
+    CURVE(eff2012IsoTau19fb),
+    CURVE(eff2012IsoTau35Park),
+    CURVE(eff2012IsoTau1prong12fb),
+    CURVE(eff2012IsoTau1prong19fb),
+    CURVE(eff2012IsoTau19fb_Simone),
+    CURVE(eff2012IsoTau19fbMC_Simone),
+    CURVE(eff2012IsoParkedTau19fb_Simone),
+    CURVE(eff2012IsoParkedTau19fbMC_Simone)
+  };
+#undef CURVE
+  const size_t kNCurves = sizeof(kCurves)/sizeof(kCurves[0]);
+
+  TriggerEfficiencyTable::Curve findCurve(const std::string & name) {
+    for (size_t i=0; i<kNCurves; ++i)
+      if (name == kCurves[i].name)
+	return kCurves[i].curve;
+    throw cms::Exception("TriggerEfficiencyTable") << "unknown curve " << name;
+  }
+}
+
+
+TriggerEfficiencyTable::TriggerEfficiencyTable(const std::string & name, double tolerance) :
+  curve_(findCurve(name)),
+  tolerance_(tolerance)
+{
+  build();
+}
+
+TriggerEfficiencyTable::TriggerEfficiencyTable(Curve curve, double tolerance) :
+  curve_(curve),
+  tolerance_(tolerance)
+{
+  build();
+}
+
+bool TriggerEfficiencyTable::hasCurve(const std::string & name) {
+  for (size_t i=0; i<kNCurves; ++i)
+    if (name == kCurves[i].name)
+      return true;
+  return false;
+}
+
+std::vector<std::string> TriggerEfficiencyTable::curveNames() {
+  std::vector<std::string> names;
+  for (size_t i=0; i<kNCurves; ++i)
+    names.push_back(kCurves[i].name);
+  return names;
+}
+
+void TriggerEfficiencyTable::build() {
+  if (!(tolerance_ > 0.))
+    throw cms::Exception("TriggerEfficiencyTable") << "tolerance must be positive, got " << tolerance_;
+
+  // one table per open interval between the edges, sampled in its middle
+  const int nBins = static_cast<int>(kPtEdges[kNSegments]*kPtEdgeStepInv) + 1;
+  ptSegment_.resize(nBins);
+  for (int i=0; i<nBins; ++i) {
+    const double pt = i/kPtEdgeStepInv;
+    int s = 0;
+    while (s+1 < kNSegments && kPtEdges[s+1] <= pt)
+      ++s;
+    ptSegment_[i] = s;
+  }
+
+  // regions from -inf to +inf, see region()
+  std::vector<double> etaEdges;
+  for (int i=kNAbsEtaEdges; i>0; --i)
+    etaEdges.push_back(-kAbsEtaEdges[i-1]);
+  etaEdges.push_back(0.);
+  for (int i=0; i<kNAbsEtaEdges; ++i)
+    etaEdges.push_back(kAbsEtaEdges[i]);
+
+  const int nEdges = etaEdges.size();
+  for (int r=0; r<=nEdges; ++r) {
+    double eta = 0.;
+    if (r == 0)
+      eta = etaEdges.front() - 1.;
+    else if (r == nEdges)
+      eta = etaEdges.back() + 1.;
+    else
+      eta = 0.5*(etaEdges[r-1] + etaEdges[r]);
+
+    const size_t first = values_.size();
+    const int table = segments_.size()/kNSegments;
+    for (int s=0; s<kNSegments; ++s) {
+      Segment segment;
+      buildSegment(eta, kPtEdges[s], kPtEdges[s+1], segment);
+      segments_.push_back(segment);
+    }
+
+    // share the table with an earlier region if the curve is the same
+    int same = -1;
+    for (int t=0; t<table && same<0; ++t) {
+      bool equal = true;
+      for (int s=0; s<kNSegments && equal; ++s) {
+	const Segment & a = segments_[t*kNSegments+s];
+	const Segment & b = segments_[table*kNSegments+s];
+	equal = a.nCells == b.nCells &&
+	  std::equal(values_.begin()+a.offset, values_.begin()+a.offset+a.nCells+1, values_.begin()+b.offset) &&
+	  std::equal(exactCell_.begin()+a.offset, exactCell_.begin()+a.offset+a.nCells+1, exactCell_.begin()+b.offset);
+      }
+      if (equal)
+	same = t;
+    }
+    if (same >= 0) {
+      values_.resize(first);
+      exactCell_.resize(first);
+      segments_.resize(table*kNSegments);
+      regionTable_.push_back(same);
+    }
+    else
+      regionTable_.push_back(table);
+  }
+}
+
+void TriggerEfficiencyTable::buildSegment(double eta, double lo, double hi, Segment & segment) {
+  std::vector<double> nodes;
+  std::vector<char> failed;
+  unsigned int nCells = kMinCells;
+  while (true) {
+    const double step = (hi-lo)/nCells;
+    nodes.resize(nCells+1);
+    for (unsigned int i=0; i<=nCells; ++i)
+      nodes[i] = exact(i<nCells ? lo+i*step : hi, eta);
+
+    failed.assign(nCells+1, 0);
+    bool allPassed = true;
+    for (unsigned int i=0; i<nCells; ++i) {
+      for (int q=1; q<4; ++q) {
+	const double f = 0.25*q;
+	const double interpolated = (1.-f)*nodes[i] + f*nodes[i+1];
+	// half the tolerance at the check points leaves a margin for the
+	// error in between; written so that NaN counts as a failure
+	if (!(std::fabs(interpolated - exact(lo+(i+f)*step, eta)) <= 0.5*tolerance_)) {
+	  failed[i] = 1;
+	  allPassed = false;
+	  break;
+	}
+      }
+    }
+    if (allPassed || nCells >= kMaxCells)
+      break;
+    nCells *= 2;
+  }
+
+  segment.invStep = nCells/(hi-lo);
+  segment.nCells = nCells;
+  segment.offset = values_.size();
+  values_.insert(values_.end(), nodes.begin(), nodes.end());
+  exactCell_.insert(exactCell_.end(), failed.begin(), failed.end());
+}
+
+size_t TriggerEfficiencyTable::nExactCells() const {
+  return std::count(exactCell_.begin(), exactCell_.end(), 1);
+}
+
+// -1 if eta is on a boundary or not a number; the edges are symmetric in eta
+// and are counted rather than searched, which avoids mispredicted branches
+int TriggerEfficiencyTable::region(double eta) const {
+  const double absEta = std::fabs(eta);
+  int above = 0;
+  int onEdge = absEta == 0.;
+  for (int i=0; i<kNAbsEtaEdges; ++i) {
+    above += absEta > kAbsEtaEdges[i];
+    onEdge += absEta == kAbsEtaEdges[i];
+  }
+  if (onEdge || eta != eta)
+    return -1;
+  return eta > 0. ? kNAbsEtaEdges + 1 + above : kNAbsEtaEdges - above;
+}
+
+// -1 outside of the tabulated range
+int TriggerEfficiencyTable::segment(double pt) const {
+  if (!(pt >= kPtEdges[0] && pt <= kPtEdges[kNSegments]))
+    return -1;
+  return ptSegment_[static_cast<int>(pt*kPtEdgeStepInv)];
+}
+
+double TriggerEfficiencyTable::lookup(double pt, int table, int seg) const {
+  const Segment & segment = segments_[table*kNSegments+seg];
+  const double x = (pt - kPtEdges[seg])*segment.invStep;
+  const unsigned int cell = std::min(static_cast<unsigned int>(x), segment.nCells-1);
+  const unsigned int node = segment.offset + cell;
+  if (exactCell_[node])
+    return std::numeric_limits<double>::quiet_NaN();
+  const double f = x - cell;
+  return (1.-f)*values_[node] + f*values_[node+1];
+}
+
+double TriggerEfficiencyTable::eval(double pt, double eta) const {
+  const int r = region(eta);
+  const int s = segment(pt);
+  if (r < 0 || s < 0)
+    return exact(pt, eta);
+  const double eff = lookup(pt, regionTable_[r], s);
+  return eff == eff ? eff : exact(pt, eta);
+}
+
+void TriggerEfficiencyTable::eval(const double * pt, const double * eta, size_t n, double * eff) const {
+  // tabulated values first, the few events needing the exact curve are flagged with NaN
+  for (size_t i=0; i<n; ++i) {
+    const int r = region(eta[i]);
+    const int s = segment(pt[i]);
+    eff[i] = (r < 0 || s < 0) ? std::numeric_limits<double>::quiet_NaN() : lookup(pt[i], regionTable_[r], s);
+  }
+  for (size_t i=0; i<n; ++i)
+    if (eff[i] != eff[i])
+      eff[i] = exact(pt[i], eta[i]);
+}
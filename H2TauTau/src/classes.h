@@ -2,8 +2,15 @@
 
 #include "DataFormats/Common/interface/Wrapper.h"
 #include "CMGTools/H2TauTau/interface/TriggerEfficiency.h"
+#include "CMGTools/H2TauTau/interface/TriggerEfficiencyTable.h"
 #include "CMGTools/H2TauTau/interface/METSignificance.h"
+#include "CMGTools/H2TauTau/interface/DiObjectShift.h"
+#include "CMGTools/H2TauTau/interface/DiTauPair.h"
+#include "CMGTools/H2TauTau/interface/SVfitResult.h"
+#include "CMGTools/H2TauTau/interface/WeightSums.h"
+#include "DataFormats/Common/interface/ValueMap.h"
 #include "CMGTools/H2TauTau/interface/HTTRecoilCorrector.h"
+#include "CMGTools/H2TauTau/interface/MEtSys.h"
 
 #include "FWCore/Utilities/interface/GCC11Compatibility.h"
 #ifdef CMS_NOCXX11
@@ -18,10 +25,25 @@ namespace {
   struct CMGTools_H2TauTau {
 
     TriggerEfficiency trigeff;
+    std::vector<TriggerEfficiency::FitJob> trigeffjobs_;
+    std::vector<TriggerEfficiency::FitResult> trigeffresults_;
     cmg::METSignificance metsig_;
     edm::Wrapper<cmg::METSignificance> metsige_;
     std::vector<cmg::METSignificance> metsigv_;
     edm::Wrapper<std::vector<cmg::METSignificance> > metsigve_;
+    cmg::DiObjectShift diobjshift_;
+    std::vector<cmg::DiObjectShift> diobjshiftv_;
+    edm::Wrapper<std::vector<cmg::DiObjectShift> > diobjshiftve_;
+    cmg::DiTauPair ditaupair_;
+    std::vector<cmg::DiTauPair> ditaupairv_;
+    edm::Wrapper<std::vector<cmg::DiTauPair> > ditaupairve_;
+    cmg::SVfitResult svfitres_;
+    std::vector<cmg::SVfitResult> svfitresv_;
+    edm::Wrapper<std::vector<cmg::SVfitResult> > svfitresve_;
+    edm::ValueMap<cmg::SVfitResult> svfitresm_;
+    edm::Wrapper<edm::ValueMap<cmg::SVfitResult> > svfitresme_;
+    cmg::WeightSums weightsums_;
+    edm::Wrapper<cmg::WeightSums> weightsumse_;
     HTTRecoilCorrector reccorr_;
   };
 }
@@ -1,125 +0,0 @@
-#include <cmath>
-#include "Math/GenVector/LorentzVector.h"
-#include "Math/GenVector/PtEtaPhiM4D.h"
-
-//// UTILITY FUNCTIONS NOT IN TFORMULA ALREADY
-
-float deltaPhi(float phi1, float phi2) {
-    float result = phi1 - phi2;
-    while (result > float(M_PI)) result -= float(2*M_PI);
-    while (result <= -float(M_PI)) result += float(2*M_PI);
-    return result;
-}
-
-float if3(bool cond, float iftrue, float iffalse) {
-    return cond ? iftrue : iffalse;
-}
-
-float deltaR2(float eta1, float phi1, float eta2, float phi2) {
-    float deta = std::abs(eta1-eta2);
-    float dphi = deltaPhi(phi1,phi2);
-    return deta*deta + dphi*dphi;
-}
-float deltaR(float eta1, float phi1, float eta2, float phi2) {
-    return std::sqrt(deltaR2(eta1,phi1,eta2,phi2));
-}
-
-float pt_2(float pt1, float phi1, float pt2, float phi2) {
-    phi2 -= phi1;
-    return hypot(pt1 + pt2 * std::cos(phi2), pt2*std::sin(phi2));
-}
-
-float mt_2(float pt1, float phi1, float pt2, float phi2) {
-    return std::sqrt(2*pt1*pt2*(1-std::cos(phi1-phi2)));
-}
-
-float mass_2_ene(float ene1, float eta1, float phi1, float m1, float ene2, float eta2, float phi2, float m2) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector unitp41(1.0,eta1,phi1,m1);
-    PtEtaPhiMVector unitp42(1.0,eta2,phi2,m2);
-    double theta1 = unitp41.Theta();
-    double theta2 = unitp42.Theta();
-    double pt1 = ene1*fabs(sin(theta1));
-    double pt2 = ene2*fabs(sin(theta2));
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    return (p41+p42).M();
-}
-
-float mass_2(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    return (p41+p42).M();
-}
-
-float pt_3(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3) {
-    phi2 -= phi1;
-    phi3 -= phi1;
-    return hypot(pt1 + pt2 * std::cos(phi2) + pt3 * std::cos(phi3), pt2*std::sin(phi2) + pt3*std::sin(phi3));
-}
-
-float mass_3(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2, float pt3, float eta3, float phi3, float m3) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    PtEtaPhiMVector p43(pt3,eta3,phi3,m3);
-    return (p41+p42+p43).M();
-}
-
-float pt_4(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3, float pt4, float phi4) {
-    phi2 -= phi1;
-    phi3 -= phi1;
-    phi4 -= phi1;
-    return hypot(pt1 + pt2 * std::cos(phi2) + pt3 * std::cos(phi3) + pt4 * std::cos(phi4), pt2*std::sin(phi2) + pt3*std::sin(phi3) + pt4*std::sin(phi4));
-}
- 
-float mass_4(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2, float pt3, float eta3, float phi3, float m3, float pt4, float eta4, float phi4, float m4) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    PtEtaPhiMVector p43(pt3,eta3,phi3,m3);
-    PtEtaPhiMVector p44(pt4,eta4,phi4,m4);
-    return (p41+p42+p43+p44).M();
-}
-
-float mt_llv(float ptl1, float phil1, float ptl2, float phil2, float ptv, float phiv) {
-    float px = ptl1*std::cos(phil1) + ptl2*std::cos(phil2) + ptv*std::cos(phiv);
-    float py = ptl1*std::sin(phil1) + ptl2*std::sin(phil2) + ptv*std::sin(phiv);
-    float ht = ptl1+ptl2+ptv;
-    return std::sqrt(std::max(0.f, ht*ht - px*px - py*py));
-}
-
-float mt_lllv(float ptl1, float phil1, float ptl2, float phil2, float ptl3, float phil3, float ptv, float phiv) {
-    float px = ptl1*std::cos(phil1) + ptl2*std::cos(phil2) + ptl3*std::cos(phil3) + ptv*std::cos(phiv);
-    float py = ptl1*std::sin(phil1) + ptl2*std::sin(phil2) + ptl3*std::sin(phil3) + ptv*std::sin(phiv);
-    float ht = ptl1+ptl2+ptl3+ptv;
-    return std::sqrt(std::max(0.f, ht*ht - px*px - py*py));
-}
-
-
-float mtw_wz3l(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2, float pt3, float eta3, float phi3, float m3, float mZ1, float met, float metphi) 
-{
-    if (abs(mZ1 - mass_2(pt1,eta1,phi1,m1,pt2,eta2,phi2,m2)) < 0.01) return mt_2(pt3,phi3,met,metphi);
-    if (abs(mZ1 - mass_2(pt1,eta1,phi1,m1,pt3,eta3,phi3,m3)) < 0.01) return mt_2(pt2,phi2,met,metphi);
-    if (abs(mZ1 - mass_2(pt2,eta2,phi2,m2,pt3,eta3,phi3,m3)) < 0.01) return mt_2(pt1,phi1,met,metphi);
-    return 0;
-}
-
-float u1_2(float met_pt, float met_phi, float ref_pt, float ref_phi) 
-{
-    float met_px = met_pt*std::cos(met_phi), met_py = met_pt*std::sin(met_phi);
-    float ref_px = ref_pt*std::cos(ref_phi), ref_py = ref_pt*std::sin(ref_phi);
-    float ux = - met_px + ref_px, uy = - met_px + ref_px;
-    return (ux*ref_px + uy*ref_py)/ref_pt;
-}
-float u2_2(float met_pt, float met_phi, float ref_pt, float ref_phi)
-{
-    float met_px = met_pt*std::cos(met_phi), met_py = met_pt*std::sin(met_phi);
-    float ref_px = ref_pt*std::cos(ref_phi), ref_py = ref_pt*std::sin(ref_phi);
-    float ux = - met_px + ref_px, uy = - met_px + ref_px;
-    return (ux*ref_py - uy*ref_px)/ref_pt;
-}
-
-
-void functions() {}
@@ -1,7 +1,5 @@
 #include <cmath>
 #include <smearer.h>
 
-TRandom *gSmearer_ = new TRandom3(0);
-
 void smearer() {
 }
@@ -1,15 +1,24 @@
 #ifndef TTHAnalysis_plotter_smearer_h
 #define TTHAnalysis_plotter_smearer_h
-#include <TRandom3.h>
+#include "CMGTools/RootTools/interface/CounterRandom.h"
 #include <cmath>
 
-
-extern TRandom *gSmearer_;
-inline double smearMC(double x, double mu, double sigma) { 
-    return x + gSmearer_->Gaus(mu,sigma); 
+//
+// Stateless MC smearing: the random numbers come from a counter-based
+// generator keyed by (run, lumi, event, object, stream), so the result for
+// a given object does not depend on the order, the chunking or the thread
+// in which the events are processed. Each helper that smears should use its
+// own stream id, so that the numbers of different quantities of the same
+// object are independent.
+//
+inline cmg::CounterRandom smearRandom(unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object, unsigned int stream) {
+    return cmg::CounterRandom(run, lumi, event, (stream << 16) | (object & 0xFFFF));
+}
+inline double smearMC(double x, double mu, double sigma, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object, unsigned int stream) { 
+    return x + smearRandom(run,lumi,event,object,stream).Gaus(mu,sigma); 
 }
-inline double logSmearMC(double x, double mu, double sigma) { 
-    return std::exp(std::log(x) + gSmearer_->Gaus(mu,sigma)); 
+inline double logSmearMC(double x, double mu, double sigma, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object, unsigned int stream) { 
+    return std::exp(std::log(x) + smearRandom(run,lumi,event,object,stream).Gaus(mu,sigma)); 
 }
 inline double shiftMC(double x, double delta) { 
     return x + delta; 
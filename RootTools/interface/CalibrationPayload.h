@@ -0,0 +1,189 @@
+#ifndef CMGTools_RootTools_CalibrationPayload_h
+#define CMGTools_RootTools_CalibrationPayload_h
+
+//
+// Flat binary payload for calibration tables (recoil corrections, MET
+// systematics, ...). The file is a header, a directory of named objects
+// sorted by name, and a data section of doubles; everything is 8-byte
+// aligned so that the file can be mmapped and used in place.
+//
+// Three object types are supported:
+//  - Histogram: explicit bin edges and contents, interpolated like TH1::Interpolate
+//  - Function:  a TF1 tabulated on a uniform grid, with its running integral
+//               and the fitted parameters and errors
+//  - Scalars:   a plain array of numbers
+//
+// usage:
+//    cmg::CalibrationPayloadWriter writer;
+//    writer.addFunction("u1Mean_1", *tf1, 1001);
+//    writer.write("calib.bin");
+//    ...
+//    cmg::CalibrationPayload payload("calib.bin");
+//    double y = payload.function("u1Mean_1").eval(x);
+//
+
+#include <cstddef>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class TF1;
+class TH1;
+
+namespace cmg {
+
+  namespace payload {
+    static const char     kMagic[8] = {'C','M','G','C','A','L','I','B'};
+    static const uint32_t kVersion  = 1;
+    static const size_t   kNameSize = 112;
+
+    enum ObjectType { kHistogram = 1, kFunction = 2, kScalars = 3 };
+
+    struct FileHeader {
+      char     magic[8];
+      uint32_t version;
+      uint32_t nObjects;
+      uint64_t size;      // total file size in bytes
+      uint64_t checksum;  // FNV-1a of everything after the header
+    };
+
+    struct ObjectHeader {
+      char     name[kNameSize];
+      uint32_t type;
+      uint32_t n;         // number of bins or grid points or scalars
+      uint32_t nPar;      // number of function parameters
+      uint32_t reserved;
+      uint64_t offset;    // byte offset of the data from the file start
+      double   xmin;
+      double   xmax;
+    };
+
+    uint64_t checksum(const char * data, size_t size);
+  }
+
+  // Histogram view: edges[n+1], contents[n]
+  class PayloadHistogram {
+  public:
+    PayloadHistogram() : n_(0), edges_(0), contents_(0) {}
+    PayloadHistogram(unsigned int n, const double * edges, const double * contents) :
+      n_(n), edges_(edges), contents_(contents) {}
+
+    unsigned int nBins() const { return n_; }
+    const double * edges() const { return edges_; }
+    const double * contents() const { return contents_; }
+
+    // 0-based bin index, -1 below and n above the axis
+    int findBin(double x) const;
+    double center(unsigned int bin) const { return 0.5*(edges_[bin]+edges_[bin+1]); }
+    // same as TH1::Interpolate
+    double interpolate(double x) const;
+
+  private:
+    unsigned int n_;
+    const double * edges_;
+    const double * contents_;
+  };
+
+  // Tabulated function view on n uniform points between xmin and xmax:
+  // values[n], integral[n] (running integral from xmin), parameters[nPar], errors[nPar]
+  class PayloadFunction {
+  public:
+    PayloadFunction() : n_(0), nPar_(0), xmin_(0), xmax_(1), step_(1), values_(0), integral_(0), params_(0), errors_(0) {}
+    PayloadFunction(unsigned int n, unsigned int nPar, double xmin, double xmax, const double * data);
+
+    unsigned int nPoints() const { return n_; }
+    unsigned int nPar() const { return nPar_; }
+    double xmin() const { return xmin_; }
+    double xmax() const { return xmax_; }
+    double parameter(unsigned int i) const { return params_[i]; }
+    double parError(unsigned int i) const { return errors_[i]; }
+
+    // linear interpolation; linear extrapolation from the edge intervals outside the grid
+    double eval(double x) const;
+    // integral from xmin to x, x clamped to the grid
+    double integral(double x) const;
+    double totalIntegral() const { return integral_[n_-1]; }
+    // x such that integral(x) = p*totalIntegral(), as TF1::GetQuantiles
+    double quantile(double p) const;
+
+    // TF1 backed by this table, for code that needs a TF1 interface;
+    // the payload must outlive the returned function
+    TF1 * asTF1(const std::string & name) const;
+
+  private:
+    unsigned int n_;
+    unsigned int nPar_;
+    double xmin_;
+    double xmax_;
+    double step_;
+    const double * values_;
+    const double * integral_;
+    const double * params_;
+    const double * errors_;
+  };
+
+  class CalibrationPayload {
+  public:
+    // mmap a payload file, checking magic, version, size and checksum
+    explicit CalibrationPayload(const std::string & fileName);
+    // use an in-memory image as produced by CalibrationPayloadWriter::image()
+    explicit CalibrationPayload(std::vector<char> & image);
+    ~CalibrationPayload();
+
+    // true if the file starts with the payload magic
+    static bool isPayload(const std::string & fileName);
+
+    const std::string & source() const { return source_; }
+    bool has(const std::string & name) const { return find(name) != 0; }
+    std::vector<std::string> names() const;
+
+    PayloadHistogram histogram(const std::string & name) const;
+    PayloadFunction function(const std::string & name) const;
+    std::vector<double> scalars(const std::string & name) const;
+
+  private:
+    CalibrationPayload(const CalibrationPayload &);
+    CalibrationPayload & operator=(const CalibrationPayload &);
+
+    void init(size_t size);
+    const payload::ObjectHeader * find(const std::string & name) const;
+    const payload::ObjectHeader & get(const std::string & name, payload::ObjectType type) const;
+
+    std::string source_;
+    std::vector<char> image_;
+    void * map_;
+    size_t mapSize_;
+    const char * data_;
+    const payload::ObjectHeader * objects_;
+    uint32_t nObjects_;
+  };
+
+  class CalibrationPayloadWriter {
+  public:
+    void addHistogram(const std::string & name, const TH1 & hist);
+    void addHistogram(const std::string & name, const std::vector<double> & edges, const std::vector<double> & contents);
+    // tabulate f on nPoints between its range limits, or between xmin and xmax if xmin<xmax
+    void addFunction(const std::string & name, const TF1 & f, unsigned int nPoints, double xmin = 0, double xmax = 0);
+    void addScalars(const std::string & name, const std::vector<double> & values);
+
+    std::vector<char> image() const;
+    void write(const std::string & fileName) const;
+
+  private:
+    struct Entry {
+      payload::ObjectType type;
+      unsigned int n;
+      unsigned int nPar;
+      double xmin;
+      double xmax;
+      std::vector<double> data;
+    };
+    void add(const std::string & name, const Entry & entry);
+
+    std::map<std::string, Entry> entries_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef CMGTools_RootTools_CounterRandom_h
+#define CMGTools_RootTools_CounterRandom_h
+
+//
+// Counter-based random numbers (Philox4x32-10, Salmon et al., SC11): the
+// i-th number of a stream is a pure function of the key and of i, so a
+// stream keyed by (run, lumi, event, variation) gives the same numbers
+// whatever the order, the job splitting or the thread in which events are
+// processed.
+//
+// usage:
+//    cmg::CounterRandom rnd(run, lumi, event, variation);
+//    double u = rnd.Uniform(0,1);
+//    double g = rnd.Gaus(0,1);
+//    rnd.restart();  // same numbers again
+//
+
+#include <cmath>
+#include <stdint.h>
+
+namespace cmg {
+
+  class CounterRandom {
+  public:
+    CounterRandom(uint32_t run = 0, uint32_t lumi = 0, uint64_t event = 0, uint32_t variation = 0) {
+      setKey(run, lumi, event, variation);
+    }
+
+    // select the stream and restart it
+    void setKey(uint32_t run, uint32_t lumi, uint64_t event, uint32_t variation = 0) {
+      key_[0] = run;
+      key_[1] = variation;
+      ctr_[0] = uint32_t(event);
+      ctr_[1] = uint32_t(event >> 32);
+      ctr_[2] = lumi;
+      restart();
+    }
+
+    void restart() {
+      ctr_[3] = 0;
+      nLeft_ = 0;
+      hasGaus_ = false;
+    }
+
+    uint32_t next32() {
+      if (nLeft_ == 0) {
+        philox(ctr_, key_, block_);
+        ++ctr_[3];
+        nLeft_ = 4;
+      }
+      return block_[4 - nLeft_--];
+    }
+
+    // uniform in (0,1), 0 and 1 excluded
+    double Rndm() { return (next32() + 0.5) * (1. / 4294967296.); }
+    double Uniform(double x1, double x2) { return x1 + (x2 - x1) * Rndm(); }
+
+    // Box-Muller, the second number of each pair is kept for the next call
+    double Gaus(double mean = 0., double sigma = 1.) {
+      if (hasGaus_) {
+        hasGaus_ = false;
+        return mean + sigma * gaus_;
+      }
+      const double r = std::sqrt(-2. * std::log(Rndm()));
+      const double phi = 2. * M_PI * Rndm();
+      gaus_ = r * std::sin(phi);
+      hasGaus_ = true;
+      return mean + sigma * r * std::cos(phi);
+    }
+
+    static void philox(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+      uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+        const uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+        const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c0 = n0;
+        c1 = uint32_t(p1);
+        c2 = n2;
+        c3 = uint32_t(p0);
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+      }
+      out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+
+  private:
+    uint32_t key_[2];
+    uint32_t ctr_[4];
+    uint32_t block_[4];
+    int nLeft_;
+    bool hasGaus_;
+    double gaus_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef CMGTools_RootTools_GridRhoSigmaEstimator_h
+#define CMGTools_RootTools_GridRhoSigmaEstimator_h
+
+//
+// rho and sigma of the particles on one or more rapidity-phi grids, as
+// fastjet::GridMedianBackgroundEstimator (fastjet >= 3.1, no selector):
+// for each grid the scalar pt in each cell is summed, rho is the median of
+// the cell pt divided by the cell area, and sigma the distance from the median
+// to the 15.87% quantile divided by sqrt(cell area). The quantiles are those
+// of fastjet's _percentile, found with nth_element instead of a full sort, and
+// the particle rapidity and phi are computed as in fastjet::PseudoJet, so the
+// results are the same bit by bit (test/testGridRhoSigmaEstimator.cpp).
+//
+// All the grids are filled in one pass over the particles, and the cell
+// buffers are kept between events.
+//
+// usage:
+//    cmg::GridRhoSigmaEstimator est;
+//    size_t all = est.addGrid(-5.0, 5.0, 0.55);
+//    est.reset();
+//    for (...) est.add(px, py, pz, e);
+//    est.compute();
+//    double rho = est.rho(all), sigma = est.sigma(all);
+//
+
+#include <cstddef>
+#include <vector>
+
+namespace cmg {
+
+  class GridRhoSigmaEstimator {
+  public:
+    // cells of about spacing x spacing between rapidities rapMin and rapMax; returns the index of the grid
+    size_t addGrid(double rapMin, double rapMax, double spacing);
+    size_t nGrids() const { return grids_.size(); }
+
+    // start a new event
+    void reset();
+    void add(double px, double py, double pz, double e);
+    void compute();
+
+    double rho(size_t iGrid) const { return grids_[iGrid].rho; }
+    double sigma(size_t iGrid) const { return grids_[iGrid].sigma; }
+
+  private:
+    struct Grid {
+      double rapMin, rapMax;
+      int nRap, nPhi;
+      double invDRap, invDPhi, cellArea;
+      size_t offset;
+      double rho, sigma;
+    };
+
+    // fastjet::BackgroundEstimatorBase::_percentile of the n values, of which the nSmallest
+    // first are the smallest ones; nSmallest is updated for the next call with a lower fraction
+    static double percentile(double *values, size_t n, size_t &nSmallest, double fraction);
+
+    std::vector<Grid> grids_;
+    // scalar pt of the cells of all the grids, grid after grid
+    std::vector<double> pt_;
+    std::vector<double> work_;
+  };
+
+}
+
+#endif
@@ -2,6 +2,9 @@
 #define CMGTools_Utilities_RecoilCorrector_H
 
 
+#include <cstddef>
+#include <map>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
 #include <string>
@@ -15,6 +18,7 @@
 #include "TF1.h"
 #include "TMath.h"
 #include "TRandom3.h"
+#include "CMGTools/RootTools/interface/CounterRandom.h"
 
 //
 // ** apply recoil corrections **
@@ -28,6 +32,22 @@
 //
 // where leptonPt, leptonPhi are dilepton kinematics for z->ll and single lepton kinematics for w->lnu
 //
+// Input files can be the ROOT files with the fits or payloads made from them by
+// RecoilCorrector::WritePayload, which are mmapped instead of parsed.
+//
+// The fits are tabulated in gen boson pt when they are read (one table per
+// function and input file, so the Z, data and MC fits read from the same file
+// share them) and evaluated by linear interpolation below 1 TeV; the TF1s are
+// only evaluated above, or everywhere after SetExactEvaluation(true).
+//
+// The smearing is drawn from a TRandom3 seeded from the gen boson phi. After
+// SetRandomKey it is drawn from a counter-based stream keyed by the event and
+// the variation instead, which does not depend on the order or on the thread in
+// which the events are corrected. The batch CorrectAll takes the keys per event
+// in a stream of its own, and leaves the one of SetRandomKey as it was.
+//
+
+namespace cmg { class CalibrationPayload; }
 
 using namespace std;
 
@@ -35,11 +55,15 @@ class RecoilCorrector
 {
   
 public:
-  RecoilCorrector() { /* empty constructor only for ROOT dictionaries */ }
+  RecoilCorrector() : fExact(false), fKeyed(false) { /* empty constructor only for ROOT dictionaries */ }
   RecoilCorrector(string iNameZDat, int iSeed=0xDEADBEEF);
   RecoilCorrector(string iNameZDat1, string iPrefix, int iSeed=0xDEADBEEF);
   ~RecoilCorrector();
   void CorrectAll(double &met, double &metphi, double iGenPt, double iGenPhi, double iLepPt, double iLepPhi,double &iU1,double &iU2,double iFluc,double iScale=0,int njet=0);
+  // CorrectAll for n events, all arrays have length n; the events are processed by njet category
+  // if iRun, iLumi and iEvent are given, each event is smeared with the stream of (run,lumi,event,iVariation)
+  void CorrectAll(double *met, double *metphi, const double *iGenPt, const double *iGenPhi, const double *iLepPt, const double *iLepPhi,double *iU1,double *iU2,const int *njet,size_t n,double iFluc,double iScale=0,
+		  const unsigned int *iRun=0,const unsigned int *iLumi=0,const unsigned long long *iEvent=0,unsigned int iVariation=0);
   void Correct(double &pfmet, double &pfmetphi, double &trkmet, double &trkmetphi, 
 	       double iGenPt, double iGenPhi, double iLepPt, double iLepPhi,double iFluc    ,double iScale=0,int njet=0);
   void CorrectType1(double &pfmet, double &pfmetphi,double iGenPt,double iGenPhi,double iLepPt,double iLepPhi,double &iU1,double &iU2,double iFlucU2,double iFlucU1,double iScale=0,int njet=0);
@@ -48,6 +72,14 @@ public:
 		   double iGenPt, double iGenPhi, double iLepPt, double iLepPhi,double iFluc,double iScale=0,int njet=0);
   void addDataFile(std::string iNameDat);
   void addMCFile  (std::string iNameMC);
+  // tabulate all the fits in iRootFile into a payload file
+  static void WritePayload(std::string iRootFile, std::string iPayloadFile);
+  // evaluate the TF1s instead of their tables (for validation)
+  void SetExactEvaluation(bool iExact) { fExact = iExact; }
+  // smear the next corrections with the counter-based stream of this event and variation (to be set for each event)
+  void SetRandomKey(unsigned int iRun,unsigned int iLumi,unsigned long long iEvent,unsigned int iVariation=0) { fCounterRandom.setKey(iRun,iLumi,iEvent,iVariation); fKeyed = true; }
+  // back to the TRandom3 seeded from the gen boson phi
+  void ClearRandomKey() { fKeyed = false; }
 protected:
   enum Recoil { 
     PFU1,
@@ -68,6 +100,20 @@ protected:
     TKS2U2
   };
 
+  // random numbers of one correction, from fRandom or from the counter-based stream
+  class Random {
+  public:
+    Random(TRandom3 *iRandom) : fRandom(iRandom), fCounter(0) {}
+    Random(cmg::CounterRandom *iCounter) : fRandom(0), fCounter(iCounter) {}
+    double Uniform(double iMin,double iMax) { return fCounter ? fCounter->Uniform(iMin,iMax) : fRandom->Uniform(iMin,iMax); }
+    double Gaus(double iMean,double iSigma) { return fCounter ? fCounter->Gaus(iMean,iSigma) : fRandom->Gaus(iMean,iSigma); }
+  private:
+    TRandom3 *fRandom;
+    cmg::CounterRandom *fCounter;
+  };
+  // the stream for the correction of an event: the counter-based one restarted if a key is set, fRandom seeded from iGenPhi otherwise
+  Random random(double iGenPhi);
+
   void readRecoil(std::vector<TF1*> &iU1Fit,std::vector<TF1*> &iU1MRMSFit,std::vector<TF1*> &iU1RMS1Fit,std::vector<TF1*> &iU1RMS2Fit,
 		  std::vector<TF1*> &iU2Fit,std::vector<TF1*> &iU2MRMSFit,std::vector<TF1*> &iU2RMS1Fit,std::vector<TF1*> &iU2RMS2Fit,
 		  std::string iFName,std::string iPrefix); 
@@ -77,7 +123,7 @@ protected:
 		std::vector<TF1*> &iF1F2U1U2Corr,std::vector<TF1*> &iF1F2U2U1Corr,int iType=2);
 
   void metDistribution(double &iMet,double &iMPhi,double iGenPt,double iGenPhi,
-		       double iLepPt,double iLepPhi,TRandom3 *iRand,
+		       double iLepPt,double iLepPhi,Random *iRand,
 		       TF1 *iU1RZFit, 
 		       TF1 *iU1MSZFit, 
 		       TF1 *iU1S1ZFit,
@@ -90,7 +136,7 @@ protected:
 
   void metDistribution(double &iPFMet,double &iPFMPhi,double &iTKMet,double &iTKMPhi,
 		       double iGenPt,double iGenPhi,
-		       double iLepPt,double iLepPhi,TRandom3 *iRand,
+		       double iLepPt,double iLepPhi,Random *iRand,
 		       TF1 *iU1RZPFFit,  TF1 *iU1RZTKFit, 
 		       TF1 *iU1MSZPFFit, TF1 *iU1MSZTKFit, 
 		       TF1 *iU1S1ZPFFit, TF1 *iU1S1ZTKFit,
@@ -104,7 +150,7 @@ protected:
 		       double &iU1,double &iU2,double iFluc=0,double iScale=0);
 
   void metDistributionType1(double &iMet,double &iMPhi,double iGenPt,double iGenPhi,
-			    double iLepPt,double iLepPhi,TRandom3 *iRand,
+			    double iLepPt,double iLepPhi,Random *iRand,
 			    TF1 *iU1RZDatFit,  TF1 *iU1RZMCFit,
 			    TF1 *iU1MSZDatFit, TF1 *iU1MSZMCFit, 
 			    TF1 *iU2MSZDatFit, TF1 *iU2MSZMCFit,
@@ -149,10 +195,22 @@ protected:
   double correlatedSeed(double iVal, double iCorr1,double iCorr2,double iCorr3,double iSeed0,double iSeed1,double iSeed2,double iSeed3);
   double deCorrelate   (double iVal, double iCorr1,double iCorr2,double iCorr3,double iSeed0,double iSeed1,double iSeed2,double iSeed3);
   TF1*   getFunc(bool iMC, Recoil iType);
+  cmg::CalibrationPayload* openPayload(std::string iFName);
+  bool   hasFunction (TFile *iFile, cmg::CalibrationPayload *iPayload, std::string iName);
+  TF1*   findFunction(TFile *iFile, cmg::CalibrationPayload *iPayload, std::string iName);
   double CorrVal(double iPt,double iVal,Recoil iType);
+  double Eval(const TF1 *iFit,double iPt) const;
+  void   tabulate(std::string iFName,const std::vector<TF1*> &iFits);
   //void   Correct(double &met, double &metphi, double lGenPt, double lGenPhi, double lepPt, double lepPhi,double iFluc,int njet);
 
   TRandom3 *fRandom; 
+  std::map<std::string,cmg::CalibrationPayload*> fPayloads;
+  // fit values on the gen pt grid, by input file and function name
+  std::map<std::string,std::vector<double> > fTables;
+  std::unordered_map<const TF1*,const double*> fTableOf;
+  bool fExact;
+  cmg::CounterRandom fCounterRandom;
+  bool fKeyed;
   vector<TF1*> fF1U1Fit; vector<TF1*> fF1U1RMSSMFit; vector<TF1*> fF1U1RMS1Fit; vector<TF1*> fF1U1RMS2Fit; 
   vector<TF1*> fF1U2Fit; vector<TF1*> fF1U2RMSSMFit; vector<TF1*> fF1U2RMS1Fit; vector<TF1*> fF1U2RMS2Fit; 
   vector<TF1*> fF2U1Fit; vector<TF1*> fF2U1RMSSMFit; vector<TF1*> fF2U1RMS1Fit; vector<TF1*> fF2U1RMS2Fit; 
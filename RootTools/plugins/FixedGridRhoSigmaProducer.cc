@@ -0,0 +1,77 @@
+// rho and sigma on fixed rapidity-phi grids, without fastjet; same results as
+// FixedGridRhoProducerFastjet and FixedGridSigmaProducerFastjet
+
+#include "CMGTools/RootTools/plugins/FixedGridRhoSigmaProducer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+using namespace std;
+
+FixedGridRhoSigmaProducer::FixedGridRhoSigmaProducer(const edm::ParameterSet& iConfig) :
+  checkFastjet_( iConfig.getUntrackedParameter<bool>("checkFastjet", false) )
+{
+  pfCandidatesTag_ = iConfig.getParameter<edm::InputTag>("pfCandidatesTag");
+
+  const std::vector<edm::ParameterSet> grids = iConfig.getParameter<std::vector<edm::ParameterSet> >("grids");
+  for ( std::vector<edm::ParameterSet>::const_iterator grid = grids.begin(); grid != grids.end(); ++grid ) {
+    const std::string label = grid->getParameter<std::string>("label");
+    const double maxRapidity = grid->getParameter<double>("maxRapidity");
+    const double minRapidity = grid->exists("minRapidity") ? grid->getParameter<double>("minRapidity") : -maxRapidity;
+    const double gridSpacing = grid->getParameter<double>("gridSpacing");
+    if ( !(minRapidity < maxRapidity) || !(gridSpacing > 0) )
+      throw cms::Exception("FixedGridRhoSigmaProducer") << "bad grid " << label << ": rapidity " << minRapidity << " to " << maxRapidity << ", spacing " << gridSpacing;
+    estimator_.addGrid(minRapidity, maxRapidity, gridSpacing);
+    labels_.push_back(label);
+    maxRapidities_.push_back(maxRapidity);
+    gridSpacings_.push_back(gridSpacing);
+    symmetric_.push_back(minRapidity == -maxRapidity);
+    produces<double>(label);
+    produces<double>(label + "Rho");
+  }
+
+  input_pfcoll_token_ = consumes<edm::View<reco::Candidate> >(pfCandidatesTag_);
+
+}
+
+FixedGridRhoSigmaProducer::~FixedGridRhoSigmaProducer(){} 
+
+void FixedGridRhoSigmaProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+   edm::Handle< edm::View<reco::Candidate> > pfColl;
+   iEvent.getByToken(input_pfcoll_token_, pfColl);
+
+   estimator_.reset();
+   for ( edm::View<reco::Candidate>::const_iterator ibegin = pfColl->begin(),
+	   iend = pfColl->end(), i = ibegin; i != iend; ++i ){
+     estimator_.add(i->px(), i->py(), i->pz(), i->energy());
+   }
+   estimator_.compute();
+
+   if ( checkFastjet_ ) checkFastjet(*pfColl);
+
+   for ( size_t ig = 0; ig < labels_.size(); ++ig ) {
+     std::auto_ptr<double> outputSigma(new double(estimator_.sigma(ig)));
+     iEvent.put(outputSigma, labels_[ig]);
+     std::auto_ptr<double> outputRho(new double(estimator_.rho(ig)));
+     iEvent.put(outputRho, labels_[ig] + "Rho");
+   }
+}
+
+void FixedGridRhoSigmaProducer::checkFastjet(const edm::View<reco::Candidate>& pfColl) {
+
+   std::vector<fastjet::PseudoJet> inputs;
+   for ( edm::View<reco::Candidate>::const_iterator i = pfColl.begin(); i != pfColl.end(); ++i ){
+     inputs.push_back( fastjet::PseudoJet(i->px(), i->py(), i->pz(), i->energy()) );
+   }
+   for ( size_t ig = 0; ig < labels_.size(); ++ig ) {
+     if ( !symmetric_[ig] ) continue;
+     fastjet::GridMedianBackgroundEstimator bge(maxRapidities_[ig], gridSpacings_[ig]);
+     bge.set_particles(inputs);
+     if ( bge.rho() != estimator_.rho(ig) || bge.sigma() != estimator_.sigma(ig) )
+       throw cms::Exception("FixedGridRhoSigmaProducer") << "grid " << labels_[ig] << ": rho " << estimator_.rho(ig) << " sigma " << estimator_.sigma(ig)
+							 << ", fastjet gives rho " << bge.rho() << " sigma " << bge.sigma();
+   }
+}
+
+DEFINE_FWK_MODULE(FixedGridRhoSigmaProducer);
@@ -0,0 +1,47 @@
+// rho and sigma on fixed rapidity-phi grids, without fastjet; same results as
+// FixedGridRhoProducerFastjet and FixedGridSigmaProducerFastjet
+
+#ifndef CMGTools_RootTools_plugins_FixedGridRhoSigmaProducer_h
+#define CMGTools_RootTools_plugins_FixedGridRhoSigmaProducer_h
+
+#include "FWCore/Framework/interface/stream/EDProducer.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "DataFormats/Common/interface/View.h"
+#include "CMGTools/RootTools/interface/GridRhoSigmaEstimator.h"
+#include "fastjet/tools/GridMedianBackgroundEstimator.hh"
+
+#include <string>
+#include <vector>
+
+// For each PSet of grids (label, maxRapidity, gridSpacing and optionally
+// minRapidity, -maxRapidity by default) puts sigma as a double with instance
+// label <label> and rho with instance label <label>Rho; all the grids are
+// filled in one pass over the candidates. With checkFastjet the results are
+// compared with fastjet::GridMedianBackgroundEstimator (symmetric grids only).
+class FixedGridRhoSigmaProducer : public edm::stream::EDProducer<> {
+
+ public:
+  explicit FixedGridRhoSigmaProducer(const edm::ParameterSet& iConfig);
+  virtual ~FixedGridRhoSigmaProducer();
+
+ private:
+  virtual void produce(edm::Event&, const edm::EventSetup&);
+
+  void checkFastjet(const edm::View<reco::Candidate>& pfColl);
+
+  edm::InputTag pfCandidatesTag_;
+  std::vector<std::string> labels_;
+  std::vector<double> maxRapidities_;
+  std::vector<double> gridSpacings_;
+  std::vector<bool> symmetric_;
+  bool checkFastjet_;
+  cmg::GridRhoSigmaEstimator estimator_;
+
+  edm::EDGetTokenT<edm::View<reco::Candidate> > input_pfcoll_token_;
+
+};
+
+
+#endif
@@ -7,14 +7,32 @@
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "PhysicsTools/Utilities/interface/Lumi3DReWeighting.h"
 
+#include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h"
+
 #include <TH1D.h>
 #include <TFile.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace std;
 
+// Weights MC events to data with the 3D (out-of-time) pileup reweighting.
+//
+// The 50x50x50 weight matrix of edm::Lumi3DReWeighting takes long to compute
+// and is the same for all the jobs with the same inputs. If cacheDir is set,
+// it is saved there in a file named after a hash of the input profiles, and
+// read back from it by the next jobs. When it has to be computed, initThreads
+// > 0 computes it here on that many threads (same sums, in the same order, as
+// Lumi3DReWeighting::weight3D_init) instead of with Lumi3DReWeighting.
 class PileUpWeight3DProducer : public edm::EDProducer{
  public:
   PileUpWeight3DProducer(const edm::ParameterSet& ps);
@@ -23,8 +41,16 @@ class PileUpWeight3DProducer : public edm::EDProducer{
   virtual void produce(edm::Event&, const edm::EventSetup&);
 
  private:
-  
-  edm::Lumi3DReWeighting * LumiWeights_;
+
+  enum { kNPU = 50, kNWeights = kNPU*kNPU*kNPU };
+
+  static unsigned long long hashInputs(const TH1* histMC, const TH1* histData, double scaleFactor);
+  bool readCache(const std::string& fileName, unsigned long long key);
+  void writeCache(const std::string& fileName, unsigned long long key) const;
+  void computeWeights(const TH1* histMC, const TH1* histData, double scaleFactor, int nThreads);
+
+  // weight for (npu(bx=-1), npu(bx=0), npu(bx=+1)) in weights_[(i*kNPU+j)*kNPU+k]
+  std::vector<double> weights_;
   bool verbose_;
 };
 
@@ -48,13 +74,44 @@ PileUpWeight3DProducer::PileUpWeight3DProducer(const edm::ParameterSet& ps):
   if(!histMC) 
     throw cms::Exception("PileUpWeight3DProducer")<<"MC histogram doesn't exist in file "<<fileMC.GetName();
 
+  const float scaleFactor = 1.0;//scale factor can be used for systematic variations
+  const std::string cacheDir = ps.getUntrackedParameter<std::string>("cacheDir","");
+  const int nThreads = ps.getUntrackedParameter<int>("initThreads",0);
+
+  unsigned long long key = hashInputs(histMC, histData, scaleFactor);
+  char cacheName[32];
+  snprintf(cacheName, sizeof(cacheName), "/Weight3D_%016llx.bin", key);
+  const std::string cacheFile = cacheDir + cacheName;
 
-  LumiWeights_ = new edm::Lumi3DReWeighting(ps.getParameter<std::string>("inputHistMC").c_str()
-					    ,ps.getParameter<std::string>("inputHistData").c_str()
-					    , "pileup"
-					    , "pileup"
-					    , "");
-  LumiWeights_->weight3D_init(1.0);//scale factor can be used for systematic variations
+  if(cacheDir.empty() || !readCache(cacheFile, key)) {
+    if(nThreads > 0) {
+      //normalized copies, as in Lumi3DReWeighting
+      std::auto_ptr<TH1> normMC( (TH1*)histMC->Clone() );
+      std::auto_ptr<TH1> normData( (TH1*)histData->Clone() );
+      normMC->SetDirectory(0);
+      normData->SetDirectory(0);
+      normMC->Scale( 1.0/normMC->Integral() );
+      normData->Scale( 1.0/normData->Integral() );
+      computeWeights(normMC.get(), normData.get(), scaleFactor, nThreads);
+    }
+    else {
+      edm::Lumi3DReWeighting lumiWeights(ps.getParameter<std::string>("inputHistMC").c_str()
+					 ,ps.getParameter<std::string>("inputHistData").c_str()
+					 , "pileup"
+					 , "pileup"
+					 , "");
+      lumiWeights.weight3D_init(scaleFactor);
+      weights_.resize(kNWeights);
+      for(int i=0; i<kNPU; ++i)
+	for(int j=0; j<kNPU; ++j)
+	  for(int k=0; k<kNPU; ++k)
+	    weights_[(i*kNPU+j)*kNPU+k] = lumiWeights.weight3D(i,j,k);
+    }
+    if(!cacheDir.empty())
+      writeCache(cacheFile, key);
+  }
+  else if( verbose_ )
+    cout<<" 3D pileup weights read from "<<cacheFile<<endl;
 
   produces<double>();
 
@@ -63,15 +120,150 @@ PileUpWeight3DProducer::PileUpWeight3DProducer(const edm::ParameterSet& ps):
 
 
 PileUpWeight3DProducer::~PileUpWeight3DProducer() {
-  delete  LumiWeights_;
+}
+
+
+unsigned long long PileUpWeight3DProducer::hashInputs(const TH1* histMC, const TH1* histData, double scaleFactor) {
+
+  //FNV-1a of the binning and contents of the input histograms and of the parameters
+  unsigned long long hash = 14695981039346656037ULL;
+  std::vector<double> values;
+  values.push_back(1.);//version of the weight computation and of the cache format
+  values.push_back(scaleFactor);
+  const TH1* hists[2] = { histMC, histData };
+  for(int ih=0; ih<2; ++ih) {
+    values.push_back(hists[ih]->GetNbinsX());
+    for(int ib=1; ib<=hists[ih]->GetNbinsX(); ++ib) {
+      values.push_back(hists[ih]->GetBinCenter(ib));
+      values.push_back(hists[ih]->GetBinContent(ib));
+    }
+  }
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&values[0]);
+  for(size_t ib=0; ib<values.size()*sizeof(double); ++ib) {
+    hash ^= bytes[ib];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+bool PileUpWeight3DProducer::readCache(const std::string& fileName, unsigned long long key) {
+
+  FILE* file = fopen(fileName.c_str(), "rb");
+  if(!file) return false;
+  unsigned long long fileKey = 0;
+  std::vector<double> weights(kNWeights);
+  bool ok = fread(&fileKey, sizeof(fileKey), 1, file) == 1 && fileKey == key
+    && fread(&weights[0], sizeof(double), kNWeights, file) == size_t(kNWeights);
+  fclose(file);
+  if(ok) weights_.swap(weights);
+  else edm::LogWarning("PileUpWeight3DProducer")<<"ignoring bad cache file "<<fileName;
+  return ok;
+}
+
+
+void PileUpWeight3DProducer::writeCache(const std::string& fileName, unsigned long long key) const {
+
+  //written under a temporary name and renamed, so that concurrent jobs never read a partial file
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%d.tmp", int(getpid()));
+  const std::string tmpName = fileName + suffix;
+  FILE* file = fopen(tmpName.c_str(), "wb");
+  bool ok = file
+    && fwrite(&key, sizeof(key), 1, file) == 1
+    && fwrite(&weights_[0], sizeof(double), kNWeights, file) == size_t(kNWeights);
+  if(file) ok = (fclose(file) == 0) && ok;
+  if(ok) ok = rename(tmpName.c_str(), fileName.c_str()) == 0;
+  if(!ok) {
+    remove(tmpName.c_str());
+    edm::LogWarning("PileUpWeight3DProducer")<<"could not write cache file "<<fileName;
+  }
+  else if( verbose_ )
+    cout<<" 3D pileup weights written to "<<fileName<<endl;
+}
+
+
+void PileUpWeight3DProducer::computeWeights(const TH1* histMC, const TH1* histData, double scaleFactor, int nThreads) {
+
+  double factorial[kNPU];
+  factorial[0] = 1.;
+  double base = 1.;
+  for (int i = 1; i<kNPU; ++i) {
+    base = base*float(i);
+    factorial[i] = base;
+  }
+
+  //poisson probabilities of 0..kNPU-1 interactions for the mean of each bin, and the bin contents;
+  //the MC means are truncated to integers as in Lumi3DReWeighting
+  const TH1* hists[2] = { histMC, histData };
+  std::vector<double> probs[2];
+  std::vector<double> contents[2];
+  for(int ih=0; ih<2; ++ih) {
+    const int nbins = hists[ih]->GetNbinsX();
+    probs[ih].resize(nbins*kNPU);
+    contents[ih].resize(nbins);
+    for(int ib=1; ib<=nbins; ++ib) {
+      const double mean = ih==0 ? double(int(hists[ih]->GetBinCenter(ib))) : hists[ih]->GetBinCenter(ib)*float(scaleFactor);
+      if(mean<0.)
+	throw cms::Exception("PileUpWeight3DProducer")<<"pileup histogram with a negative number of interactions";
+      const double expval = mean==0. ? 1. : exp(-1.*mean);
+      double powerSer = 1.;
+      for(int i=0; i<kNPU; ++i) {
+	if(i>0) powerSer = powerSer*mean;
+	probs[ih][(ib-1)*kNPU+i] = powerSer/factorial[i]*expval;
+      }
+      contents[ih][ib-1] = hists[ih]->GetBinContent(ib);
+    }
+  }
+
+  //the matrices are filled by slices of the first index, one thread per slice
+  weights_.assign(kNWeights, 0.);
+  std::vector<std::thread> threads;
+  const int nSlices = std::min(nThreads, int(kNPU));
+  for(int it=0; it<nSlices; ++it) {
+    threads.push_back(std::thread([&, it]() {
+      std::vector<double> ints[2];
+      for(int ih=0; ih<2; ++ih) ints[ih].resize(kNPU*kNPU);
+      for(int i=it; i<kNPU; i+=nSlices) {
+	for(int ih=0; ih<2; ++ih) {
+	  std::fill(ints[ih].begin(), ints[ih].end(), 0.);
+	  for(size_t ib=0; ib<contents[ih].size(); ++ib) {
+	    const double* prob = &probs[ih][ib*kNPU];
+	    const double xweight = contents[ih][ib];
+	    for(int j=0; j<kNPU; ++j)
+	      for(int k=0; k<kNPU; ++k)
+		ints[ih][j*kNPU+k] = ints[ih][j*kNPU+k] + prob[i]*prob[j]*prob[k]*xweight;
+	  }
+	}
+	for(int jk=0; jk<kNPU*kNPU; ++jk)
+	  weights_[i*kNPU*kNPU+jk] = ints[0][jk]>0. ? ints[1][jk]/ints[0][jk] : 0.;
+      }
+    }));
+  }
+  for(size_t it=0; it<threads.size(); ++it) threads[it].join();
 }
 
 
 void PileUpWeight3DProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup){
 
   //method from https://twiki.cern.ch/twiki/bin/viewauth/CMS/PileupMCReweightingUtilities#3D_Reweighting
-  edm::EventBase* iEventB = dynamic_cast<edm::EventBase*>(&iEvent);
-  double mcPUPWeight = LumiWeights_->weight3D( (*iEventB) );
+  //as Lumi3DReWeighting::weight3D, on the weights computed or read in the constructor
+  edm::Handle<std::vector< PileupSummaryInfo > >  PupInfo;
+  iEvent.getByLabel(edm::InputTag("addPileupInfo"), PupInfo);
+
+  int npm1=-1, np0=-1, npp1=-1;
+  for( std::vector<PileupSummaryInfo>::const_iterator PVI = PupInfo->begin(); PVI != PupInfo->end(); ++PVI) {
+    if(PVI->getBunchCrossing() == -1) npm1 = PVI->getPU_NumInteractions();
+    if(PVI->getBunchCrossing() == 0) np0 = PVI->getPU_NumInteractions();
+    if(PVI->getBunchCrossing() == 1) npp1 = PVI->getPU_NumInteractions();
+  }
+  npm1 = std::max(std::min(npm1,kNPU-1),0);
+  np0 = std::max(std::min(np0,kNPU-1),0);
+  npp1 = std::max(std::min(npp1,kNPU-1),0);
+  double mcPUPWeight = weights_[(npm1*kNPU+np0)*kNPU+npp1];
+
+  if( verbose_ )
+    cout<<" npu="<<npm1<<","<<np0<<","<<npp1<<" weight="<<mcPUPWeight<<endl;
 
   std::auto_ptr<double> output( new double( mcPUPWeight ) ); 
   iEvent.put( output );
@@ -79,4 +271,3 @@ void PileUpWeight3DProducer::produce(edm::Event& iEvent, const edm::EventSetup&
 }
 
 DEFINE_FWK_MODULE(PileUpWeight3DProducer);
-
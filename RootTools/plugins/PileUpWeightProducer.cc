@@ -11,11 +11,22 @@
 #include <TH1D.h>
 #include <TFile.h>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
+// Weights MC events to the pileup profile of data.
+//
+// Besides the nominal inputHistData, any number of other data profiles can be
+// given in inputHistDataVariations (e.g. the up and down minimum bias cross
+// section variations). The ratios to the MC profile are computed once, on the
+// integer number of interactions, and the weights of an event are read from
+// them by index. The nominal weight is put as a
+// double as before, and all the weights (nominal first, then the variations
+// in the configured order) as a std::vector<double> labelled "variations".
 class PileUpWeightProducer : public edm::EDProducer{
  public:
   PileUpWeightProducer(const edm::ParameterSet& ps);
@@ -25,56 +36,67 @@ class PileUpWeightProducer : public edm::EDProducer{
 
  private:
 
+  // normalized contents of the "pileup" histogram of a file, bin ib+1 in entry ib
+  static std::vector<double> readProfile(const std::string& fileName, const char* what);
+
   edm::InputTag src_;
-  TH1D* histWeight_;
+  // data/MC ratio of profile ip for npv interactions in ratios_[npv*nProfiles_+ip]
+  std::vector<double> ratios_;
+  size_t nProfiles_;
+  int nbins_;
   int type_; //switch between 2011 and 2012 recommendations
   bool verbose_;
 };
 
+std::vector<double> PileUpWeightProducer::readProfile(const std::string& fileName, const char* what){
+
+  TFile file( fileName.c_str() );
+  if(file.IsZombie())
+    throw cms::Exception("PileUpWeightProducer")<<" bad input "<<what<<" file "<<file.GetName();
+
+  TH1D* hist = (TH1D*)file.Get("pileup");
+  if(!hist) 
+    throw cms::Exception("PileUpWeightProducer")<<what<<" histogram doesn't exist in file "<<file.GetName();
+
+  //Normalize to 1
+  double scale = 1./hist->Integral();
+  std::vector<double> profile(hist->GetNbinsX());
+  for(int ib = 1; ib<=hist->GetNbinsX(); ++ib )
+    profile[ib-1] = hist->GetBinContent(ib)*scale;
+  return profile;
+}
+
 PileUpWeightProducer::PileUpWeightProducer(const edm::ParameterSet& ps):
   src_(ps.getParameter<edm::InputTag>("src")),
   type_(ps.getParameter<int>("type")),
   verbose_(ps.getUntrackedParameter<bool>("verbose",false)) {
 
+  std::vector<std::string> fileNamesData(1, ps.getParameter<std::string>("inputHistData"));
+  if(ps.exists("inputHistDataVariations")) {
+    std::vector<std::string> variations = ps.getParameter<std::vector<std::string> >("inputHistDataVariations");
+    fileNamesData.insert(fileNamesData.end(), variations.begin(), variations.end());
+  }
+  nProfiles_ = fileNamesData.size();
 
-  TFile fileData( ps.getParameter<std::string>("inputHistData").c_str() );  
-  if(fileData.IsZombie())
-    throw cms::Exception("PileUpWeightProducer")<<" bad input Data file "<<fileData.GetName();
-
-  TFile fileMC( ps.getParameter<std::string>("inputHistMC").c_str() );
-  if(fileMC.IsZombie())
-    throw cms::Exception("PileUpWeightProducer")<<" bad input MC file "<<fileMC.GetName();
- 
-  TH1D* histData = (TH1D*)fileData.Get("pileup");
-  if(!histData) 
-    throw cms::Exception("PileUpWeightProducer")<<"Data histogram doesn't exist in file "<<fileData.GetName();
-
-  TH1D* histMC = (TH1D*)fileMC.Get("pileup");
-  if(!histMC) 
-    throw cms::Exception("PileUpWeightProducer")<<"MC histogram doesn't exist in file "<<fileMC.GetName();
-
+  std::vector<double> profileMC = readProfile(ps.getParameter<std::string>("inputHistMC"), "MC");
 
-  //Normalize to 1
-  histData->Scale(1./histData->Integral());
-  histMC->Scale(1./histMC->Integral());
-
-  //set binning to the one with less bins
-  int nbins=histData->GetNbinsX()<histMC->GetNbinsX() ? histData->GetNbinsX() : histMC->GetNbinsX();    
-  histWeight_ = new TH1D("histWeight","",nbins,-0.5,nbins-0.5);
-  for(int ib = 1; ib<=nbins; ++ib ) {
-    if(histMC->GetBinContent(ib)>0.0) histWeight_->SetBinContent( ib,  histData->GetBinContent(ib)/histMC->GetBinContent(ib) );
-    else  histWeight_->SetBinContent( ib,0.0);
+  //a data profile with less bins than the MC one gives 0 above its last bin
+  nbins_ = profileMC.size();
+  ratios_.assign(nbins_*nProfiles_, 0.0);
+  for(size_t ip = 0; ip<nProfiles_; ++ip ) {
+    std::vector<double> profileData = readProfile(fileNamesData[ip], "Data");
+    for(size_t ib = 0; ib<profileData.size() && ib<profileMC.size(); ++ib ) 
+      if(profileMC[ib]>0.0) ratios_[ib*nProfiles_+ip] = profileData[ib]/profileMC[ib];
   }
 
-
   produces<double>();
+  produces<std::vector<double> >("variations");
 
 }
 
 
 
 PileUpWeightProducer::~PileUpWeightProducer() {
-  delete histWeight_;
 }
 
 
@@ -83,7 +105,6 @@ void PileUpWeightProducer::produce(edm::Event& iEvent, const edm::EventSetup& iS
   edm::Handle<std::vector< PileupSummaryInfo > >  PupInfo;
   iEvent.getByLabel(src_, PupInfo);
  
-  double mcPUPWeight = 0.;//default weight is set to 0 in case npv is out of range
   int npv=-1;
   for( std::vector<PileupSummaryInfo>::const_iterator PVI = PupInfo->begin(); PVI != PupInfo->end(); ++PVI) 
     if(PVI->getBunchCrossing() == 0){
@@ -91,18 +112,20 @@ void PileUpWeightProducer::produce(edm::Event& iEvent, const edm::EventSetup& iS
       if(type_==2)npv = PVI->getTrueNumInteractions();
     }
 
-  if(  0<= npv && npv < histWeight_->GetNbinsX()  ) 
-    mcPUPWeight = histWeight_->GetBinContent( npv+1 ); //npv=0 corresponds to bin # 1
+  //default weights are set to 0 in case npv is out of range
+  std::auto_ptr<std::vector<double> > weights( new std::vector<double>(nProfiles_, 0.) ); 
+  if(  0<= npv && npv < nbins_  ) 
+    std::copy(ratios_.begin() + npv*nProfiles_, ratios_.begin() + (npv+1)*nProfiles_, weights->begin());
   
   if( verbose_ )
     cout<<" npv="<<npv
-	<<" weight="<<mcPUPWeight
-	<<" histXmin="<<histWeight_->GetXaxis()->GetXmin()
-	<<" histXmax="<<histWeight_->GetXaxis()->GetXmax()
+	<<" weight="<<weights->front()
+	<<" nbins="<<nbins_
 	<<endl;
 
-  std::auto_ptr<double> output( new double( mcPUPWeight ) ); 
+  std::auto_ptr<double> output( new double( weights->front() ) ); 
   iEvent.put( output );
+  iEvent.put( weights, "variations" );
 
 }
 
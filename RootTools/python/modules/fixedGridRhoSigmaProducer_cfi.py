@@ -0,0 +1,14 @@
+import FWCore.ParameterSet.Config as cms
+
+# same sigma as fixedGridSigmaFastjetAll (instance label ""), and its rho (instance label "Rho")
+fixedGridRhoSigmaAll = cms.EDProducer("FixedGridRhoSigmaProducer",
+    pfCandidatesTag = cms.InputTag("packedPFCandidates"),
+    grids = cms.VPSet(
+        cms.PSet(
+            label = cms.string(""),
+            maxRapidity = cms.double(5.0),
+            gridSpacing = cms.double(0.55)
+        ),
+    ),
+    checkFastjet = cms.untracked.bool(False)
+)
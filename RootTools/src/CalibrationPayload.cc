@@ -0,0 +1,332 @@
+#include "CMGTools/RootTools/interface/CalibrationPayload.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TF1.h"
+#include "TH1.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cmg;
+
+namespace {
+
+  size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+  struct TabulatedFunctor {
+    PayloadFunction func;
+    explicit TabulatedFunctor(const PayloadFunction & f) : func(f) {}
+    double operator()(const double * x, const double *) const { return func.eval(x[0]); }
+  };
+
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+uint64_t payload::checksum(const char * data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= (unsigned char) data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+int PayloadHistogram::findBin(double x) const {
+  if (x < edges_[0]) return -1;
+  if (x >= edges_[n_]) return n_;
+  return int(std::upper_bound(edges_, edges_ + n_ + 1, x) - edges_) - 1;
+}
+
+double PayloadHistogram::interpolate(double x) const {
+  if (x <= center(0)) return contents_[0];
+  if (x >= center(n_-1)) return contents_[n_-1];
+  int bin = findBin(x);
+  int lo = (x <= center(bin)) ? bin - 1 : bin;
+  double x0 = center(lo), x1 = center(lo+1);
+  double y0 = contents_[lo], y1 = contents_[lo+1];
+  return y0 + (x-x0)*((y1-y0)/(x1-x0));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+PayloadFunction::PayloadFunction(unsigned int n, unsigned int nPar, double xmin, double xmax, const double * data) :
+  n_(n), nPar_(nPar), xmin_(xmin), xmax_(xmax), step_((xmax-xmin)/(n-1)),
+  values_(data), integral_(data + n), params_(data + 2*n), errors_(data + 2*n + nPar) {}
+
+double PayloadFunction::eval(double x) const {
+  double u = (x - xmin_)/step_;
+  int i = int(u);
+  if (u < 0) i = 0;
+  if (i > int(n_) - 2) i = n_ - 2;
+  double t = u - i;
+  return values_[i] + t*(values_[i+1] - values_[i]);
+}
+
+double PayloadFunction::integral(double x) const {
+  if (x <= xmin_) return 0;
+  if (x >= xmax_) return integral_[n_-1];
+  double u = (x - xmin_)/step_;
+  int i = std::min(int(u), int(n_) - 2);
+  double dx = x - (xmin_ + i*step_);
+  // trapezoid of the linear interpolation, scaled to the tabulated interval integral
+  double full = 0.5*step_*(values_[i] + values_[i+1]);
+  double part = 0.5*dx*(values_[i] + eval(x));
+  double width = integral_[i+1] - integral_[i];
+  return integral_[i] + (full != 0 ? width*part/full : width*dx/step_);
+}
+
+double PayloadFunction::quantile(double p) const {
+  double target = p*integral_[n_-1];
+  if (target <= 0) return xmin_;
+  if (target >= integral_[n_-1]) return xmax_;
+  int i = int(std::upper_bound(integral_, integral_ + n_, target) - integral_) - 1;
+  i = std::min(std::max(i, 0), int(n_) - 2);
+  // invert integral() on the interval: f0*dx + slope*dx^2/2 = part
+  double f0 = values_[i], f1 = values_[i+1];
+  double slope = (f1 - f0)/step_;
+  double full = 0.5*step_*(f0 + f1);
+  double width = integral_[i+1] - integral_[i];
+  double frac = width != 0 ? (target - integral_[i])/width : 0;
+  double dx;
+  if (f0 <= 0 || f1 <= 0 || std::abs(f1 - f0) < 1e-9*std::abs(f0))
+    dx = frac*step_;
+  else
+    dx = (std::sqrt(f0*f0 + 2*slope*frac*full) - f0)/slope;
+  return xmin_ + i*step_ + std::min(std::max(dx, 0.), step_);
+}
+
+TF1 * PayloadFunction::asTF1(const std::string & name) const {
+  static unsigned int counter = 0;
+  std::stringstream lSS; lSS << name << "_payload" << counter++;
+  TF1 * f = new TF1(lSS.str().c_str(), TabulatedFunctor(*this), xmin_, xmax_, nPar_);
+  if (nPar_ > 0) {
+    f->SetParameters(params_);
+    f->SetParErrors(errors_);
+  }
+  f->SetNpx(n_);
+  return f;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+CalibrationPayload::CalibrationPayload(const std::string & fileName) :
+  source_(fileName), map_(0), mapSize_(0), data_(0), objects_(0), nObjects_(0) {
+
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw cms::Exception("CalibrationPayload") << "cannot open payload file " << fileName;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(payload::FileHeader)) {
+    close(fd);
+    throw cms::Exception("CalibrationPayload") << "payload file " << fileName << " is too short";
+  }
+  mapSize_ = st.st_size;
+  map_ = mmap(0, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map_ == MAP_FAILED) {
+    map_ = 0;
+    throw cms::Exception("CalibrationPayload") << "cannot mmap payload file " << fileName;
+  }
+  data_ = (const char *) map_;
+  init(mapSize_);
+}
+
+CalibrationPayload::CalibrationPayload(std::vector<char> & image) :
+  source_("<memory>"), map_(0), mapSize_(0), data_(0), objects_(0), nObjects_(0) {
+  image_.swap(image);
+  data_ = image_.data();
+  init(image_.size());
+}
+
+CalibrationPayload::~CalibrationPayload() {
+  if (map_) munmap(map_, mapSize_);
+}
+
+void CalibrationPayload::init(size_t size) {
+  if (size < sizeof(payload::FileHeader))
+    throw cms::Exception("CalibrationPayload") << source_ << " is too short for a payload";
+  const payload::FileHeader * header = (const payload::FileHeader *) data_;
+  if (memcmp(header->magic, payload::kMagic, sizeof(payload::kMagic)) != 0)
+    throw cms::Exception("CalibrationPayload") << source_ << " is not a calibration payload";
+  if (header->version != payload::kVersion)
+    throw cms::Exception("CalibrationPayload") << source_ << " has payload version " << header->version
+					       << ", expected " << payload::kVersion;
+  if (header->size != size)
+    throw cms::Exception("CalibrationPayload") << source_ << " is truncated: " << size << " bytes instead of " << header->size;
+  if (payload::checksum(data_ + sizeof(payload::FileHeader), size - sizeof(payload::FileHeader)) != header->checksum)
+    throw cms::Exception("CalibrationPayload") << source_ << " fails the checksum";
+  nObjects_ = header->nObjects;
+  objects_ = (const payload::ObjectHeader *) (data_ + sizeof(payload::FileHeader));
+}
+
+bool CalibrationPayload::isPayload(const std::string & fileName) {
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  char magic[sizeof(payload::kMagic)];
+  if (!in.read(magic, sizeof(magic))) return false;
+  return memcmp(magic, payload::kMagic, sizeof(magic)) == 0;
+}
+
+std::vector<std::string> CalibrationPayload::names() const {
+  std::vector<std::string> ret;
+  for (uint32_t i = 0; i < nObjects_; ++i) ret.push_back(objects_[i].name);
+  return ret;
+}
+
+const payload::ObjectHeader * CalibrationPayload::find(const std::string & name) const {
+  // the directory is sorted by name
+  uint32_t lo = 0, hi = nObjects_;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi)/2;
+    int cmp = strncmp(objects_[mid].name, name.c_str(), payload::kNameSize);
+    if (cmp == 0) return &objects_[mid];
+    if (cmp < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return 0;
+}
+
+const payload::ObjectHeader & CalibrationPayload::get(const std::string & name, payload::ObjectType type) const {
+  const payload::ObjectHeader * obj = find(name);
+  if (obj == 0)
+    throw cms::Exception("CalibrationPayload") << "object " << name << " is not found in " << source_;
+  if (obj->type != uint32_t(type))
+    throw cms::Exception("CalibrationPayload") << "object " << name << " in " << source_ << " has type " << obj->type
+					       << ", expected " << type;
+  return *obj;
+}
+
+PayloadHistogram CalibrationPayload::histogram(const std::string & name) const {
+  const payload::ObjectHeader & obj = get(name, payload::kHistogram);
+  const double * data = (const double *) (data_ + obj.offset);
+  return PayloadHistogram(obj.n, data, data + obj.n + 1);
+}
+
+PayloadFunction CalibrationPayload::function(const std::string & name) const {
+  const payload::ObjectHeader & obj = get(name, payload::kFunction);
+  return PayloadFunction(obj.n, obj.nPar, obj.xmin, obj.xmax, (const double *) (data_ + obj.offset));
+}
+
+std::vector<double> CalibrationPayload::scalars(const std::string & name) const {
+  const payload::ObjectHeader & obj = get(name, payload::kScalars);
+  const double * data = (const double *) (data_ + obj.offset);
+  return std::vector<double>(data, data + obj.n);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+void CalibrationPayloadWriter::add(const std::string & name, const Entry & entry) {
+  if (name.empty() || name.size() >= payload::kNameSize)
+    throw cms::Exception("CalibrationPayloadWriter") << "invalid object name '" << name << "'";
+  entries_[name] = entry;
+}
+
+void CalibrationPayloadWriter::addHistogram(const std::string & name, const TH1 & hist) {
+  std::vector<double> edges, contents;
+  int nbins = hist.GetNbinsX();
+  for (int i = 1; i <= nbins + 1; ++i) edges.push_back(hist.GetXaxis()->GetBinLowEdge(i));
+  for (int i = 1; i <= nbins; ++i) contents.push_back(hist.GetBinContent(i));
+  addHistogram(name, edges, contents);
+}
+
+void CalibrationPayloadWriter::addHistogram(const std::string & name, const std::vector<double> & edges, const std::vector<double> & contents) {
+  if (contents.empty() || edges.size() != contents.size() + 1)
+    throw cms::Exception("CalibrationPayloadWriter") << "histogram " << name << " needs n+1 edges for n>0 bins";
+  Entry entry;
+  entry.type = payload::kHistogram;
+  entry.n = contents.size();
+  entry.nPar = 0;
+  entry.xmin = edges.front();
+  entry.xmax = edges.back();
+  entry.data = edges;
+  entry.data.insert(entry.data.end(), contents.begin(), contents.end());
+  add(name, entry);
+}
+
+void CalibrationPayloadWriter::addFunction(const std::string & name, const TF1 & f, unsigned int nPoints, double xmin, double xmax) {
+  if (nPoints < 2)
+    throw cms::Exception("CalibrationPayloadWriter") << "function " << name << " needs at least 2 points";
+  if (!(xmin < xmax)) f.GetRange(xmin, xmax);
+
+  Entry entry;
+  entry.type = payload::kFunction;
+  entry.n = nPoints;
+  entry.nPar = f.GetNpar();
+  entry.xmin = xmin;
+  entry.xmax = xmax;
+  entry.data.resize(2*nPoints + 2*entry.nPar);
+  double * values = &entry.data[0];
+  double * integral = values + nPoints;
+  double step = (xmax - xmin)/(nPoints - 1);
+  for (unsigned int i = 0; i < nPoints; ++i) values[i] = f.Eval(xmin + i*step);
+  // Simpson rule on each interval
+  integral[0] = 0;
+  for (unsigned int i = 1; i < nPoints; ++i) {
+    double mid = f.Eval(xmin + (i - 0.5)*step);
+    integral[i] = integral[i-1] + step/6.*(values[i-1] + 4*mid + values[i]);
+  }
+  for (unsigned int i = 0; i < entry.nPar; ++i) {
+    entry.data[2*nPoints + i] = f.GetParameter(i);
+    entry.data[2*nPoints + entry.nPar + i] = f.GetParError(i);
+  }
+  add(name, entry);
+}
+
+void CalibrationPayloadWriter::addScalars(const std::string & name, const std::vector<double> & values) {
+  Entry entry;
+  entry.type = payload::kScalars;
+  entry.n = values.size();
+  entry.nPar = 0;
+  entry.xmin = 0;
+  entry.xmax = 0;
+  entry.data = values;
+  add(name, entry);
+}
+
+std::vector<char> CalibrationPayloadWriter::image() const {
+  size_t dirSize = sizeof(payload::FileHeader) + entries_.size()*sizeof(payload::ObjectHeader);
+  size_t size = align8(dirSize);
+  for (std::map<std::string, Entry>::const_iterator it = entries_.begin(); it != entries_.end(); ++it)
+    size += it->second.data.size()*sizeof(double);
+
+  std::vector<char> image(size, 0);
+  payload::FileHeader * header = (payload::FileHeader *) &image[0];
+  memcpy(header->magic, payload::kMagic, sizeof(payload::kMagic));
+  header->version = payload::kVersion;
+  header->nObjects = entries_.size();
+  header->size = size;
+
+  // std::map iterates in name order, which is what the reader's binary search expects
+  payload::ObjectHeader * objects = (payload::ObjectHeader *) &image[sizeof(payload::FileHeader)];
+  size_t offset = align8(dirSize);
+  unsigned int i = 0;
+  for (std::map<std::string, Entry>::const_iterator it = entries_.begin(); it != entries_.end(); ++it, ++i) {
+    const Entry & entry = it->second;
+    strncpy(objects[i].name, it->first.c_str(), payload::kNameSize - 1);
+    objects[i].type = entry.type;
+    objects[i].n = entry.n;
+    objects[i].nPar = entry.nPar;
+    objects[i].offset = offset;
+    objects[i].xmin = entry.xmin;
+    objects[i].xmax = entry.xmax;
+    if (!entry.data.empty())
+      memcpy(&image[offset], &entry.data[0], entry.data.size()*sizeof(double));
+    offset += entry.data.size()*sizeof(double);
+  }
+
+  header->checksum = payload::checksum(&image[sizeof(payload::FileHeader)], size - sizeof(payload::FileHeader));
+  return image;
+}
+
+void CalibrationPayloadWriter::write(const std::string & fileName) const {
+  std::vector<char> img = image();
+  std::ofstream out(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  if (!out || !out.write(&img[0], img.size()))
+    throw cms::Exception("CalibrationPayloadWriter") << "cannot write payload file " << fileName;
+}
@@ -0,0 +1,111 @@
+#include "CMGTools/RootTools/interface/GridRhoSigmaEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  // the constants of fastjet/internal/numconsts.hh
+  const double kTwoPi = 6.283185307179586476925286766559005768394;
+  const double kMaxRap = 1e5;
+}
+
+namespace cmg {
+
+  size_t GridRhoSigmaEstimator::addGrid(double rapMin, double rapMax, double spacing) {
+    // as fastjet::RectangularGrid::_setup_grid
+    Grid grid;
+    grid.rapMin = rapMin;
+    grid.rapMax = rapMax;
+    grid.nRap = std::max(int((rapMax-rapMin)/spacing + 0.5), 1);
+    grid.invDRap = grid.nRap/(rapMax-rapMin);
+    grid.nPhi = int(kTwoPi/spacing + 0.5);
+    grid.invDPhi = grid.nPhi/kTwoPi;
+    grid.cellArea = ((rapMax-rapMin)/grid.nRap) * (kTwoPi/grid.nPhi);
+    grid.offset = pt_.size();
+    grid.rho = 0.;
+    grid.sigma = 0.;
+    grids_.push_back(grid);
+    pt_.resize(pt_.size() + size_t(grid.nRap)*grid.nPhi, 0.);
+    work_.resize(std::max(work_.size(), size_t(grid.nRap)*grid.nPhi));
+    return grids_.size()-1;
+  }
+
+  void GridRhoSigmaEstimator::reset() {
+    std::fill(pt_.begin(), pt_.end(), 0.);
+  }
+
+  void GridRhoSigmaEstimator::add(double px, double py, double pz, double e) {
+    // rapidity and phi as fastjet::PseudoJet::_set_rap_phi
+    const double kt2 = px*px + py*py;
+    double phi = kt2 == 0.0 ? 0.0 : std::atan2(py, px);
+    if (phi < 0.0) phi += kTwoPi;
+    if (phi >= kTwoPi) phi -= kTwoPi;
+    double rap;
+    if (e == std::abs(pz) && kt2 == 0) {
+      const double maxRapHere = kMaxRap + std::abs(pz);
+      rap = pz >= 0.0 ? maxRapHere : -maxRapHere;
+    }
+    else {
+      const double effectiveM2 = std::max(0.0, (e+pz)*(e-pz) - kt2);
+      const double ePlusPz = e + std::abs(pz);
+      rap = 0.5*std::log((kt2 + effectiveM2)/(ePlusPz*ePlusPz));
+      if (pz > 0) rap = -rap;
+    }
+    const double pt = std::sqrt(kt2);
+
+    // cell as fastjet::RectangularGrid::tile_index
+    for (size_t ig = 0; ig < grids_.size(); ++ig) {
+      const Grid &grid = grids_[ig];
+      const double rapMinusMin = rap - grid.rapMin;
+      if (rapMinusMin < 0) continue;
+      const int iRap = int(rapMinusMin * grid.invDRap);
+      if (iRap >= grid.nRap) continue;
+      int iPhi = int(phi * grid.invDPhi);
+      if (iPhi == grid.nPhi) iPhi = 0;
+      pt_[grid.offset + size_t(iRap)*grid.nPhi + iPhi] += pt;
+    }
+  }
+
+  void GridRhoSigmaEstimator::compute() {
+    for (size_t ig = 0; ig < grids_.size(); ++ig) {
+      Grid &grid = grids_[ig];
+      const size_t nCells = size_t(grid.nRap)*grid.nPhi;
+      double *pts = &work_[0];
+      std::copy(pt_.begin() + grid.offset, pt_.begin() + grid.offset + nCells, pts);
+
+      // as fastjet, the quantiles are taken on the scalar pt of the cells and only then divided
+      // by the cell area; the values up to the median are left in front, the lower quantile is
+      // then searched among them
+      size_t nSmallest = nCells;
+      const double p50 = percentile(pts, nCells, nSmallest, 0.5);
+      const double p16 = percentile(pts, nCells, nSmallest, (1.0-0.6827)/2.0);
+      grid.rho = p50/grid.cellArea;
+      grid.sigma = (p50-p16)/std::sqrt(grid.cellArea);
+    }
+  }
+
+  double GridRhoSigmaEstimator::percentile(double *values, size_t n, size_t &nSmallest, double fraction) {
+    const int size = n;
+    if (size == 0) return 0;
+    double pos = size*fraction - 0.5;
+    if (pos >= 0 && size > 1) {
+      int i = int(pos);
+      if (i+1 > size-1) {
+        i = size-2;
+        pos = size-1;
+      }
+      // the order statistics i and i+1
+      double *end = i+1 < int(nSmallest) ? values + nSmallest : values + n;
+      std::nth_element(values, values + i, end);
+      const double vi = values[i];
+      const double vi1 = *std::min_element(values + i + 1, end);
+      nSmallest = i+1;
+      return vi*(i+1-pos) + vi1*(pos-i);
+    }
+    else if (pos > -0.5 && size >= 1) {
+      return *std::min_element(values, values + nSmallest);
+    }
+    return 0.;
+  }
+
+}
@@ -1,7 +1,34 @@
 #include "CMGTools/RootTools/interface/RecoilCorrector.h"
+#include "CMGTools/RootTools/interface/CalibrationPayload.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+#include "TKey.h"
+
+#include <set>
+
+namespace {
+  // the fits are tabulated in gen boson pt up to at least this value when compiled into a payload,
+  // and on the same grid from 0 when read
+  const double kPayloadPtMax   = 1000.;
+  const unsigned int kPayloadNPoints = 4001;
+  const double kTableInvStep = (kPayloadNPoints-1)/kPayloadPtMax;
+
+  void collectFunctions(TDirectory *iDir, cmg::CalibrationPayloadWriter &iWriter, std::set<std::string> &iNames) { 
+    TIter lNext(iDir->GetListOfKeys());
+    while(TKey *lKey = (TKey*) lNext()) { 
+      TObject *lObj = lKey->ReadObj();
+      if(lObj->InheritsFrom(TDirectory::Class())) { collectFunctions((TDirectory*) lObj, iWriter, iNames); continue; }
+      if(!lObj->InheritsFrom(TF1::Class()) || iNames.count(lObj->GetName())) continue;
+      TF1 *lFunc = (TF1*) lObj;
+      double lXMin = 0, lXMax = 0; lFunc->GetRange(lXMin,lXMax);
+      iWriter.addFunction(lFunc->GetName(),*lFunc,kPayloadNPoints,min(lXMin,0.),max(lXMax,kPayloadPtMax));
+      iNames.insert(lFunc->GetName());
+    }
+  }
+}
 
 //-----------------------------------------------------------------------------------------------------------------------------------------
-RecoilCorrector::RecoilCorrector(string iNameZDat,std::string iPrefix, int iSeed) {
+RecoilCorrector::RecoilCorrector(string iNameZDat,std::string iPrefix, int iSeed) : fExact(false), fKeyed(false) {
 
   fRandom = new TRandom3(iSeed);
 
@@ -12,7 +39,7 @@ RecoilCorrector::RecoilCorrector(string iNameZDat,std::string iPrefix, int iSeed
   fId = 0; fJet = 0;
 }
 
-RecoilCorrector::RecoilCorrector(string iNameZ, int iSeed) {
+RecoilCorrector::RecoilCorrector(string iNameZ, int iSeed) : fExact(false), fKeyed(false) {
 
   fRandom = new TRandom3(iSeed);
   // get fits for Z data
@@ -25,7 +52,66 @@ RecoilCorrector::RecoilCorrector(string iNameZ, int iSeed) {
 RecoilCorrector::~RecoilCorrector() {
 
   delete fRandom;
+  for(std::map<std::string,cmg::CalibrationPayload*>::iterator it = fPayloads.begin(); it != fPayloads.end(); ++it) delete it->second;
+
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+void RecoilCorrector::WritePayload(std::string iRootFile, std::string iPayloadFile) { 
+  TFile *lFile = new TFile(iRootFile.c_str());
+  if(lFile->IsZombie()) { 
+    delete lFile;
+    throw cms::Exception("RecoilCorrector") << "cannot open " << iRootFile;
+  }
+  cmg::CalibrationPayloadWriter lWriter;
+  std::set<std::string> lNames;
+  collectFunctions(lFile,lWriter,lNames);
+  lFile->Close();
+  delete lFile;
+  lWriter.write(iPayloadFile);
+}
+
+cmg::CalibrationPayload* RecoilCorrector::openPayload(std::string iFName) { 
+  std::map<std::string,cmg::CalibrationPayload*>::iterator lIt = fPayloads.find(iFName);
+  if(lIt != fPayloads.end()) return lIt->second;
+  if(!cmg::CalibrationPayload::isPayload(iFName)) return 0;
+  cmg::CalibrationPayload *lPayload = new cmg::CalibrationPayload(iFName);
+  fPayloads[iFName] = lPayload;
+  return lPayload;
+}
+
+bool RecoilCorrector::hasFunction(TFile *iFile, cmg::CalibrationPayload *iPayload, std::string iName) { 
+  if(iPayload == 0) return iFile->FindObjectAny(iName.c_str()) != 0;
+  return iPayload->has(iName);
+}
+
+TF1* RecoilCorrector::findFunction(TFile *iFile, cmg::CalibrationPayload *iPayload, std::string iName) { 
+  if(iPayload == 0) return (TF1*) iFile->FindObjectAny(iName.c_str());
+  if(!iPayload->has(iName)) return 0;
+  return iPayload->function(iName).asTF1(iName);
+}
 
+void RecoilCorrector::tabulate(std::string iFName,const std::vector<TF1*> &iFits) { 
+  for(unsigned int i0 = 0; i0 < iFits.size(); i0++) { 
+    TF1 *lFit = iFits[i0];
+    if(lFit == 0 || fTableOf.count(lFit)) continue;
+    std::vector<double> &lTable = fTables[iFName+":"+lFit->GetName()];
+    if(lTable.empty()) { 
+      lTable.resize(kPayloadNPoints);
+      for(unsigned int i1 = 0; i1 < kPayloadNPoints; i1++) lTable[i1] = lFit->Eval(i1/kTableInvStep);
+    }
+    fTableOf[lFit] = &lTable[0];
+  }
+}
+
+double RecoilCorrector::Eval(const TF1 *iFit,double iPt) const { 
+  if(fExact || !(iPt >= 0.) || iPt >= kPayloadPtMax) return iFit->Eval(iPt);
+  std::unordered_map<const TF1*,const double*>::const_iterator lIt = fTableOf.find(iFit);
+  if(lIt == fTableOf.end()) return iFit->Eval(iPt);
+  double lX = iPt*kTableInvStep;
+  unsigned int lBin = (unsigned int) lX;
+  double lFrac = lX - lBin;
+  return lIt->second[lBin] + lFrac*(lIt->second[lBin+1]-lIt->second[lBin]);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------
@@ -51,8 +137,8 @@ void RecoilCorrector::CorrectAll(double &met, double &metphi, double lGenPt, dou
   //  if(fJet >= int(fF1U1Fit.size())) fJet = 1; 
   if(fJet >= int(fF1U1Fit.size())) fJet = int(fF1U1Fit.size()) - 1; 
 
-  fRandom->SetSeed((int)((lGenPhi+4)*100000));
-  metDistribution(met,metphi,lGenPt,lGenPhi,lepPt,lepPhi,fRandom,
+  Random lRandom = random(lGenPhi);
+  metDistribution(met,metphi,lGenPt,lGenPhi,lepPt,lepPhi,&lRandom,
 		  fF1U1Fit     [fJet],
 		  fF1U1RMSSMFit[fJet],
 		  fF1U1RMS1Fit [fJet],
@@ -65,6 +151,42 @@ void RecoilCorrector::CorrectAll(double &met, double &metphi, double lGenPt, dou
 		  );
 }
 
+void RecoilCorrector::CorrectAll(double *met, double *metphi, const double *lGenPt, const double *lGenPhi, const double *lepPt, const double *lepPhi,double *iU1,double *iU2,const int *njet,size_t n,double iFluc,double iScale,
+				 const unsigned int *iRun,const unsigned int *iLumi,const unsigned long long *iEvent,unsigned int iVariation) {
+
+  int lNCat = int(fF1U1Fit.size());
+  std::vector<std::vector<size_t> > lEvents(lNCat);
+  for(size_t i0 = 0; i0 < n; i0++) { 
+    int lCat = njet[i0];
+    if(lCat >= lNCat) lCat = lNCat - 1; 
+    if(lCat < 0) lCat = 0;
+    lEvents[lCat].push_back(i0);
+  }
+
+  // a stream of its own, so that the key set by SetRandomKey is left untouched
+  cmg::CounterRandom lCounterRandom;
+  for(int lCat = 0; lCat < lNCat; lCat++) { 
+    fJet = lCat;
+    TF1 *lU1Fit     = fF1U1Fit     [fJet];
+    TF1 *lU1RMSSMFit= fF1U1RMSSMFit[fJet];
+    TF1 *lU1RMS1Fit = fF1U1RMS1Fit [fJet];
+    TF1 *lU1RMS2Fit = fF1U1RMS2Fit [fJet];
+    TF1 *lU2RMSSMFit= fF1U2RMSSMFit[fJet];
+    TF1 *lU2RMS1Fit = fF1U2RMS1Fit [fJet];
+    TF1 *lU2RMS2Fit = fF1U2RMS2Fit [fJet];
+    TF1 *lU1U2Corr  = fF1U1U2Corr  [fJet];
+    const std::vector<size_t> &lCatEvents = lEvents[lCat];
+    for(size_t i1 = 0; i1 < lCatEvents.size(); i1++) { 
+      size_t i0 = lCatEvents[i1];
+      if(iEvent) lCounterRandom.setKey(iRun ? iRun[i0] : 0,iLumi ? iLumi[i0] : 0,iEvent[i0],iVariation);
+      Random lRandom = iEvent ? Random(&lCounterRandom) : random(lGenPhi[i0]);
+      metDistribution(met[i0],metphi[i0],lGenPt[i0],lGenPhi[i0],lepPt[i0],lepPhi[i0],&lRandom,
+		      lU1Fit,lU1RMSSMFit,lU1RMS1Fit,lU1RMS2Fit,lU2RMSSMFit,lU2RMS1Fit,lU2RMS2Fit,lU1U2Corr,
+		      iU1[i0],iU2[i0],iFluc,iScale);
+    }
+  }
+}
+
 void RecoilCorrector::CorrectType1(double &met, double &metphi, double lGenPt, double lGenPhi, double lepPt, double lepPhi,double &iU1,double &iU2,double iFlucU2,double iFlucU1,double iScale,int njet) {
 
   //  cout << "TYPE1: nVTX " << njet << " fId " << fId << " function size "<< fF1U1Fit.size() << endl;
@@ -75,8 +197,8 @@ void RecoilCorrector::CorrectType1(double &met, double &metphi, double lGenPt, d
   //  if(fJet >= int(fF1U1Fit.size())) fJet = 1; 
   if(fJet >= int(fF1U1Fit.size())) fJet = int(fF1U1Fit.size()) - 1; 
 
-  fRandom->SetSeed((int)((lGenPhi+4)*100000));
-  metDistributionType1(met,metphi,lGenPt,lGenPhi,lepPt,lepPhi,fRandom,
+  Random lRandom = random(lGenPhi);
+  metDistributionType1(met,metphi,lGenPt,lGenPhi,lepPt,lepPhi,&lRandom,
 		       fD1U1Fit     [fJet],fM1U1Fit     [fJet],
 		       fD1U1RMSSMFit[fJet],fM1U1RMSSMFit[fJet],
 		       fD1U2RMSSMFit[fJet],fM1U2RMSSMFit[fJet],
@@ -117,8 +239,8 @@ void RecoilCorrector::Correct(double &pfmet, double &pfmetphi, double &trkmet, d
   //  if(fJet > int(fF1U1Fit.size())) fJet = 1; 
   if(fJet >= int(fF1U1Fit.size())) fJet = int(fF1U1Fit.size()) - 1; 
 
-  fRandom->SetSeed((int)((lGenPhi+4)*100000));
-  metDistribution(pfmet,pfmetphi,trkmet,trkmetphi,lGenPt,lGenPhi,lepPt,lepPhi,fRandom,
+  Random lRandom = random(lGenPhi);
+  metDistribution(pfmet,pfmetphi,trkmet,trkmetphi,lGenPt,lGenPhi,lepPt,lepPhi,&lRandom,
 		  fF1U1Fit     [fJet],fF2U1Fit     [fJet],
 		  fF1U1RMSSMFit[fJet],fF2U1RMSSMFit[fJet],
 		  fF1U1RMS1Fit [fJet],fF2U1RMS1Fit [fJet],
@@ -142,7 +264,9 @@ void RecoilCorrector::CorrectU1U2(double &iPFU1, double &iPFU2, double &iTKU1, d
   //    if(fJet > int(fF1U1Fit.size())) fJet = 1; 
   if(fJet >= int(fF1U1Fit.size())) fJet = int(fF1U1Fit.size()) - 1; 
 
-  metDistribution(pfmet,pfmetphi,iTKU1,iTKU2,lGenPt,lGenPhi,lepPt,lepPhi,fRandom,
+  // fRandom is not reseeded here
+  Random lRandom = fKeyed ? random(lGenPhi) : Random(fRandom);
+  metDistribution(pfmet,pfmetphi,iTKU1,iTKU2,lGenPt,lGenPhi,lepPt,lepPhi,&lRandom,
 		  fF1U1Fit     [fJet],fF2U1Fit     [fJet],
 		  fF1U1RMSSMFit[fJet],fF2U1RMSSMFit[fJet],
 		  fF1U1RMS1Fit [fJet],fF2U1RMS1Fit [fJet],
@@ -158,25 +282,33 @@ void RecoilCorrector::CorrectU1U2(double &iPFU1, double &iPFU2, double &iTKU1, d
 		  );
   //iTKU1 = 0; iTKU2 = 0;
 }
+RecoilCorrector::Random RecoilCorrector::random(double iGenPhi) { 
+  if(fKeyed) { 
+    fCounterRandom.restart();
+    return Random(&fCounterRandom);
+  }
+  fRandom->SetSeed((int)((iGenPhi+4)*100000));
+  return Random(fRandom);
+}
 double RecoilCorrector::CorrVal(double iPt, double iVal, Recoil iType) { 
   if(fId == 0 || fId == 1) return iVal;
   switch(iType) {
-  case PFU1   : return iVal*(fD1U1Fit     [fJet]->Eval(iPt)/fM1U1Fit     [fJet]->Eval(iPt));
-  case PFMSU1 : return iVal*(fD1U1RMSSMFit[fJet]->Eval(iPt)/fM1U1RMSSMFit[fJet]->Eval(iPt));
-  case PFS1U1 : return iVal*(fD1U1RMS1Fit [fJet]->Eval(iPt)/fM1U1RMS1Fit [fJet]->Eval(iPt));
-  case PFS2U1 : return iVal*(fD1U1RMS2Fit [fJet]->Eval(iPt)/fM1U1RMS2Fit [fJet]->Eval(iPt));
+  case PFU1   : return iVal*(Eval(fD1U1Fit     [fJet],iPt)/Eval(fM1U1Fit     [fJet],iPt));
+  case PFMSU1 : return iVal*(Eval(fD1U1RMSSMFit[fJet],iPt)/Eval(fM1U1RMSSMFit[fJet],iPt));
+  case PFS1U1 : return iVal*(Eval(fD1U1RMS1Fit [fJet],iPt)/Eval(fM1U1RMS1Fit [fJet],iPt));
+  case PFS2U1 : return iVal*(Eval(fD1U1RMS2Fit [fJet],iPt)/Eval(fM1U1RMS2Fit [fJet],iPt));
   case PFU2   : return 0;
-  case PFMSU2 : return iVal*(fD1U2RMSSMFit[fJet]->Eval(iPt)/fM1U2RMSSMFit[fJet]->Eval(iPt));
-  case PFS1U2 : return iVal*(fD1U2RMS1Fit [fJet]->Eval(iPt) /fM1U2RMS1Fit[fJet]->Eval(iPt));
-  case PFS2U2 : return iVal*(fD1U2RMS2Fit [fJet]->Eval(iPt) /fM1U2RMS2Fit[fJet]->Eval(iPt));
-  case TKU1   : return iVal*(fD2U1Fit     [fJet]->Eval(iPt)/fM2U1Fit     [fJet]->Eval(iPt));
-  case TKMSU1 : return iVal*(fD2U1RMSSMFit[fJet]->Eval(iPt)/fM2U1RMSSMFit[fJet]->Eval(iPt));
-  case TKS1U1 : return iVal*(fD2U1RMS1Fit [fJet]->Eval(iPt) /fM2U1RMS1Fit[fJet]->Eval(iPt));
-  case TKS2U1 : return iVal*(fD2U1RMS2Fit [fJet]->Eval(iPt) /fM2U1RMS2Fit[fJet]->Eval(iPt));
+  case PFMSU2 : return iVal*(Eval(fD1U2RMSSMFit[fJet],iPt)/Eval(fM1U2RMSSMFit[fJet],iPt));
+  case PFS1U2 : return iVal*(Eval(fD1U2RMS1Fit [fJet],iPt) /Eval(fM1U2RMS1Fit[fJet],iPt));
+  case PFS2U2 : return iVal*(Eval(fD1U2RMS2Fit [fJet],iPt) /Eval(fM1U2RMS2Fit[fJet],iPt));
+  case TKU1   : return iVal*(Eval(fD2U1Fit     [fJet],iPt)/Eval(fM2U1Fit     [fJet],iPt));
+  case TKMSU1 : return iVal*(Eval(fD2U1RMSSMFit[fJet],iPt)/Eval(fM2U1RMSSMFit[fJet],iPt));
+  case TKS1U1 : return iVal*(Eval(fD2U1RMS1Fit [fJet],iPt) /Eval(fM2U1RMS1Fit[fJet],iPt));
+  case TKS2U1 : return iVal*(Eval(fD2U1RMS2Fit [fJet],iPt) /Eval(fM2U1RMS2Fit[fJet],iPt));
   case TKU2   : return 0;
-  case TKMSU2 : return iVal*(fD2U2RMSSMFit[fJet]->Eval(iPt)/fM2U2RMSSMFit[fJet]->Eval(iPt));
-  case TKS1U2 : return iVal*(fD2U2RMS1Fit [fJet]->Eval(iPt) /fM2U2RMS1Fit[fJet]->Eval(iPt));
-  case TKS2U2 : return iVal*(fD2U2RMS2Fit [fJet]->Eval(iPt) /fM2U2RMS2Fit[fJet]->Eval(iPt));
+  case TKMSU2 : return iVal*(Eval(fD2U2RMSSMFit[fJet],iPt)/Eval(fM2U2RMSSMFit[fJet],iPt));
+  case TKS1U2 : return iVal*(Eval(fD2U2RMS1Fit [fJet],iPt) /Eval(fM2U2RMS1Fit[fJet],iPt));
+  case TKS2U2 : return iVal*(Eval(fD2U2RMS2Fit [fJet],iPt) /Eval(fM2U2RMS2Fit[fJet],iPt));
   }
   return iVal;
 }
@@ -210,7 +342,8 @@ void RecoilCorrector::readRecoil(std::vector<TF1*> &iU1Fit,std::vector<TF1*> &iU
 //    printf("error! RecoilCorrector called without input files. Define CMSSW_BASE or add by hand.\n");
 //    assert(0);
 //  }
-  TFile *lFile  = new TFile(iFName.c_str());
+  cmg::CalibrationPayload *lPayload = openPayload(iFName);
+  TFile *lFile  = lPayload ? 0 : new TFile(iFName.c_str());
 
   cout << "reading file "<< iFName.c_str() << endl; 
   // lFile->ls();
@@ -218,50 +351,56 @@ void RecoilCorrector::readRecoil(std::vector<TF1*> &iU1Fit,std::vector<TF1*> &iU
   int lNJet = 1; // this is for the nvtx or rapidity binned
   //   int lNJet = -1; // this is for inclusive nvtx 
   std::stringstream lSS; lSS << iPrefix << "u1Mean_" << lNJet;
-  while(lFile->FindObjectAny(lSS.str().c_str()) != 0) { lSS.str("");
+  while(hasFunction(lFile,lPayload,lSS.str())) { lSS.str("");
     //     cout << lNJet << endl;
 
-    lSS << iPrefix << "u1Mean_"    << lNJet; iU1Fit.push_back    ( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
-    lSS << iPrefix << "u1MeanRMS_" << lNJet; iU1MRMSFit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str(""); 
-    lSS << iPrefix << "u1RMS1_"    << lNJet; iU1RMS1Fit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str(""); 
-    lSS << iPrefix << "u1RMS2_"    << lNJet; iU1RMS2Fit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str(""); 
-    lSS << iPrefix << "u2Mean_"    << lNJet; iU2Fit    .push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
-    lSS << iPrefix << "u2MeanRMS_" << lNJet; iU2MRMSFit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
-    lSS << iPrefix << "u2RMS1_"    << lNJet; iU2RMS1Fit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
-    lSS << iPrefix << "u2RMS2_"    << lNJet; iU2RMS2Fit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
-    lSS << iPrefix << "u2RMS2_"    << lNJet; iU2RMS2Fit.push_back( (TF1*) lFile->FindObjectAny(lSS.str().c_str())); lSS.str("");
+    lSS << iPrefix << "u1Mean_"    << lNJet; iU1Fit.push_back    (findFunction(lFile,lPayload,lSS.str())); lSS.str("");
+    lSS << iPrefix << "u1MeanRMS_" << lNJet; iU1MRMSFit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str(""); 
+    lSS << iPrefix << "u1RMS1_"    << lNJet; iU1RMS1Fit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str(""); 
+    lSS << iPrefix << "u1RMS2_"    << lNJet; iU1RMS2Fit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str(""); 
+    lSS << iPrefix << "u2Mean_"    << lNJet; iU2Fit    .push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str("");
+    lSS << iPrefix << "u2MeanRMS_" << lNJet; iU2MRMSFit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str("");
+    lSS << iPrefix << "u2RMS1_"    << lNJet; iU2RMS1Fit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str("");
+    lSS << iPrefix << "u2RMS2_"    << lNJet; iU2RMS2Fit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str("");
+    lSS << iPrefix << "u2RMS2_"    << lNJet; iU2RMS2Fit.push_back(findFunction(lFile,lPayload,lSS.str())); lSS.str("");
     lNJet++; lSS << iPrefix << "u1Mean_" << lNJet;
 
     //    cout << "Filename " << iFName.c_str() << " lNJet " << lNJet << endl;
 
   }
 
-  lFile->Close();
+  tabulate(iFName,iU1Fit);     tabulate(iFName,iU1MRMSFit); tabulate(iFName,iU1RMS1Fit); tabulate(iFName,iU1RMS2Fit);
+  tabulate(iFName,iU2Fit);     tabulate(iFName,iU2MRMSFit); tabulate(iFName,iU2RMS1Fit); tabulate(iFName,iU2RMS2Fit);
+  if(lFile) lFile->Close();
 }
 //-----------------------------------------------------------------------------------------------------------------------------------------
 void RecoilCorrector::readCorr(std::string iName,
 			       std::vector<TF1*> &iF1U1U2Corr  ,std::vector<TF1*> &iF2U1U2Corr,std::vector<TF1*> &iF1F2U1Corr,std::vector<TF1*> &iF1F2U2Corr,
 			       std::vector<TF1*> &iF1F2U1U2Corr,std::vector<TF1*> &iF1F2U2U1Corr,int iType) {
-  TFile *lFile = new TFile(iName.c_str());
+  cmg::CalibrationPayload *lPayload = openPayload(iName);
+  TFile *lFile = lPayload ? 0 : new TFile(iName.c_str());
   std::stringstream pSS1,pSS2,pSS3,pSS4,pSS5,pSS6;
   int lNJet = 0;
   std::stringstream lSS; lSS << "PFu1Mean_" << lNJet;
-  while(lFile->FindObjectAny(lSS.str().c_str()) != 0) { 
+  while(hasFunction(lFile,lPayload,lSS.str())) { 
     lSS.str(""); pSS1.str(""); pSS2.str(""); pSS3.str(""); pSS4.str(""); pSS5.str(""); pSS6.str("");
-    if(iType != 1) {pSS1  << "u1u2pfCorr_" << lNJet;   iF1U1U2Corr.push_back((TF1*) lFile->FindObjectAny(pSS1.str().c_str())); }
-    if(iType != 0) {pSS2  << "u1u2tkCorr_" << lNJet;   iF2U1U2Corr.push_back((TF1*) lFile->FindObjectAny(pSS2.str().c_str())); }
+    if(iType != 1) {pSS1  << "u1u2pfCorr_" << lNJet;   iF1U1U2Corr.push_back(findFunction(lFile,lPayload,pSS1.str())); }
+    if(iType != 0) {pSS2  << "u1u2tkCorr_" << lNJet;   iF2U1U2Corr.push_back(findFunction(lFile,lPayload,pSS2.str())); }
     if(iType <  2) { lNJet++; lSS <<  "PFu1Mean_" << lNJet;  continue;}
-    pSS3  << "pftku1Corr_"  << lNJet;   iF1F2U1Corr   .push_back((TF1*) lFile->FindObjectAny(pSS3.str().c_str()));
-    pSS4  << "pftku2Corr_"  << lNJet;   iF1F2U2Corr   .push_back((TF1*) lFile->FindObjectAny(pSS4.str().c_str()));
-    pSS5  << "pftkum1Corr_" << lNJet;   iF1F2U1U2Corr .push_back((TF1*) lFile->FindObjectAny(pSS5.str().c_str()));
-    pSS6  << "pftkum2Corr_" << lNJet;   iF1F2U2U1Corr .push_back((TF1*) lFile->FindObjectAny(pSS6.str().c_str()));
+    pSS3  << "pftku1Corr_"  << lNJet;   iF1F2U1Corr   .push_back(findFunction(lFile,lPayload,pSS3.str()));
+    pSS4  << "pftku2Corr_"  << lNJet;   iF1F2U2Corr   .push_back(findFunction(lFile,lPayload,pSS4.str()));
+    pSS5  << "pftkum1Corr_" << lNJet;   iF1F2U1U2Corr .push_back(findFunction(lFile,lPayload,pSS5.str()));
+    pSS6  << "pftkum2Corr_" << lNJet;   iF1F2U2U1Corr .push_back(findFunction(lFile,lPayload,pSS6.str()));
     lNJet++; lSS   << "PFu1Mean_" << lNJet;
   }
-  lFile->Close();
+  tabulate(iName,iF1U1U2Corr);   tabulate(iName,iF2U1U2Corr);
+  tabulate(iName,iF1F2U1Corr);   tabulate(iName,iF1F2U2Corr);
+  tabulate(iName,iF1F2U1U2Corr); tabulate(iName,iF1F2U2U1Corr);
+  if(lFile) lFile->Close();
 }
 //-----------------------------------------------------------------------------------------------------------------------------------------
 void RecoilCorrector::metDistribution(double &iMet,double &iMPhi,double iGenPt,double iGenPhi,
-		                      double iLepPt,double iLepPhi,TRandom3 *iRand,
+		                      double iLepPt,double iLepPhi,Random *iRand,
 		                      TF1 *iU1RZDatFit,
 		                      TF1 *iU1MSZDatFit, 
 		                      TF1 *iU1S1ZDatFit,
@@ -273,14 +412,14 @@ void RecoilCorrector::metDistribution(double &iMet,double &iMPhi,double iGenPt,d
 				      double &iU1, double &iU2,
 		                      double iFluc,double iScale) {
   double lRescale  = sqrt((TMath::Pi())/2.);		     
-  double pU1       = CorrVal(iGenPt,iU1RZDatFit->Eval(iGenPt),PFU1); //iU1RZDatFit->Eval(iGenPt);//CorrVal(iGenPt,iU1RZDatFit->Eval(iGenPt),PFU1);
+  double pU1       = CorrVal(iGenPt,Eval(iU1RZDatFit,iGenPt),PFU1); //iU1RZDatFit->Eval(iGenPt);//CorrVal(iGenPt,iU1RZDatFit->Eval(iGenPt),PFU1);
   double pU2       = 0; //Right guys are for cumulants => code deleted
-  double pFrac1    = CorrVal(iGenPt,iU1MSZDatFit->Eval(iGenPt),PFMSU1)*lRescale;
-  double pFrac2    = CorrVal(iGenPt,iU2MSZDatFit->Eval(iGenPt),PFMSU2)*lRescale;
-  double pSigma1_1 = CorrVal(iGenPt,iU1S1ZDatFit->Eval(iGenPt),PFS1U1)*lRescale*CorrVal(iGenPt,iU1MSZDatFit->Eval(iGenPt),PFMSU1);
-  double pSigma1_2 = CorrVal(iGenPt,iU1S2ZDatFit->Eval(iGenPt),PFS2U1)*lRescale*CorrVal(iGenPt,iU1MSZDatFit->Eval(iGenPt),PFMSU1);
-  double pSigma2_1 = CorrVal(iGenPt,iU2S1ZDatFit->Eval(iGenPt),PFS1U2)*lRescale*CorrVal(iGenPt,iU2MSZDatFit->Eval(iGenPt),PFS1U2);
-  double pSigma2_2 = CorrVal(iGenPt,iU2S2ZDatFit->Eval(iGenPt),PFS2U2)*lRescale*CorrVal(iGenPt,iU2MSZDatFit->Eval(iGenPt),PFS2U2);
+  double pFrac1    = CorrVal(iGenPt,Eval(iU1MSZDatFit,iGenPt),PFMSU1)*lRescale;
+  double pFrac2    = CorrVal(iGenPt,Eval(iU2MSZDatFit,iGenPt),PFMSU2)*lRescale;
+  double pSigma1_1 = CorrVal(iGenPt,Eval(iU1S1ZDatFit,iGenPt),PFS1U1)*lRescale*CorrVal(iGenPt,Eval(iU1MSZDatFit,iGenPt),PFMSU1);
+  double pSigma1_2 = CorrVal(iGenPt,Eval(iU1S2ZDatFit,iGenPt),PFS2U1)*lRescale*CorrVal(iGenPt,Eval(iU1MSZDatFit,iGenPt),PFMSU1);
+  double pSigma2_1 = CorrVal(iGenPt,Eval(iU2S1ZDatFit,iGenPt),PFS1U2)*lRescale*CorrVal(iGenPt,Eval(iU2MSZDatFit,iGenPt),PFS1U2);
+  double pSigma2_2 = CorrVal(iGenPt,Eval(iU2S2ZDatFit,iGenPt),PFS2U2)*lRescale*CorrVal(iGenPt,Eval(iU2MSZDatFit,iGenPt),PFS2U2);
   //double pMU1      = fabs(iU1RZDatFit->GetParameter(1));
   
   //Uncertainty propagation
@@ -315,7 +454,7 @@ void RecoilCorrector::metDistribution(double &iMet,double &iMPhi,double iGenPt,d
   pSigma1_1 = ((pVal0 < pFrac1)*(pSigma1_1)+(pVal0 > pFrac1)*(pSigma1_2)); 
   pSigma2_1 = ((pVal1 < pFrac2)*(pSigma2_1)+(pVal1 > pFrac2)*(pSigma2_2)); 
   
-  double lU1U2   = iU1U2Corr->Eval(iGenPt)*0.5;
+  double lU1U2   = Eval(iU1U2Corr,iGenPt)*0.5;
   //cout << "===> " << lU1U2 << " -- " << iGenPt << endl;
   double pVal1_1 = correlatedSeed(pSigma1_1,lU1U2,0.,0.,pCorr1,pCorr2,0.,0.);
   double pVal2_1 = correlatedSeed(pSigma2_1,lU1U2,0.,0.,pCorr2,pCorr1,0.,0.);
@@ -337,7 +476,7 @@ void RecoilCorrector::metDistribution(double &iMet,double &iMPhi,double iGenPt,d
 }
 
 void RecoilCorrector::metDistributionType1(double &iMet,double &iMPhi,double iGenPt,double iGenPhi,
-					   double iLepPt,double iLepPhi,TRandom3 *iRand,
+					   double iLepPt,double iLepPhi,Random *iRand,
 					   TF1 *iU1RZDatFit,  TF1 *iU1RZMCFit,
 					   TF1 *iU1MSZDatFit, TF1 *iU1MSZMCFit, 
 					   TF1 *iU2MSZDatFit, TF1 *iU2MSZMCFit, 		   		   
@@ -348,12 +487,12 @@ void RecoilCorrector::metDistributionType1(double &iMet,double &iMPhi,double iGe
   //  if(iLepPt < 4) return;
 
   double lRescale  = sqrt((TMath::Pi())/2.);		     
-  double pU1       = iU1RZDatFit->Eval(iGenPt)/iU1RZMCFit->Eval(iGenPt);
+  double pU1       = Eval(iU1RZDatFit,iGenPt)/Eval(iU1RZMCFit,iGenPt);
   double pU2       = 0; //Right guys are for cumulants => code deleted
-  double pFrac1    = max( iU1MSZDatFit->Eval(iGenPt)*iU1MSZDatFit->Eval(iGenPt)
-			  -(pU1*pU1)*iU1MSZMCFit->Eval(iGenPt)*iU1MSZMCFit ->Eval(iGenPt),0.);
-  double pFrac2    = max( iU2MSZDatFit->Eval(iGenPt)*iU2MSZDatFit->Eval(iGenPt)
-			  -iU2MSZMCFit->Eval(iGenPt)*iU2MSZMCFit ->Eval(iGenPt),0.);
+  double pFrac1    = max( Eval(iU1MSZDatFit,iGenPt)*Eval(iU1MSZDatFit,iGenPt)
+			  -(pU1*pU1)*Eval(iU1MSZMCFit,iGenPt)*Eval(iU1MSZMCFit,iGenPt),0.);
+  double pFrac2    = max( Eval(iU2MSZDatFit,iGenPt)*Eval(iU2MSZDatFit,iGenPt)
+			  -Eval(iU2MSZMCFit,iGenPt)*Eval(iU2MSZMCFit,iGenPt),0.);
   pFrac1 = sqrt(pFrac1)*lRescale;
   pFrac2 = sqrt(pFrac2)*lRescale;
  
@@ -384,15 +523,15 @@ void RecoilCorrector::metDistributionType1(double &iMet,double &iMPhi,double iGe
     double lEU1FracMC = sqrt(getError2(iGenPt,iU1MSZMCFit));
     double lEU2FracMC = sqrt(getError2(iGenPt,iU2MSZMCFit));
 
-    double errorScale= pU1 * sqrt((lEUR1*lEUR1)/(iU1RZDatFit->Eval(iGenPt)*iU1RZDatFit->Eval(iGenPt))+(lEUR1mc*lEUR1mc)/(iU1RZMCFit->Eval(iGenPt)*iU1RZMCFit->Eval(iGenPt)));
+    double errorScale= pU1 * sqrt((lEUR1*lEUR1)/(Eval(iU1RZDatFit,iGenPt)*Eval(iU1RZDatFit,iGenPt))+(lEUR1mc*lEUR1mc)/(Eval(iU1RZMCFit,iGenPt)*Eval(iU1RZMCFit,iGenPt)));
     //    double errorResU1= lRescale * sqrt(lEU1Frac*lEU1Frac + (pU1*pU1)*lEU1FracMC*lEU1FracMC ) ; // for this we keep the scale constant
     //    double errorResU2= lRescale * sqrt(lEU2Frac*lEU2Frac + lEU2FracMC*lEU2FracMC ) ;
 
     double errorResU1=0;
     double errorResU2=0;
 
-    if(pFrac1!=0) errorResU1 = (lRescale*lRescale/pFrac1) * sqrt(lEU1Frac*lEU1Frac*iU1MSZDatFit->Eval(iGenPt)*iU1MSZDatFit->Eval(iGenPt) + pU1*pU1*pU1*pU1*lEU1FracMC*lEU1FracMC*iU1MSZMCFit->Eval(iGenPt)*iU1MSZMCFit->Eval(iGenPt)); // for this we keep the scale constant                                                                                                          
-    if(pFrac2!=0) errorResU2 = (lRescale*lRescale/pFrac2) * sqrt(lEU2Frac*lEU2Frac*iU2MSZDatFit->Eval(iGenPt)*iU2MSZDatFit->Eval(iGenPt) + lEU2FracMC*lEU2FracMC*iU2MSZMCFit->Eval(iGenPt)*iU2MSZMCFit->Eval(iGenPt)) ;
+    if(pFrac1!=0) errorResU1 = (lRescale*lRescale/pFrac1) * sqrt(lEU1Frac*lEU1Frac*Eval(iU1MSZDatFit,iGenPt)*Eval(iU1MSZDatFit,iGenPt) + pU1*pU1*pU1*pU1*lEU1FracMC*lEU1FracMC*Eval(iU1MSZMCFit,iGenPt)*Eval(iU1MSZMCFit,iGenPt)); // for this we keep the scale constant                                                                                                          
+    if(pFrac2!=0) errorResU2 = (lRescale*lRescale/pFrac2) * sqrt(lEU2Frac*lEU2Frac*Eval(iU2MSZDatFit,iGenPt)*Eval(iU2MSZDatFit,iGenPt) + lEU2FracMC*lEU2FracMC*Eval(iU2MSZMCFit,iGenPt)*Eval(iU2MSZMCFit,iGenPt)) ;
 
     pU1       = pU1       + iScale*errorScale;         //Recoil 
     pFrac1    = pFrac1    + iFlucU1*(errorResU1);        //Mean RMS 
@@ -438,29 +577,29 @@ void RecoilCorrector::metDistributionType2CorrU(double &iMet,double &iMPhi,doubl
 						double &iU1,double &iU2,double iFlucU2, double iFlucU1, double iScale,
 						bool doSingleGauss) {
   
-  double pDefU1    = iU1Default->Eval(iGenPt);
+  double pDefU1    = Eval(iU1Default,iGenPt);
   double lRescale  = sqrt((TMath::Pi())/2.);
-  double pDU1       = iU1RZDatFit ->Eval(iGenPt);
+  double pDU1       = Eval(iU1RZDatFit,iGenPt);
   //double pDU2       = 0; sPM                                                                                                                                                         
-  double pDFrac1    = iU1MSZDatFit->Eval(iGenPt)*lRescale;
-  double pDSigma1_1 = iU1S1ZDatFit->Eval(iGenPt)*pDFrac1;
-  double pDSigma1_2 = iU1S2ZDatFit->Eval(iGenPt)*pDFrac1;
+  double pDFrac1    = Eval(iU1MSZDatFit,iGenPt)*lRescale;
+  double pDSigma1_1 = Eval(iU1S1ZDatFit,iGenPt)*pDFrac1;
+  double pDSigma1_2 = Eval(iU1S2ZDatFit,iGenPt)*pDFrac1;
 
-  double pDFrac2    = iU2MSZDatFit->Eval(iGenPt)*lRescale;
-  double pDSigma2_1 = iU2S1ZDatFit->Eval(iGenPt)*pDFrac2;
-  double pDSigma2_2 = iU2S2ZDatFit->Eval(iGenPt)*pDFrac2;
+  double pDFrac2    = Eval(iU2MSZDatFit,iGenPt)*lRescale;
+  double pDSigma2_1 = Eval(iU2S1ZDatFit,iGenPt)*pDFrac2;
+  double pDSigma2_2 = Eval(iU2S2ZDatFit,iGenPt)*pDFrac2;
   //double pDMean1    = pDFrac1;                                                                                                                                                       
   //double pDMean2    = pDFrac2;                                                                                                                                                       
 
-  double pMU1       = iU1RZMCFit  ->Eval(iGenPt);
+  double pMU1       = Eval(iU1RZMCFit,iGenPt);
   //  double pMU2       = 0;                                                                                                                                                           
-  double pMFrac1    = iU1MSZMCFit ->Eval(iGenPt)*lRescale;
-  double pMSigma1_1 = iU1S1ZMCFit ->Eval(iGenPt)*pMFrac1;
-  double pMSigma1_2 = iU1S2ZMCFit ->Eval(iGenPt)*pMFrac1;
+  double pMFrac1    = Eval(iU1MSZMCFit,iGenPt)*lRescale;
+  double pMSigma1_1 = Eval(iU1S1ZMCFit,iGenPt)*pMFrac1;
+  double pMSigma1_2 = Eval(iU1S2ZMCFit,iGenPt)*pMFrac1;
 
-  double pMFrac2    = iU2MSZMCFit ->Eval(iGenPt)*lRescale;
-  double pMSigma2_1 = iU2S1ZMCFit ->Eval(iGenPt)*pMFrac2;
-  double pMSigma2_2 = iU2S2ZMCFit ->Eval(iGenPt)*pMFrac2;
+  double pMFrac2    = Eval(iU2MSZMCFit,iGenPt)*lRescale;
+  double pMSigma2_1 = Eval(iU2S1ZMCFit,iGenPt)*pMFrac2;
+  double pMSigma2_2 = Eval(iU2S2ZMCFit,iGenPt)*pMFrac2;
 
   //double pMMean1    = pMFrac1;                                                                                                                                                       
   //double pMMean2    = pMFrac2;                                
@@ -484,14 +623,14 @@ void RecoilCorrector::metDistributionType2CorrU(double &iMet,double &iMPhi,doubl
   double pCos  = - (pUX*cos(iGenPhi) + pUY*sin(iGenPhi))/pU;
   double pSin  =   (pUX*sin(iGenPhi) - pUY*cos(iGenPhi))/pU;
 
-  double offset = iU1RZMCFit->Eval(iGenPt);
+  double offset = Eval(iU1RZMCFit,iGenPt);
 
   bool scaleU2=true;
 
-  double normSigmaM = iU2MSZMCFit ->Eval(iGenPt)/iU1MSZMCFit ->Eval(iGenPt);
-  if(!scaleU2) normSigmaM = iU1MSZMCFit ->Eval(iGenPt)/iU2MSZMCFit ->Eval(iGenPt);
-  double normSigmaD = iU2MSZDatFit ->Eval(iGenPt)/iU1MSZDatFit ->Eval(iGenPt);
-  if(!scaleU2) normSigmaD = iU1MSZDatFit ->Eval(iGenPt)/iU2MSZDatFit ->Eval(iGenPt);
+  double normSigmaM = Eval(iU2MSZMCFit,iGenPt)/Eval(iU1MSZMCFit,iGenPt);
+  if(!scaleU2) normSigmaM = Eval(iU1MSZMCFit,iGenPt)/Eval(iU2MSZMCFit,iGenPt);
+  double normSigmaD = Eval(iU2MSZDatFit,iGenPt)/Eval(iU1MSZDatFit,iGenPt);
+  if(!scaleU2) normSigmaD = Eval(iU1MSZDatFit,iGenPt)/Eval(iU2MSZDatFit,iGenPt);
 
   double pU1   = pU*pCos;
   double pU2   = pU*pSin;
@@ -511,11 +650,11 @@ void RecoilCorrector::metDistributionType2CorrU(double &iMet,double &iMPhi,doubl
 
   if(doSingleGauss) {
 
-    if(scaleU2) pUValM         = diGausPVal(fabs(recoil),1,iU2MSZMCFit ->Eval(iGenPt)*lRescale,0);
-    if(scaleU2) pUValD         = oneGausPInverse(pUValM ,1,iU2MSZDatFit->Eval(iGenPt)*lRescale,0);
+    if(scaleU2) pUValM         = diGausPVal(fabs(recoil),1,Eval(iU2MSZMCFit,iGenPt)*lRescale,0);
+    if(scaleU2) pUValD         = oneGausPInverse(pUValM ,1,Eval(iU2MSZDatFit,iGenPt)*lRescale,0);
 
-    if(!scaleU2) pUValM         = diGausPVal(fabs(recoil),1,iU1MSZMCFit ->Eval(iGenPt)*lRescale,0);
-    if(!scaleU2) pUValD         = oneGausPInverse(pUValM ,1,iU1MSZDatFit->Eval(iGenPt)*lRescale,0);
+    if(!scaleU2) pUValM         = diGausPVal(fabs(recoil),1,Eval(iU1MSZMCFit,iGenPt)*lRescale,0);
+    if(!scaleU2) pUValD         = oneGausPInverse(pUValM ,1,Eval(iU1MSZDatFit,iGenPt)*lRescale,0);
 
   } else {
 
@@ -562,9 +701,20 @@ double RecoilCorrector::diGausPInverse(double iPVal,double iFrac,double iSigma1,
   //Iterative procedure to invert a double gaussian given a PVal
   //  int lId = 0; int lN1 = 4;  int lN2 = 10; 
   int lId = 0; int lN1 = 10;  int lN2 = 100; 
+  //For a proper mixture the p-value increases along the grid: the first point above iPVal is found by bisection
+  bool lMonotonic = iFrac >= 0 && iFrac <= 1 && iSigma1 > 0 && iSigma2 > 0;
   for(int i0 = 0; i0 < lN1; i0++) { 
     if(i0 != 0) lMin = lMin + (lId-1)*lDiff/lN2;
     if(i0 != 0) lDiff/=lN2;
+    if(lMonotonic) { 
+      int lLo = 0; int lHi = lN2;
+      while(lLo < lHi) { 
+        int lMid = (lLo+lHi)/2;
+        if(diGausPVal(lMin + lDiff/lN2*lMid,iFrac,iSigma1,iSigma2) > iPVal) lHi = lMid; else lLo = lMid+1;
+      }
+      if(lLo < lN2) lId = lLo;
+      continue;
+    }
     for(int i1 = 0; i1 < lN2; i1++) { 
       double pVal = lMin + lDiff/lN2*i1;
       pVal = diGausPVal(pVal,iFrac,iSigma1,iSigma2);
@@ -600,27 +750,27 @@ void RecoilCorrector::metDistributionType2(double &iMet,double &iMPhi,double iGe
 					   bool doSingleGauss) {
   //  cout << "inside metType2 " << endl;
 
-  double pDefU1    = iU1Default->Eval(iGenPt);
+  double pDefU1    = Eval(iU1Default,iGenPt);
   double lRescale  = sqrt((TMath::Pi())/2.);		     
-  double pDU1       = iU1RZDatFit ->Eval(iGenPt);
+  double pDU1       = Eval(iU1RZDatFit,iGenPt);
   //double pDU2       = 0; sPM
-  double pDFrac1    = iU1MSZDatFit->Eval(iGenPt)*lRescale;
-  double pDSigma1_1 = iU1S1ZDatFit->Eval(iGenPt)*pDFrac1;
-  double pDSigma1_2 = iU1S2ZDatFit->Eval(iGenPt)*pDFrac1;
-  double pDFrac2    = iU2MSZDatFit->Eval(iGenPt)*lRescale;
-  double pDSigma2_1 = iU2S1ZDatFit->Eval(iGenPt)*pDFrac2;
-  double pDSigma2_2 = iU2S2ZDatFit->Eval(iGenPt)*pDFrac2;
+  double pDFrac1    = Eval(iU1MSZDatFit,iGenPt)*lRescale;
+  double pDSigma1_1 = Eval(iU1S1ZDatFit,iGenPt)*pDFrac1;
+  double pDSigma1_2 = Eval(iU1S2ZDatFit,iGenPt)*pDFrac1;
+  double pDFrac2    = Eval(iU2MSZDatFit,iGenPt)*lRescale;
+  double pDSigma2_1 = Eval(iU2S1ZDatFit,iGenPt)*pDFrac2;
+  double pDSigma2_2 = Eval(iU2S2ZDatFit,iGenPt)*pDFrac2;
   //double pDMean1    = pDFrac1;
   //double pDMean2    = pDFrac2;
  
-  double pMU1       = iU1RZMCFit  ->Eval(iGenPt);
+  double pMU1       = Eval(iU1RZMCFit,iGenPt);
   //  double pMU2       = 0; 
-  double pMFrac1    = iU1MSZMCFit ->Eval(iGenPt)*lRescale;
-  double pMSigma1_1 = iU1S1ZMCFit ->Eval(iGenPt)*pMFrac1;
-  double pMSigma1_2 = iU1S2ZMCFit ->Eval(iGenPt)*pMFrac1;
-  double pMFrac2    = iU2MSZMCFit ->Eval(iGenPt)*lRescale;
-  double pMSigma2_1 = iU2S1ZMCFit ->Eval(iGenPt)*pMFrac2;
-  double pMSigma2_2 = iU2S2ZMCFit ->Eval(iGenPt)*pMFrac2;
+  double pMFrac1    = Eval(iU1MSZMCFit,iGenPt)*lRescale;
+  double pMSigma1_1 = Eval(iU1S1ZMCFit,iGenPt)*pMFrac1;
+  double pMSigma1_2 = Eval(iU1S2ZMCFit,iGenPt)*pMFrac1;
+  double pMFrac2    = Eval(iU2MSZMCFit,iGenPt)*lRescale;
+  double pMSigma2_1 = Eval(iU2S1ZMCFit,iGenPt)*pMFrac2;
+  double pMSigma2_2 = Eval(iU2S2ZMCFit,iGenPt)*pMFrac2;
   //double pMMean1    = pMFrac1;
   //double pMMean2    = pMFrac2;
   //Uncertainty propagation
@@ -695,10 +845,10 @@ void RecoilCorrector::metDistributionType2(double &iMet,double &iMPhi,double iGe
 
   if(doSingleGauss) {
 
-    pU1ValM         = diGausPVal(fabs(pU1Diff),1,iU1MSZMCFit ->Eval(iGenPt)*lRescale,0); // when is singleGauss pMFrac1=1 pMSigma1_1=fullRMS pMSigma1_2=0                                   
-    pU2ValM         = diGausPVal(fabs(pU2Diff),1,iU2MSZMCFit ->Eval(iGenPt)*lRescale,0);
-    pU1ValD         = oneGausPInverse(pU1ValM  ,1,iU1MSZDatFit->Eval(iGenPt)*lRescale,0);
-    pU2ValD         = oneGausPInverse(pU2ValM  ,1,iU2MSZDatFit->Eval(iGenPt)*lRescale,0);
+    pU1ValM         = diGausPVal(fabs(pU1Diff),1,Eval(iU1MSZMCFit,iGenPt)*lRescale,0); // when is singleGauss pMFrac1=1 pMSigma1_1=fullRMS pMSigma1_2=0                                   
+    pU2ValM         = diGausPVal(fabs(pU2Diff),1,Eval(iU2MSZMCFit,iGenPt)*lRescale,0);
+    pU1ValD         = oneGausPInverse(pU1ValM  ,1,Eval(iU1MSZDatFit,iGenPt)*lRescale,0);
+    pU2ValD         = oneGausPInverse(pU2ValM  ,1,Eval(iU2MSZDatFit,iGenPt)*lRescale,0);
 
   } else {
 
@@ -729,15 +879,15 @@ void RecoilCorrector::metDistributionType2(double &iMet,double &iMPhi,double iGe
 
   /*
   //Not Used Current
-  iU1U2ZMCCorr ->Eval(iGenPt);
-  iU1U2ZDatCorr->Eval(iGenPt);
+  Eval(iU1U2ZMCCorr,iGenPt);
+  Eval(iU1U2ZDatCorr,iGenPt);
   */
 
 }
 
 void RecoilCorrector::metDistribution(double &iPFMet,double &iPFMPhi,double &iTKMet,double &iTKMPhi,
 				      double iGenPt,double iGenPhi,
-		                      double iLepPt,double iLepPhi,TRandom3 *iRand,
+		                      double iLepPt,double iLepPhi,Random *iRand,
 		                      TF1 *iU1RPFFit,   TF1 *iU1RTKFit,
 		                      TF1 *iU1MSPFFit,  TF1 *iU1MSTKFit, 
 		                      TF1 *iU1S1PFFit,  TF1 *iU1S1TKFit,
@@ -753,25 +903,25 @@ void RecoilCorrector::metDistribution(double &iPFMet,double &iPFMPhi,double &iTK
   //Important constants re-scaling of sigma on left and mean wpt of W resbos on right
   double lRescale  = sqrt((TMath::Pi())/2.); //double lPtMean = 16.3; //==> tuned for W bosons
   ///
-  double pPFU1       = CorrVal(iGenPt,iU1RPFFit->Eval(iGenPt),PFU1);
+  double pPFU1       = CorrVal(iGenPt,Eval(iU1RPFFit,iGenPt),PFU1);
   double pPFU2       = 0;
-  double pPFSigma1_1 = CorrVal(iGenPt,iU1S1PFFit->Eval(iGenPt),PFS1U1)*CorrVal(iGenPt,iU1MSPFFit->Eval(iGenPt),PFMSU1)*lRescale;
-  double pPFSigma1_2 = CorrVal(iGenPt,iU1S2PFFit->Eval(iGenPt),PFS2U1)*CorrVal(iGenPt,iU1MSPFFit->Eval(iGenPt),PFMSU1)*lRescale;
-  double pPFFrac1    = CorrVal(iGenPt,iU1MSPFFit->Eval(iGenPt),PFMSU1)                         *lRescale;
-  double pPFSigma2_1 = CorrVal(iGenPt,iU2S1PFFit->Eval(iGenPt),PFS1U2)*CorrVal(iGenPt,iU2MSPFFit->Eval(iGenPt),PFMSU2)*lRescale;
-  double pPFSigma2_2 = CorrVal(iGenPt,iU2S2PFFit->Eval(iGenPt),PFS2U2)*CorrVal(iGenPt,iU2MSPFFit->Eval(iGenPt),PFMSU2)*lRescale;
-  double pPFFrac2    = CorrVal(iGenPt,iU2MSPFFit->Eval(iGenPt),PFMSU2)                         *lRescale;
+  double pPFSigma1_1 = CorrVal(iGenPt,Eval(iU1S1PFFit,iGenPt),PFS1U1)*CorrVal(iGenPt,Eval(iU1MSPFFit,iGenPt),PFMSU1)*lRescale;
+  double pPFSigma1_2 = CorrVal(iGenPt,Eval(iU1S2PFFit,iGenPt),PFS2U1)*CorrVal(iGenPt,Eval(iU1MSPFFit,iGenPt),PFMSU1)*lRescale;
+  double pPFFrac1    = CorrVal(iGenPt,Eval(iU1MSPFFit,iGenPt),PFMSU1)                         *lRescale;
+  double pPFSigma2_1 = CorrVal(iGenPt,Eval(iU2S1PFFit,iGenPt),PFS1U2)*CorrVal(iGenPt,Eval(iU2MSPFFit,iGenPt),PFMSU2)*lRescale;
+  double pPFSigma2_2 = CorrVal(iGenPt,Eval(iU2S2PFFit,iGenPt),PFS2U2)*CorrVal(iGenPt,Eval(iU2MSPFFit,iGenPt),PFMSU2)*lRescale;
+  double pPFFrac2    = CorrVal(iGenPt,Eval(iU2MSPFFit,iGenPt),PFMSU2)                         *lRescale;
   if(pPFSigma1_1 > pPFSigma1_2) {double pT = pPFSigma1_2; pPFSigma1_2 = pPFSigma1_1; pPFSigma1_1 = pT;}
   if(pPFSigma2_1 > pPFSigma2_2) {double pT = pPFSigma2_2; pPFSigma2_2 = pPFSigma2_1; pPFSigma2_2 = pT;}
   
-  double pTKU1       = CorrVal(iGenPt,iU1RTKFit->Eval(iGenPt),TKU1);
+  double pTKU1       = CorrVal(iGenPt,Eval(iU1RTKFit,iGenPt),TKU1);
   double pTKU2       = 0;
-  double pTKSigma1_1 = CorrVal(iGenPt,iU1S1TKFit->Eval(iGenPt),TKS1U1)*CorrVal(iGenPt,iU1MSTKFit->Eval(iGenPt),TKMSU1)*lRescale;
-  double pTKSigma1_2 = CorrVal(iGenPt,iU1S2TKFit->Eval(iGenPt),TKS2U1)*CorrVal(iGenPt,iU1MSTKFit->Eval(iGenPt),TKMSU1)*lRescale;
-  double pTKFrac1    = CorrVal(iGenPt,iU1MSTKFit->Eval(iGenPt),TKMSU1)                         *lRescale;
-  double pTKSigma2_1 = CorrVal(iGenPt,iU2S1TKFit->Eval(iGenPt),TKS1U2)*CorrVal(iGenPt,iU2MSTKFit->Eval(iGenPt),TKMSU2)*lRescale;
-  double pTKSigma2_2 = CorrVal(iGenPt,iU2S2TKFit->Eval(iGenPt),TKS2U2)*CorrVal(iGenPt,iU2MSTKFit->Eval(iGenPt),TKMSU2)*lRescale;
-  double pTKFrac2    = CorrVal(iGenPt,iU2MSTKFit->Eval(iGenPt),TKMSU2)                         *lRescale;
+  double pTKSigma1_1 = CorrVal(iGenPt,Eval(iU1S1TKFit,iGenPt),TKS1U1)*CorrVal(iGenPt,Eval(iU1MSTKFit,iGenPt),TKMSU1)*lRescale;
+  double pTKSigma1_2 = CorrVal(iGenPt,Eval(iU1S2TKFit,iGenPt),TKS2U1)*CorrVal(iGenPt,Eval(iU1MSTKFit,iGenPt),TKMSU1)*lRescale;
+  double pTKFrac1    = CorrVal(iGenPt,Eval(iU1MSTKFit,iGenPt),TKMSU1)                         *lRescale;
+  double pTKSigma2_1 = CorrVal(iGenPt,Eval(iU2S1TKFit,iGenPt),TKS1U2)*CorrVal(iGenPt,Eval(iU2MSTKFit,iGenPt),TKMSU2)*lRescale;
+  double pTKSigma2_2 = CorrVal(iGenPt,Eval(iU2S2TKFit,iGenPt),TKS2U2)*CorrVal(iGenPt,Eval(iU2MSTKFit,iGenPt),TKMSU2)*lRescale;
+  double pTKFrac2    = CorrVal(iGenPt,Eval(iU2MSTKFit,iGenPt),TKMSU2)                         *lRescale;
   if(pTKSigma1_1 > pTKSigma1_2) {double pT = pTKSigma1_2; pTKSigma1_2 = pTKSigma1_1; pTKSigma1_1 = pT;}
   if(pTKSigma2_1 > pTKSigma2_2) {double pT = pTKSigma2_2; pTKSigma2_2 = pTKSigma2_1; pTKSigma2_2 = pT;}
 
@@ -786,8 +936,8 @@ void RecoilCorrector::metDistribution(double &iPFMet,double &iPFMPhi,double &iTK
     double lEU2Frac = getError(iGenPt ,iU2MSPFFit, PFMSU2)*lRescale;
     //cout << "===> " << pPFSigma1_1 << " -- " << iU1S2PFFit->GetParError(0) << " -- " << lEUS1_1 << endl;
     //Modify all the different parameters the choice of signs makes it maximal
-    if(iU1S1PFFit->Eval(iGenPt) > 1) {double pPF = lEUS1_1; lEUS1_1 = lEUS1_2; lEUS1_1 = pPF;}
-    if(iU2S1PFFit->Eval(iGenPt) > 1) {double pPF = lEUS2_1; lEUS2_1 = lEUS2_2; lEUS2_1 = pPF;}
+    if(Eval(iU1S1PFFit,iGenPt) > 1) {double pPF = lEUS1_1; lEUS1_1 = lEUS1_2; lEUS1_1 = pPF;}
+    if(Eval(iU2S1PFFit,iGenPt) > 1) {double pPF = lEUS2_1; lEUS2_1 = lEUS2_2; lEUS2_1 = pPF;}
 
     pPFU1       = pPFU1       + iScale*lEUR1;              //Recoil
     pPFFrac1    = pPFFrac1    + iFluc*(lEU1Frac);        //Mean RMS 
@@ -804,8 +954,8 @@ void RecoilCorrector::metDistribution(double &iPFMet,double &iPFMPhi,double &iTK
     lEUS2_1  = getError(iGenPt,iU2S1TKFit,TKS1U2);
     lEUS2_2  = getError(iGenPt,iU2S2TKFit,TKS2U2);
     lEU2Frac = getError(iGenPt,iU2MSTKFit,TKMSU2)*lRescale;
-    if(iU1S1TKFit->Eval(iGenPt) > 1) {double pPF = lEUS1_1; lEUS1_1 = lEUS1_2; lEUS1_1 = pPF;}
-    if(iU2S1TKFit->Eval(iGenPt) > 1) {double pPF = lEUS2_1; lEUS2_1 = lEUS2_2; lEUS2_1 = pPF;}
+    if(Eval(iU1S1TKFit,iGenPt) > 1) {double pPF = lEUS1_1; lEUS1_1 = lEUS1_2; lEUS1_1 = pPF;}
+    if(Eval(iU2S1TKFit,iGenPt) > 1) {double pPF = lEUS2_1; lEUS2_1 = lEUS2_2; lEUS2_1 = pPF;}
     //Modify all the different parameters the choice of signs makes it maximal
     pTKU1       = pTKU1        + iScale*lEUR1;              //Recoil
     pTKFrac1    = pTKFrac1     + iFluc*(lEU1Frac);        //Mean RMS 
@@ -837,12 +987,12 @@ void RecoilCorrector::metDistribution(double &iPFMet,double &iPFMPhi,double &iTK
   double pTKCorr1     = iRand->Gaus(0,1);     double pTKCorr2     = iRand->Gaus(0,1);  
   //double pTKCorrT1    = iRand->Gaus(0,1);     double pTKCorrT2    = iRand->Gaus(0,1);  
 
-  double lPFU1U2  = TMath::Max(iPFU1U2Corr->Eval(iGenPt),0.);//iPFU1U2Corr->Eval(iGenPt) ,0.);
-  double lTKU1U2  = TMath::Max(iTKU1U2Corr->Eval(iGenPt),0.);//iTKU1U2Corr->Eval(iGenPt) ,0.);
-  double lPFTKU1  = iPFTKU1Corr ->Eval(iGenPt); //TMath::Max(iPFTKU1Corr->Eval(iGenPt) ,0.);
-  double lPFTKU2  = iPFTKU2Corr ->Eval(iGenPt);//TMath::Max(iPFTKU2Corr->Eval(iGenPt) ,0.);
-  double lPFTKU1M = iPFTKU1MCorr->Eval(iGenPt);
-  double lPFTKU2M = iPFTKU2MCorr->Eval(iGenPt);
+  double lPFU1U2  = TMath::Max(Eval(iPFU1U2Corr,iGenPt),0.);//iPFU1U2Corr->Eval(iGenPt) ,0.);
+  double lTKU1U2  = TMath::Max(Eval(iTKU1U2Corr,iGenPt),0.);//iTKU1U2Corr->Eval(iGenPt) ,0.);
+  double lPFTKU1  = Eval(iPFTKU1Corr,iGenPt); //TMath::Max(iPFTKU1Corr->Eval(iGenPt) ,0.);
+  double lPFTKU2  = Eval(iPFTKU2Corr,iGenPt);//TMath::Max(iPFTKU2Corr->Eval(iGenPt) ,0.);
+  double lPFTKU1M = Eval(iPFTKU1MCorr,iGenPt);
+  double lPFTKU2M = Eval(iPFTKU2MCorr,iGenPt);
 
   //Needs some more work
   double pScale = 1.; //pPFFrac1 = (pPFFrac1+pPFFrac2)/2.; //pPFFrac2 = pPFFrac1;//+pPFFrac2)/2.;
@@ -936,9 +1086,9 @@ double RecoilCorrector::getError(double iVal,TF1 *iFit,Recoil iType) {
   double lEW2  = getError2(iVal,iFit);
   double lEZD2 = getError2(iVal,getFunc(true ,iType));
   double lEZM2 = getError2(iVal,getFunc(false,iType));
-  double lZDat = getFunc(true ,iType)->Eval(iVal);
-  double lZMC  = getFunc(false,iType)->Eval(iVal);
-  double lWMC  = iFit                ->Eval(iVal);
+  double lZDat = Eval(getFunc(true ,iType),iVal);
+  double lZMC  = Eval(getFunc(false,iType),iVal);
+  double lWMC  = Eval(iFit,iVal);
   double lR    = lZDat/lZMC;
   double lER   = lR*lR/lZDat/lZDat*lEZD2 + lR*lR/lZMC/lZMC*lEZM2;
   double lVal  = lR*lR*lEW2 + lWMC*lWMC*lER;
@@ -1,4 +1,5 @@
 #include "CMGTools/RootTools/interface/RecoilCorrector.h"
+#include "CMGTools/RootTools/interface/CalibrationPayload.h"
 
 namespace {
   namespace {
@@ -0,0 +1,78 @@
+// Compares cmg::GridRhoSigmaEstimator with fastjet::GridMedianBackgroundEstimator
+// on random events, for several grids filled together; rho and sigma must be
+// the same to the bit. Run with scram b runtests; exits with status 1 on a mismatch.
+
+#include "CMGTools/RootTools/interface/GridRhoSigmaEstimator.h"
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/tools/GridMedianBackgroundEstimator.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+  struct GridDef { double rapMin, rapMax, spacing; };
+
+  // nParticles particles with an exponential pt spectrum, flat in eta and phi, with a few
+  // massless ones along the beam
+  std::vector<fastjet::PseudoJet> makeEvent(std::mt19937 &rng, int nParticles, double etaMax) {
+    std::exponential_distribution<double> pt(1.0);
+    std::uniform_real_distribution<double> eta(-etaMax, etaMax), phi(-M_PI, M_PI), u(0., 1.);
+    std::vector<fastjet::PseudoJet> ret;
+    for (int i = 0; i < nParticles; ++i) {
+      if (u(rng) < 0.01) {
+        const double pz = (u(rng) < 0.5 ? -1 : 1) * 100*u(rng);
+        ret.push_back(fastjet::PseudoJet(0., 0., pz, std::abs(pz)));
+        continue;
+      }
+      const double p = 0.2 + pt(rng), y = eta(rng), f = phi(rng), m = (u(rng) < 0.5 ? 0. : 0.1396);
+      fastjet::PseudoJet pj;
+      pj.reset_PtYPhiM(p, y, f, m);
+      ret.push_back(pj);
+    }
+    return ret;
+  }
+
+}
+
+int main() {
+  const GridDef defs[] = { { -5.0, 5.0, 0.55 }, { -2.5, 2.5, 0.55 }, { -3.0, 3.0, 0.3 }, { -4.7, 2.0, 0.6 }, { -1.0, 1.0, 2.0 } };
+  const size_t nDefs = sizeof(defs)/sizeof(defs[0]);
+
+  cmg::GridRhoSigmaEstimator est;
+  for (size_t ig = 0; ig < nDefs; ++ig) est.addGrid(defs[ig].rapMin, defs[ig].rapMax, defs[ig].spacing);
+
+  std::mt19937 rng(20151019);
+  std::uniform_int_distribution<int> mult(0, 3000);
+  int nEvents = 0, nBad = 0;
+  for (int iev = 0; iev < 2000; ++iev) {
+    // a few empty and almost empty events, where most cells have zero pt
+    const int n = (iev < 10 ? iev : (iev % 5 == 0 ? mult(rng)/50 : mult(rng)));
+    const std::vector<fastjet::PseudoJet> particles = makeEvent(rng, n, 6.0);
+
+    est.reset();
+    for (size_t i = 0; i < particles.size(); ++i) {
+      est.add(particles[i].px(), particles[i].py(), particles[i].pz(), particles[i].E());
+    }
+    est.compute();
+
+    for (size_t ig = 0; ig < nDefs; ++ig) {
+      fastjet::RectangularGrid grid(defs[ig].rapMin, defs[ig].rapMax, defs[ig].spacing, defs[ig].spacing);
+      fastjet::GridMedianBackgroundEstimator bge(grid);
+      bge.set_particles(particles);
+      if (bge.rho() != est.rho(ig) || bge.sigma() != est.sigma(ig)) {
+        if (++nBad <= 10) {
+          printf("event %d, grid %g to %g spacing %g: rho %.17g sigma %.17g, fastjet rho %.17g sigma %.17g\n",
+                 iev, defs[ig].rapMin, defs[ig].rapMax, defs[ig].spacing, est.rho(ig), est.sigma(ig), bge.rho(), bge.sigma());
+        }
+      }
+    }
+    ++nEvents;
+  }
+
+  printf("%d events, %d grids: %d mismatches with fastjet\n", nEvents, int(nDefs), nBad);
+  return nBad ? 1 : 0;
+}
@@ -4,6 +4,8 @@
 #include "TMatrixD.h"
 #include "TH1.h"
 
+#include "CMGTools/SVfitStandalone/interface/svFitStandaloneAuxFunctions.h"
+
 /**
    \class   probMET LikelihoodFunctions.h "CMGTools/SVfitStandalone/interface/LikelihoodFunctions.h"
    
@@ -18,6 +20,7 @@
              determined from MET significance algorithm)
     power  : additional power to enhance the nll term
 */
+double probMET(double dMETX, double dMETY, double covDet, const svFitStandalone::CovMatrix& covInv, double power = 1., bool verbosity = false);
 double probMET(double dMETX, double dMETY, double covDet, const TMatrixD& covInv, double power = 1., bool verbosity = false);
 
 /**
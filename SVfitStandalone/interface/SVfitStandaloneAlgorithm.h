@@ -289,6 +289,8 @@ class SVfitStandaloneAlgorithm
 {
  public:
   /// constructor from a minimal set of configurables
+  SVfitStandaloneAlgorithm(const std::vector<MeasuredTauLepton>& measuredTauLeptons, double measuredMETx, double measuredMETy, const svFitStandalone::CovMatrix& covMET, unsigned int verbosity = 0);
+  /// same, with the MET covariance as a TMatrixD
   SVfitStandaloneAlgorithm(const std::vector<MeasuredTauLepton>& measuredTauLeptons, double measuredMETx, double measuredMETy, const TMatrixD& covMET, unsigned int verbosity = 0);
   /// destructor
   ~SVfitStandaloneAlgorithm();
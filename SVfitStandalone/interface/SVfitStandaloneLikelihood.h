@@ -242,6 +242,8 @@ namespace svFitStandalone
       LeptonNumber    = 0x00000010
     };
     /// constructor with a minimla set of configurables 
+    SVfitStandaloneLikelihood(const std::vector<svFitStandalone::MeasuredTauLepton>& measuredTauLeptons, const svFitStandalone::Vector& measuredMET, const svFitStandalone::CovMatrix& covMET, bool verbosity);
+    /// same, with the MET covariance as a TMatrixD
     SVfitStandaloneLikelihood(const std::vector<svFitStandalone::MeasuredTauLepton>& measuredTauLeptons, const svFitStandalone::Vector& measuredMET, const TMatrixD& covMET, bool verbosity);
     /// default destructor
     ~SVfitStandaloneLikelihood() {}
@@ -319,7 +321,7 @@ namespace svFitStandalone
     /// measured MET
     svFitStandalone::Vector measuredMET_;
     /// transfer matrix for MET in (inverse covariance matrix) 
-    TMatrixD invCovMET_;
+    svFitStandalone::CovMatrix invCovMET_;
     /// determinant of the covariance matrix of MET
     double covDet_;
     /// error code that can be passed on
@@ -2,8 +2,10 @@
 #define CMGTools_SVfitStandAlone_svFitStandAloneAuxFunctions_h
 
 #include <TH1.h>
+#include <TMatrixD.h>
 #include "Math/LorentzVector.h"
 #include "Math/Vector3D.h"
+#include "Math/SMatrix.h"
 
 namespace svFitStandalone
 {
@@ -57,6 +59,21 @@ namespace svFitStandalone
      \brief   lorentz vector (equivalent to reco::Candidate::LorentzVector)
   */
   typedef ROOT::Math::LorentzVector<ROOT::Math::PxPyPzE4D<double> > LorentzVector;
+  /**
+     \typedef SVfitStandalone::CovMatrix
+     \brief   symmetric 2x2 covariance matrix of the MET (and its inverse)
+  */
+  typedef ROOT::Math::SMatrix<double,2,2,ROOT::Math::MatRepSym<double,2> > CovMatrix;
+
+  /// conversion from the 2x2 TMatrixD of the former interface (off-diagonal elements are averaged)
+  inline CovMatrix toCovMatrix(const TMatrixD& cov)
+  {
+    CovMatrix result;
+    result(0,0) = cov(0,0);
+    result(0,1) = 0.5*(cov(0,1) + cov(1,0));
+    result(1,1) = cov(1,1);
+    return result;
+  }
 
   double roundToNdigits(double, int = 3);
 
@@ -12,6 +12,12 @@ using namespace svFitStandalone;
 
 double 
 probMET(double dMETX, double dMETY, double covDet, const TMatrixD& covInv, double power, bool verbosity)
+{
+  return probMET(dMETX, dMETY, covDet, toCovMatrix(covInv), power, verbosity);
+}
+
+double 
+probMET(double dMETX, double dMETY, double covDet, const CovMatrix& covInv, double power, bool verbosity)
 {
 #ifdef SVFIT_DEBUG 
   if ( verbosity ) {
@@ -20,13 +26,13 @@ probMET(double dMETX, double dMETY, double covDet, const TMatrixD& covInv, doubl
     std::cout << " dMETY = " << dMETY << std::endl;
     std::cout << " covDet = " << covDet << std::endl;
     std::cout << " covInv:" << std::endl;
-    covInv.Print();
+    std::cout << covInv << std::endl;
   }
 #endif 
   double nll = 0.;
   if ( covDet != 0. ) {
     nll = TMath::Log(2.*TMath::Pi()) + 0.5*TMath::Log(TMath::Abs(covDet)) 
-         + 0.5*(dMETX*(covInv(0,0)*dMETX + covInv(0,1)*dMETY) + dMETY*(covInv(1,0)*dMETX + covInv(1,1)*dMETY));
+         + 0.5*(covInv(0,0)*dMETX*dMETX + 2.*covInv(0,1)*dMETX*dMETY + covInv(1,1)*dMETY*dMETY);
   } else {
     nll = std::numeric_limits<float>::max();
   }
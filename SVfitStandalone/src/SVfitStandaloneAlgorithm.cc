@@ -202,6 +202,12 @@ namespace svFitStandalone
 
 SVfitStandaloneAlgorithm::SVfitStandaloneAlgorithm(const std::vector<svFitStandalone::MeasuredTauLepton>& measuredTauLeptons, double measuredMETx, double measuredMETy, const TMatrixD& covMET, 
                unsigned int verbosity) 
+  : SVfitStandaloneAlgorithm(measuredTauLeptons, measuredMETx, measuredMETy, svFitStandalone::toCovMatrix(covMET), verbosity)
+{
+}
+
+SVfitStandaloneAlgorithm::SVfitStandaloneAlgorithm(const std::vector<svFitStandalone::MeasuredTauLepton>& measuredTauLeptons, double measuredMETx, double measuredMETy, const svFitStandalone::CovMatrix& covMET, 
+               unsigned int verbosity) 
   : fitStatus_(-1), 
     verbosity_(verbosity), 
     maxObjFunctionCalls_(10000),
@@ -255,20 +261,19 @@ SVfitStandaloneAlgorithm::SVfitStandaloneAlgorithm(const std::vector<svFitStanda
   double measuredMETx_rounded = svFitStandalone::roundToNdigits(measuredMETx);
   double measuredMETy_rounded = svFitStandalone::roundToNdigits(measuredMETy);
   svFitStandalone::Vector measuredMET_rounded(measuredMETx_rounded, measuredMETy_rounded, 0.);
-  TMatrixD covMET_rounded(2,2);
-  covMET_rounded[0][0] = svFitStandalone::roundToNdigits(covMET[0][0]);
-  covMET_rounded[1][0] = svFitStandalone::roundToNdigits(covMET[1][0]);
-  covMET_rounded[0][1] = svFitStandalone::roundToNdigits(covMET[0][1]);
-  covMET_rounded[1][1] = svFitStandalone::roundToNdigits(covMET[1][1]);
+  svFitStandalone::CovMatrix covMET_rounded;
+  covMET_rounded(0,0) = svFitStandalone::roundToNdigits(covMET(0,0));
+  covMET_rounded(0,1) = svFitStandalone::roundToNdigits(covMET(0,1));
+  covMET_rounded(1,1) = svFitStandalone::roundToNdigits(covMET(1,1));
   if ( verbosity_ >= 1 ) {
     std::cout << "MET: Px = " << measuredMETx_rounded << ", Py = " << measuredMETy_rounded << std::endl;
     std::cout << "covMET:" << std::endl;
-    covMET_rounded.Print();
+    std::cout << covMET_rounded << std::endl;
     TMatrixDSym covMET_sym(2);
-    covMET_sym(0,0) = covMET_rounded[0][0];
-    covMET_sym(0,1) = covMET_rounded[0][1];
-    covMET_sym(1,0) = covMET_rounded[1][0];
-    covMET_sym(1,1) = covMET_rounded[1][1];
+    covMET_sym(0,0) = covMET_rounded(0,0);
+    covMET_sym(0,1) = covMET_rounded(0,1);
+    covMET_sym(1,0) = covMET_rounded(1,0);
+    covMET_sym(1,1) = covMET_rounded(1,1);
     TMatrixD EigenVectors(2,2);
     EigenVectors = TMatrixDSymEigen(covMET_sym).GetEigenVectors();
     std::cout << "Eigenvectors =  { " << EigenVectors(0,0) << ", " << EigenVectors(1,0) << " (phi = " << TMath::ATan2(EigenVectors(1,0), EigenVectors(0,0)) << ") },"
@@ -15,6 +15,11 @@ const SVfitStandaloneLikelihood* SVfitStandaloneLikelihood::gSVfitStandaloneLike
 static bool FIRST = true;
 
 SVfitStandaloneLikelihood::SVfitStandaloneLikelihood(const std::vector<MeasuredTauLepton>& measuredTauLeptons, const Vector& measuredMET, const TMatrixD& covMET, bool verbosity) 
+  : SVfitStandaloneLikelihood(measuredTauLeptons, measuredMET, toCovMatrix(covMET), verbosity)
+{
+}
+
+SVfitStandaloneLikelihood::SVfitStandaloneLikelihood(const std::vector<MeasuredTauLepton>& measuredTauLeptons, const Vector& measuredMET, const CovMatrix& covMET, bool verbosity) 
   : metPower_(1.0), 
     addLogM_(false), 
     powerLogM_(1.),
@@ -23,7 +28,6 @@ SVfitStandaloneLikelihood::SVfitStandaloneLikelihood(const std::vector<MeasuredT
     addPhiPenalty_(true),
     verbosity_(verbosity), 
     idxObjFunctionCall_(0), 
-    invCovMET_(2,2),
     errorCode_(0),
     requirePhysicalSolution_(false),
     marginalizeVisMass_(false),
@@ -46,10 +50,12 @@ SVfitStandaloneLikelihood::SVfitStandaloneLikelihood(const std::vector<MeasuredT
     errorCode_ |= LeptonNumber;
   }
   // determine transfer matrix for MET
-  invCovMET_= covMET;
-  covDet_ = invCovMET_.Determinant();
+  // determinant and inverse of the 2x2 matrix in closed form, once for all the likelihood evaluations
+  covDet_ = covMET(0,0)*covMET(1,1) - covMET(0,1)*covMET(0,1);
   if ( covDet_ != 0 ) { 
-    invCovMET_.Invert(); 
+    invCovMET_(0,0) =  covMET(1,1)/covDet_;
+    invCovMET_(0,1) = -covMET(0,1)/covDet_;
+    invCovMET_(1,1) =  covMET(0,0)/covDet_;
   } else{
     std::cout << " >> ERROR: cannot invert MET covariance Matrix (det=0)." << std::endl;
     errorCode_ |= MatrixInversion;
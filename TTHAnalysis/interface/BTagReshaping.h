@@ -13,8 +13,10 @@
 #include <TGraph.h>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
 #include <TSpline.h>
-#include "Math/Interpolator.h"
 #define MAXPOINTS 200
 
 /*#if PROJECT_NAME == CMSSW
@@ -25,37 +27,106 @@
 #include "btag_payload_light.h"
 //#endif
 
+/// Tail integrals Integral(j, lastbin) of a discriminator histogram for all
+/// the bins j, computed once per histogram in a single pass.
+class BTagCDF
+{
+ public:
+   BTagCDF() : m_h(0), m_lastbin(0) {}
+   BTagCDF(TH1 *h, int lastbin=2001) : m_h(h), m_lastbin(lastbin), m_tail(lastbin+2, 0.)
+   {
+     int last = std::min(lastbin, h->GetNbinsX()+1);
+     for(int j = last; j >= 0; j--) m_tail[j] = m_tail[j+1] + h->GetBinContent(j);
+   }
+
+   int lastbin() const { return m_lastbin; }
+   double tail(int j) const { return m_tail[std::min(std::max(j,0),m_lastbin+1)]; }
+   int findBin(float x) const { return m_h->FindBin(x); }
+   float lowEdge(int j) const { return m_h->GetBinLowEdge(j); }
+
+ private:
+   TH1 * m_h;
+   int m_lastbin;
+   std::vector<double> m_tail;
+};
+
+/// Piecewise linear map through the points (x[i], y[i]), x increasing, as
+/// ROOT::Math::Interpolator with kLINEAR (NaN outside [x.front(), x.back()]),
+/// with the segment of a point found in O(1) from a uniform table of the range.
+class BTagLinearMap
+{
+ public:
+   BTagLinearMap() {}
+   BTagLinearMap(const std::vector<double> & x, const std::vector<double> & y, unsigned int ncells=256) : m_x(x), m_y(y), m_seg(ncells+1, 0)
+   {
+     m_x0 = x.front();
+     m_invStep = ncells/(x.back()-x.front());
+     unsigned int seg = 0;
+     for(unsigned int c = 0; c <= ncells; c++)
+     {
+       double xc = m_x0 + c/m_invStep;
+       while(seg+2 < m_x.size() && m_x[seg+1] <= xc) seg++;
+       m_seg[c] = seg;
+     }
+   }
+
+   double eval(double v) const
+   {
+     if(!(v >= m_x.front() && v <= m_x.back())) return std::numeric_limits<double>::quiet_NaN();
+     unsigned int seg = m_seg[std::min<unsigned int>((v-m_x0)*m_invStep, m_seg.size()-1)];
+     while(seg+2 < m_x.size() && m_x[seg+1] <= v) seg++;
+     while(seg > 0 && v < m_x[seg]) seg--; // rounding at the cell edges
+     double dx = m_x[seg+1]-m_x[seg];
+     return dx > 0 ? m_y[seg] + (v-m_x[seg])/dx*(m_y[seg+1]-m_y[seg]) : m_y[seg];
+   }
+
+ private:
+   std::vector<double> m_x, m_y;
+   double m_x0, m_invStep;
+   std::vector<unsigned int> m_seg; // segment at the start of each cell
+};
+
 class BTagShape 
 {
  public: 
    BTagShape(){}
    BTagShape(TFile *file ,const char * name,const std::vector<std::pair<float, float> > & cutsAndSF, float boundX, float boundY)
-
    {
-     TH1F * m_h = (TH1F *) file->Get(name);
+     init(BTagCDF((TH1F *) file->Get(name)), cutsAndSF, boundX, boundY);
+   }
+   BTagShape(const BTagCDF & cdf,const std::vector<std::pair<float, float> > & cutsAndSF, float boundX, float boundY)
+   {
+     init(cdf, cutsAndSF, boundX, boundY);
+   }
+
+   float eval(float x) const { return m_i.eval(x); }
+   /// discriminator before the reshaping that gives x
+   float inverse(float x) const { return m_inv.eval(x); }
 
+ private:
+   void init(const BTagCDF & cdf,const std::vector<std::pair<float, float> > & cutsAndSF, float boundX, float boundY)
+   {
     //compute equivalents
     std::vector<std::pair<float,float> > eq;
-    int lastbin =2001;
-    float integral =  m_h->Integral(-1,lastbin);
+    int lastbin = cdf.lastbin();
     for(unsigned int i =0;i<cutsAndSF.size(); i++)
     {
       float oldCut=cutsAndSF[i].first;
       float sf=cutsAndSF[i].second;
-      float originalIntegral = m_h->Integral(m_h->FindBin(oldCut),lastbin);
-      float originalLowEdge = m_h->GetBinLowEdge(m_h->FindBin(oldCut));
+      float originalIntegral = cdf.tail(cdf.findBin(oldCut));
+      float originalLowEdge = cdf.lowEdge(cdf.findBin(oldCut));
       std::cout << std::endl<<    " Scale Factor : " << sf << std::endl;
 //      float target=originalIntegral/sf;
       float target=originalIntegral*sf;
       std::cout << " Target " << target << " orig " << originalIntegral << std::endl;
       for(int j=lastbin; j> -1; j--)
       {
-        if(m_h->Integral(j,lastbin)>= target)
+        if(cdf.tail(j)>= target)
           {
              //equivalents.push_back(std::pair<float,float>(originalLowEdge,h->GetBinLowEdge(j))); 
-             eq.push_back(std::pair<float,float>(m_h->GetBinLowEdge(j),originalLowEdge)); 
-	     std::cout << "Found at " << j << " was " << m_h->FindBin(oldCut) <<  std::endl;
-	     std::cout << m_h->GetBinLowEdge(j) << " was " << originalLowEdge << " cut: " << oldCut <<  std::endl;
+             eq.push_back(std::pair<float,float>(cdf.lowEdge(j),originalLowEdge)); 
+	     std::cout << "Found at " << j << " was " << cdf.findBin(oldCut) <<  std::endl;
+	     std::cout << cdf.lowEdge(j) << " was " << originalLowEdge << " cut: " << oldCut <<  std::endl;
              break;
           }
       }
@@ -77,13 +148,11 @@ class BTagShape
       x.push_back(boundX);
       y.push_back(boundY);
 
-     m_i =  new ROOT::Math::Interpolator(x,y,ROOT::Math::Interpolation::kLINEAR);
+     m_i = BTagLinearMap(x,y);
+     m_inv = BTagLinearMap(y,x);
   }
-  
-  float eval(float x) { return m_i->Eval(x); } 
 
-private:
-  ROOT::Math::Interpolator * m_i;
+  BTagLinearMap m_i, m_inv;
 
 };
 
@@ -92,7 +161,7 @@ class EtaPtBin
  public:
  EtaPtBin(){}
  EtaPtBin(float emin,float emax,float ptmin,float ptmax) : etaMin(emin), etaMax(emax), ptMin(ptmin), ptMax(ptmax) {}
- bool contains(float eta,float pt) {return eta < etaMax && eta >= etaMin && pt < ptMax && pt >= ptMin ; } 
+ bool contains(float eta,float pt) const {return eta < etaMax && eta >= etaMin && pt < ptMax && pt >= ptMin ; } 
  float centerEta() { return (etaMax+etaMin)/2.;}
  float centerPt() { return (ptMax+ptMin)/2.;}
 
@@ -108,25 +177,75 @@ public:
    BinnedBTagShape(){}
   BinnedBTagShape(std::vector<EtaPtBin> & bins, std::vector< std::vector<std::pair<float, float> > > &  cutsAndSF, TFile * f, const char * name,float boundX,float boundY):m_bins(bins)
   {
-   for(unsigned int i =0; i < bins.size(); i++)
-   {
-     m_shapes.push_back( BTagShape(f , name, cutsAndSF[i],boundX,boundY));
-   }
- }
+   init(BTagCDF((TH1F *) f->Get(name)), cutsAndSF, boundX, boundY);
+  }
+  BinnedBTagShape(std::vector<EtaPtBin> & bins, std::vector< std::vector<std::pair<float, float> > > &  cutsAndSF, const BTagCDF & cdf,float boundX,float boundY):m_bins(bins)
+  {
+   init(cdf, cutsAndSF, boundX, boundY);
+  }
 
-  float  eval(float eta,float pt,float x) 
+  /// index of the first bin containing (|eta|, pt), -1 if none
+  int findBin(float eta,float pt) const
   {
-      for(unsigned int i =0; i < m_bins.size(); i++)
-      {
-         if(m_bins[i].contains(fabs(eta),pt)) return m_shapes[i].eval(x);
-      }
-      //    std::cout << "Cannot reshape eta pt discr "  << eta << " " << pt << " " << x << std::endl; 
+    int ie = cellOf(m_etaEdges, fabs(eta)), ip = cellOf(m_ptEdges, pt);
+    if(ie < 0 || ip < 0) return -1;
+    return m_cellBin[ie*(m_ptEdges.size()-1) + ip];
+  }
+
+  float  eval(float eta,float pt,float x) const
+  {
+    int i = findBin(eta,pt);
+    if(i >= 0) return m_shapes[i].eval(x);
+    //    std::cout << "Cannot reshape eta pt discr "  << eta << " " << pt << " " << x << std::endl; 
     return x;
   }
 
  std::vector<BTagShape> m_shapes;
  std::vector<EtaPtBin> m_bins; 
 
+ private:
+  // the bin edges cut the (|eta|, pt) plane in cells that are either inside or outside each bin,
+  // so the first bin containing the low corner of a cell is the first bin for any point in it
+  void buildLookup()
+  {
+    for(unsigned int i =0; i < m_bins.size(); i++)
+    {
+      m_etaEdges.push_back(m_bins[i].etaMin); m_etaEdges.push_back(m_bins[i].etaMax);
+      m_ptEdges.push_back(m_bins[i].ptMin);   m_ptEdges.push_back(m_bins[i].ptMax);
+    }
+    std::sort(m_etaEdges.begin(), m_etaEdges.end());
+    m_etaEdges.erase(std::unique(m_etaEdges.begin(), m_etaEdges.end()), m_etaEdges.end());
+    std::sort(m_ptEdges.begin(), m_ptEdges.end());
+    m_ptEdges.erase(std::unique(m_ptEdges.begin(), m_ptEdges.end()), m_ptEdges.end());
+    if(m_bins.empty()) return;
+    m_cellBin.assign((m_etaEdges.size()-1)*(m_ptEdges.size()-1), -1);
+    for(unsigned int ie = 0; ie+1 < m_etaEdges.size(); ie++)
+      for(unsigned int ip = 0; ip+1 < m_ptEdges.size(); ip++)
+        for(unsigned int i =0; i < m_bins.size(); i++)
+        {
+          if(m_bins[i].contains(m_etaEdges[ie],m_ptEdges[ip])) { m_cellBin[ie*(m_ptEdges.size()-1) + ip] = i; break; }
+        }
+  }
+
+  // cell i such that edges[i] <= v < edges[i+1], -1 if none
+  static int cellOf(const std::vector<float> & edges, float v)
+  {
+    int i = std::upper_bound(edges.begin(), edges.end(), v) - edges.begin() - 1;
+    return (i >= 0 && i+1 < int(edges.size())) ? i : -1;
+  }
+
+  void init(const BTagCDF & cdf, std::vector< std::vector<std::pair<float, float> > > &  cutsAndSF, float boundX, float boundY)
+  {
+   for(unsigned int i =0; i < m_bins.size(); i++)
+   {
+     m_shapes.push_back( BTagShape(cdf, cutsAndSF[i],boundX,boundY));
+   }
+   buildLookup();
+  }
+
+  std::vector<float> m_etaEdges, m_ptEdges;
+  std::vector<int> m_cellBin;
+
 };
 
 class BTagShapeInterface
@@ -134,6 +253,18 @@ class BTagShapeInterface
  public:
   BTagShapeInterface(){}
   BTagShapeInterface(const char * file, float scaleBC, float scaleL, bool use4points=false, float boundX=1.001, float boundY=1.001,unsigned int maxbins=9999) : m_file(new TFile(file))
+  {
+    init(BTagCDF((TH1F *) m_file->Get("hb")), BTagCDF((TH1F *) m_file->Get("hc")), BTagCDF((TH1F *) m_file->Get("hl")),
+         scaleBC, scaleL, use4points, boundX, boundY, maxbins);
+  }
+  /// from the discriminator distributions hb, hc and hl of an open file, which is not owned
+  BTagShapeInterface(TFile * file, const BTagCDF & cdfB, const BTagCDF & cdfC, const BTagCDF & cdfL, float scaleBC, float scaleL, bool use4points=false, float boundX=1.001, float boundY=1.001,unsigned int maxbins=9999) : m_file(file)
+  {
+    init(cdfB, cdfC, cdfL, scaleBC, scaleL, use4points, boundX, boundY, maxbins);
+  }
+
+ private:
+  void init(const BTagCDF & cdfB, const BTagCDF & cdfC, const BTagCDF & cdfL, float scaleBC, float scaleL, bool use4points, float boundX, float boundY, unsigned int maxbins)
   {
     std::vector<EtaPtBin> binsBC;
     std::vector< std::vector<std::pair<float, float> > > cutsAndSFB;
@@ -237,8 +368,8 @@ class BTagShapeInterface
     }
    
 
-    m_b = new BinnedBTagShape(binsBC,cutsAndSFB,m_file,"hb",boundX,boundY);
-    m_c = new BinnedBTagShape(binsBC,cutsAndSFC,m_file,"hc",boundX,boundY);
+    m_b = new BinnedBTagShape(binsBC,cutsAndSFB,cdfB,boundX,boundY);
+    m_c = new BinnedBTagShape(binsBC,cutsAndSFC,cdfC,boundX,boundY);
 
     std::vector<EtaPtBin> binsL;
     std::vector< std::vector<std::pair<float, float> > > cutsAndSFL;
@@ -290,11 +421,12 @@ class BTagShapeInterface
 
    }
  
-    m_l = new BinnedBTagShape(binsL,cutsAndSFL,m_file,"hl",boundX,boundY);
+    m_l = new BinnedBTagShape(binsL,cutsAndSFL,cdfL,boundX,boundY);
 
 
   }
 
+ public:
  float reshape(float eta, float pt, float csv, int flav)
  {
    if(csv < 0) return csv;
@@ -307,6 +439,19 @@ class BTagShapeInterface
    return -10000; 
    
  }
+
+ /// reshape the n jets of an event
+ void reshape(unsigned int n, const float * eta, const float * pt, const float * csv, const int * flav, float * out)
+ {
+   for(unsigned int i = 0; i < n; i++) out[i] = reshape(eta[i], pt[i], csv[i], flav[i]);
+ }
+
+ const BinnedBTagShape * shapeFor(int flav) const
+ {
+   if(abs(flav) == 5) return m_b;
+   if(abs(flav) == 4) return m_c;
+   return m_l;
+ }
  
  TFile * m_file; 
  BinnedBTagShape * m_b;
@@ -316,4 +461,46 @@ class BTagShapeInterface
 };
 
 
+/// The reshaping for several (scaleBC, scaleL) systematic variations at once:
+/// the calibration file is opened and its distributions integrated once for
+/// all the variations, the (eta, pt) bin of each jet is looked up once, and
+/// its discriminator is reshaped with every variation in the same pass.
+class BTagShapeSystematics
+{
+ public:
+  BTagShapeSystematics(const char * file, const std::vector<std::pair<float, float> > & scales, bool use4points=false, float boundX=1.001, float boundY=1.001,unsigned int maxbins=9999) : m_file(new TFile(file))
+  {
+    BTagCDF cdfB((TH1F *) m_file->Get("hb")), cdfC((TH1F *) m_file->Get("hc")), cdfL((TH1F *) m_file->Get("hl"));
+    for(unsigned int v = 0; v < scales.size(); v++)
+      m_vars.push_back(new BTagShapeInterface(m_file, cdfB, cdfC, cdfL, scales[v].first, scales[v].second, use4points, boundX, boundY, maxbins));
+  }
+
+  unsigned int nVariations() const { return m_vars.size(); }
+
+  /// out[v] = discriminator reshaped with variation v
+  void reshape(float eta, float pt, float csv, int flav, float * out) const
+  {
+    const unsigned int nv = m_vars.size();
+    int bin = (csv < 0 || csv > 1 || flav == 0 || nv == 0) ? -1 : m_vars[0]->shapeFor(flav)->findBin(eta,pt);
+    for(unsigned int v = 0; v < nv; v++)
+      out[v] = (bin < 0 ? csv : m_vars[v]->shapeFor(flav)->m_shapes[bin].eval(csv));
+  }
+
+  /// the n jets of an event, out[v*n + i] = jet i reshaped with variation v
+  void reshape(unsigned int n, const float * eta, const float * pt, const float * csv, const int * flav, float * out) const
+  {
+    const unsigned int nv = m_vars.size();
+    std::vector<float> buff(nv);
+    for(unsigned int i = 0; i < n; i++)
+    {
+      reshape(eta[i], pt[i], csv[i], flav[i], &buff[0]);
+      for(unsigned int v = 0; v < nv; v++) out[v*n + i] = buff[v];
+    }
+  }
+
+ private:
+  TFile * m_file;
+  std::vector<BTagShapeInterface *> m_vars;
+};
+
 #endif
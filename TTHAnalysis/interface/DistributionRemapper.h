@@ -2,22 +2,48 @@
 #define CMGTools_TTHAnalysis_DistributionRemapper_h
 
 #include <vector>
-#include <Math/Interpolator.h>
 struct TH1;
 
+//
+// Maps a variable distributed as source into one distributed as target.
+//
+// The map through the (x_, y_) points is the natural cubic spline that
+// ROOT::Math::Interpolator(kCSPLINE) used to compute on the fly. It is now
+// tabulated in the constructor, on a uniform grid of nTable cells between
+// the first and the last point, and made monotone (non-decreasing) where the
+// spline overshoots. Eval interpolates linearly in the table; it differs from
+// the spline by at most MaxError() = step^2/8 * max|spline''| plus the largest
+// monotone correction. The object is immutable after construction and can be
+// shared between threads.
+//
 class DistributionRemapper {
     public:
-        DistributionRemapper() : interp_(0) {} // for persistency
-        DistributionRemapper(const TH1 *source, const TH1 *target) ;
+        DistributionRemapper() : xmin_(0), ymin_(0), xmax_(0), ymax_(0), t0_(0), invStep_(0), maxError_(0) {} // for persistency
+        DistributionRemapper(const TH1 *source, const TH1 *target, unsigned int nTable = 4096) ;
         ~DistributionRemapper() ;
         double operator()(double x) const { return Eval(x); }
-        double Eval(double x) const ;
+        double Eval(double x) const {
+            if (x < xmin_) return ymin_;
+            if (x > xmax_) return ymax_;
+            double u = (x - t0_) * invStep_;
+            if (!(u > 0)) return table_.front();
+            unsigned int i = (unsigned int)(u);
+            if (i >= table_.size()-1) return table_.back();
+            double f = u - i;
+            return table_[i] + f * (table_[i+1] - table_[i]);
+        }
+        // y[i] = Eval(x[i]) for i in [0, n)
+        void Eval(unsigned int n, const double *x, double *y) const ;
+        void Eval(unsigned int n, const float *x, float *y) const ;
+        // bound on |Eval(x) - spline(x)|
+        double MaxError() const { return maxError_; }
     private:
-        void init() const;
+        void buildTable(unsigned int nTable) ;
 
         double xmin_, ymin_, xmax_, ymax_;
         std::vector<double> x_, y_;
-        mutable ROOT::Math::Interpolator *interp_;  //! not to be serialized    
+        double t0_, invStep_, maxError_;
+        std::vector<double> table_; // spline at t0_ + i/invStep_
 };
 
 #endif
@@ -0,0 +1,244 @@
+#ifndef fakeRateMapFiller_h
+#define fakeRateMapFiller_h
+
+//
+// Fills the numerator and denominator TH2 maps of lepton fake (or flip) rates
+// in a single loop over the events, for all the maps and all the lepton slots,
+// instead of two TTree::Draw per map, per lepton slot and per sample.
+//
+// Each map is declared with addMap(name, selection, lepton class, pass, xvar,
+// yvar, binning); all of them are TTreeFormula expressions where %d stands for
+// the index of the lepton slot, as in the fillFR functions of these macros.
+// For each event and each slot in [firstSlot, lastSlot] the lepton enters
+// name_den at (xvar, yvar) if the selection and the lepton class are true, and
+// also name_num if pass is true (an empty class or pass is always true).
+// Identical expressions are evaluated once per event and slot, and only when
+// needed. A slot for which an expression has no data (e.g. LepGood_pt[%d]
+// beyond nLepGood) is skipped, as in TTree::Draw.
+//
+// run() processes the files with nThreads threads, each with its own trees,
+// formulas and histograms, summed at the end; write() writes name_den,
+// name_num and the ratio name (binomial errors) to the current directory.
+//
+// Usage:
+//   FakeRateMapFiller filler("treeName", 1, 2);
+//   filler.addMap("FR_mu", baseCut, "abs(LepGood%d_pdgId) == 13", "LepGood%d_mva >= 0.70",
+//                 "LepGood%d_pt", "abs(LepGood%d_eta)", npt, ptbins, neta, etabins);
+//   filler.addFile(fileName);
+//   filler.run();
+//   fOut->cd(); filler.write();
+//
+
+#include <TROOT.h>
+#include <RVersion.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include <TH2.h>
+#include <TString.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class FakeRateMapFiller {
+    public:
+        FakeRateMapFiller(const char *treeName, int firstSlot, int lastSlot) :
+            treeName_(treeName), firstSlot_(firstSlot), lastSlot_(lastSlot) {}
+        ~FakeRateMapFiller() {
+            for (unsigned int i = 0; i < maps_.size(); ++i) { delete maps_[i].den; delete maps_[i].num; }
+        }
+
+        void addMap(const char *name, const char *selection, const char *lepClass, const char *pass,
+                    const char *xvar, const char *yvar, int nx, const double *xbins, int ny, const double *ybins) {
+            Map m;
+            m.name = name;
+            m.den = new TH2F(m.name+"_den", "", nx, xbins, ny, ybins); m.den->SetDirectory(0); m.den->Sumw2();
+            m.num = new TH2F(m.name+"_num", "", nx, xbins, ny, ybins); m.num->SetDirectory(0); m.num->Sumw2();
+            for (int slot = firstSlot_; slot <= lastSlot_; ++slot) {
+                m.sel.push_back(expression(selection, slot));
+                m.cls.push_back(expression(lepClass, slot));
+                m.pass.push_back(expression(pass, slot));
+                m.x.push_back(expression(xvar, slot));
+                m.y.push_back(expression(yvar, slot));
+            }
+            maps_.push_back(m);
+        }
+
+        // friendTree is added as a friend from friendFile, if given
+        void addFile(const char *path, const char *friendTree = 0, const char *friendFile = 0) {
+            File f; f.path = path;
+            if (friendTree && friendFile) { f.friendTree = friendTree; f.friendFile = friendFile; }
+            files_.push_back(f);
+        }
+
+        // nThreads <= 0 means one per core; returns false if any file could not be processed
+        bool run(int nThreads = 0) {
+            if (nThreads <= 0) nThreads = std::thread::hardware_concurrency();
+            nThreads = std::max(1, std::min<int>(nThreads, files_.size()));
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+            if (nThreads > 1) ROOT::EnableThreadSafety();
+#else
+            if (nThreads > 1) {
+                std::cout << "WARNING: ROOT " << ROOT_RELEASE << " is not thread-safe, running on a single thread." << std::endl;
+                nThreads = 1;
+            }
+#endif
+            // per-thread histograms, made here so that the workers never touch the directories
+            std::vector<std::vector<TH2 *> > hists(nThreads);
+            for (int t = 0; t < nThreads; ++t) {
+                for (unsigned int i = 0; i < maps_.size(); ++i) {
+                    hists[t].push_back(clone(maps_[i].den));
+                    hists[t].push_back(clone(maps_[i].num));
+                }
+            }
+            ok_ = true;
+            if (nThreads == 1) {
+                work(0, 1, hists[0]);
+            } else {
+                std::vector<std::thread> threads;
+                for (int t = 0; t < nThreads; ++t) {
+                    threads.push_back(std::thread(&FakeRateMapFiller::work, this, t, nThreads, std::ref(hists[t])));
+                }
+                for (int t = 0; t < nThreads; ++t) threads[t].join();
+            }
+            for (int t = 0; t < nThreads; ++t) {
+                for (unsigned int i = 0; i < maps_.size(); ++i) {
+                    maps_[i].den->Add(hists[t][2*i]);   delete hists[t][2*i];
+                    maps_[i].num->Add(hists[t][2*i+1]); delete hists[t][2*i+1];
+                }
+            }
+            files_.clear();
+            return ok_;
+        }
+
+        void write() const {
+            for (unsigned int i = 0; i < maps_.size(); ++i) {
+                const Map &m = maps_[i];
+                m.den->Write();
+                m.num->Write();
+                TH2 *ratio = (TH2 *) m.num->Clone(m.name);
+                ratio->Divide(m.num, m.den, 1, 1, "B");
+                ratio->Write();
+                delete ratio;
+            }
+        }
+
+    private:
+        struct Map {
+            TString name;
+            TH2 *den, *num;
+            std::vector<int> sel, cls, pass, x, y; // expression indices by slot, -1 = true
+        };
+        struct File {
+            TString path, friendTree, friendFile;
+        };
+
+        TString treeName_;
+        int firstSlot_, lastSlot_;
+        std::vector<Map> maps_;
+        std::vector<File> files_;
+        std::vector<TString> exprs_;
+        std::map<TString, int> index_;
+        std::mutex setupMutex_;
+        std::atomic<bool> ok_;
+
+        int expression(const char *expr, int slot) {
+            TString e(expr);
+            if (e.Strip(TString::kBoth).Length() == 0) return -1;
+            e.ReplaceAll("%d", Form("%d", slot));
+            std::map<TString, int>::const_iterator it = index_.find(e);
+            if (it != index_.end()) return it->second;
+            exprs_.push_back(e);
+            return index_[e] = exprs_.size()-1;
+        }
+
+        static TH2 *clone(const TH2 *h) {
+            TH2 *ret = (TH2 *) h->Clone();
+            ret->SetDirectory(0);
+            ret->Reset();
+            return ret;
+        }
+
+        void work(int thread, int nThreads, std::vector<TH2 *> &hists) {
+            for (unsigned int i = thread; i < files_.size(); i += nThreads) {
+                if (!processFile(files_[i], hists)) ok_ = false;
+            }
+        }
+
+        bool processFile(const File &file, std::vector<TH2 *> &hists) {
+            TFile *f = 0; TTree *tree = 0;
+            std::vector<TTreeFormula *> forms(exprs_.size(), (TTreeFormula *) 0);
+            {
+                // opening the files and parsing the formulas go through the interpreter
+                std::lock_guard<std::mutex> lock(setupMutex_);
+                f = TFile::Open(file.path);
+                if (f && !f->IsZombie()) tree = (TTree *) f->Get(treeName_);
+                if (tree == 0) {
+                    std::cerr << "ERROR: cannot read tree " << treeName_ << " from " << file.path << std::endl;
+                    delete f;
+                    return false;
+                }
+                if (file.friendTree.Length()) tree->AddFriend(file.friendTree, file.friendFile);
+                bool good = true;
+                for (unsigned int i = 0; i < exprs_.size(); ++i) {
+                    forms[i] = new TTreeFormula(Form("frmap%u", i), exprs_[i], tree);
+                    if (forms[i]->GetNdim() == 0) {
+                        std::cerr << "ERROR: cannot compile '" << exprs_[i] << "' on " << file.path << std::endl;
+                        good = false;
+                    }
+                }
+                if (!good) {
+                    for (unsigned int i = 0; i < forms.size(); ++i) delete forms[i];
+                    delete f;
+                    return false;
+                }
+            }
+
+            std::vector<double> value(exprs_.size());
+            std::vector<char> done(exprs_.size());
+            Long64_t entries = tree->GetEntries();
+            for (Long64_t entry = 0; entry < entries; ++entry) {
+                if (tree->LoadTree(entry) < 0) break;
+                std::fill(done.begin(), done.end(), 0);
+                for (int islot = 0, nslots = lastSlot_ - firstSlot_ + 1; islot < nslots; ++islot) {
+                    for (unsigned int im = 0; im < maps_.size(); ++im) {
+                        const Map &m = maps_[im];
+                        if (!test(m.sel[islot], forms, value, done)) continue;
+                        if (!test(m.cls[islot], forms, value, done)) continue;
+                        double x = eval(m.x[islot], forms, value, done);
+                        double y = eval(m.y[islot], forms, value, done);
+                        if (std::isnan(x) || std::isnan(y)) continue;
+                        hists[2*im]->Fill(x, y);
+                        if (test(m.pass[islot], forms, value, done)) hists[2*im+1]->Fill(x, y);
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(setupMutex_);
+            for (unsigned int i = 0; i < forms.size(); ++i) delete forms[i];
+            f->Close();
+            delete f;
+            return true;
+        }
+
+        // value of expression i for the current entry, NaN if it has no data
+        static double eval(int i, const std::vector<TTreeFormula *> &forms, std::vector<double> &value, std::vector<char> &done) {
+            if (i < 0) return 1;
+            if (!done[i]) {
+                value[i] = (forms[i]->GetNdata() > 0 ? forms[i]->EvalInstance(0) : NAN);
+                done[i] = 1;
+            }
+            return value[i];
+        }
+        static bool test(int i, const std::vector<TTreeFormula *> &forms, std::vector<double> &value, std::vector<char> &done) {
+            double v = eval(i, forms, value, done);
+            return v != 0 && !std::isnan(v);
+        }
+};
+
+#endif
@@ -1,24 +1,5 @@
+#include "fakeRateMapFiller.h"
 TString gTreePath = "/data/b/botta/TTHAnalysis/trees/TREES_250513_HADD/%s/ttHLepTreeProducerBase/ttHLepTreeProducerBase_tree.root";
-void fillFR(TString hist, TString cut, TString pass, TString compName, int maxLep) {
-    TDirectory *root = gDirectory;
-    TFile *f = TFile::Open(Form(gTreePath.Data(),compName.Data()));
-    TTree *tree = (TTree*) f->Get("ttHLepTreeProducerBase");
-    root->cd();
-    for (int i = 3; i <= maxLep; ++i) {
-        TString mycut = cut;   mycut.ReplaceAll("%d", Form("%d",i));
-        TString mypass = pass; mypass.ReplaceAll("%d", Form("%d",i));
-        tree->Draw(Form("abs(LepGood%d_eta):min(LepGood%d_pt,99.9)>>+%s_den", i,i, hist.Data()),
-                   Form("%s", mycut.Data()));
-        tree->Draw(Form("abs(LepGood%d_eta):min(LepGood%d_pt,99.9)>>+%s_num", i,i, hist.Data()),
-                   Form("(%s) && (%s)", mycut.Data(), mypass.Data()));
-    }
-    f->Close();
-    TH2 *den = (TH2*) gROOT->FindObject(hist+"_den"); den->Sumw2(); den->Write();
-    TH2 *num = (TH2*) gROOT->FindObject(hist+"_num"); num->Sumw2(); num->Write();
-    TH2 *ratio = num->Clone(hist);
-    ratio->Divide(num,den,1,1,"B");
-    ratio->Write();
-}
 void fillBaseWeights(TString hist, TString cut, TString pass, TString compName, int maxLep) {
     TDirectory *root = gDirectory;
     TFile *f = TFile::Open(Form(gTreePath.Data(),compName.Data()));
@@ -34,7 +15,7 @@ void fillBaseWeights(TString hist, TString cut, TString pass, TString compName,
     h->Write();
 }
 
-void fillZFakeRatesFromMC(int withb=0) {
+void fillZFakeRatesFromMC(int withb=0, int nThreads=0) {
     gROOT->ProcessLine(".L ../../python/plotter/functions.cc+");
     gROOT->ProcessLine(".L ../../python/plotter/fakeRate.cc+");
 
@@ -47,22 +28,6 @@ void fillZFakeRatesFromMC(int withb=0) {
     double etabins_el[neta_el+1] = { 0.0, 0.8, 1.479, 2.5 };
 
     TFile *fOut = TFile::Open(withb ? "fakeRates_Zb_DYJets_MC.root" : "fakeRates_Z_DYJets_MC.root", "RECREATE");
-    const int  nsels = 3;
-    const char *sels[nsels] = { "FR", "FRC", "FRH" };
-    for (int is = 0; is < nsels; ++is) {
-        TH2F *FR_mu_den = new TH2F(Form("%s_mu_den",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_mu_num = new TH2F(Form("%s_mu_num",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_el_den = new TH2F(Form("%s_el_den",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-        TH2F *FR_el_num = new TH2F(Form("%s_el_num",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-        TH2F *FR_tight_mu_den = new TH2F(Form("%s_tight_mu_den",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_tight_mu_num = new TH2F(Form("%s_tight_mu_num",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_loose_mu_den = new TH2F(Form("%s_loose_mu_den",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_loose_mu_num = new TH2F(Form("%s_loose_mu_num",sels[is]),"",npt_mu,ptbins_mu,neta_mu,etabins_mu);
-        TH2F *FR_tight_el_den = new TH2F(Form("%s_tight_el_den",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-        TH2F *FR_tight_el_num = new TH2F(Form("%s_tight_el_num",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-        TH2F *FR_loose_el_den = new TH2F(Form("%s_loose_el_den",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-        TH2F *FR_loose_el_num = new TH2F(Form("%s_loose_el_num",sels[is]),"",npt_el,ptbins_el,neta_el,etabins_el);
-    }
     //TH1 *w_el = new TH1F("W_btag_el", "CSV", 20, 0, 1);
     //TH1 *w_el = new TH1F("W_btag_mu", "CSV", 20, 0, 1);
 
@@ -82,6 +47,20 @@ void fillZFakeRatesFromMC(int withb=0) {
     TString baseCutTC = baseCutT + " (LepGood%d_tightCharge > (abs(LepGood%d_pdgId) == 11)) && ";
     TString baseCutTCB = baseCutTC+ " (LepGood%d_sip3d < 4) && (abs(LepGood%d_pdgId) == 11 || LepGood%d_tightId) && (abs(LepGood%d_pdgId) == 13 || passEgammaTightMVA(LepGood%d_pt,LepGood%d_eta,LepGood%d_tightId)) && ";
 
+    // only the third lepton is probed, all the maps filled in one loop on the events
+    FakeRateMapFiller filler("ttHLepTreeProducerBase", 3, 3);
+    TString fake = "LepGood%d_mcMatchId == 0";
+    const char *el = "abs(LepGood%d_pdgId) == 11", *mu = "abs(LepGood%d_pdgId) == 13";
+    const char *xvar = "min(LepGood%d_pt,99.9)", *yvar = "abs(LepGood%d_eta)";
+    filler.addMap("FR_el",        baseCutTC  + fake, el, "LepGood%d_mva >= -0.3",   xvar, yvar, npt_el, ptbins_el, neta_el, etabins_el);
+    filler.addMap("FR_mu",        baseCutTC  + fake, mu, "LepGood%d_mva >= -0.3",   xvar, yvar, npt_mu, ptbins_mu, neta_mu, etabins_mu);
+    filler.addMap("FR_tight_el",  baseCutTC  + fake, el, "LepGood%d_mva >= 0.70",   xvar, yvar, npt_el, ptbins_el, neta_el, etabins_el);
+    filler.addMap("FR_tight_mu",  baseCutTC  + fake, mu, "LepGood%d_mva >= 0.70",   xvar, yvar, npt_mu, ptbins_mu, neta_mu, etabins_mu);
+    filler.addMap("FR_loose_el",  baseCut    + fake, el, "LepGood%d_mva >= -0.3",   xvar, yvar, npt_el, ptbins_el, neta_el, etabins_el);
+    filler.addMap("FR_loose_mu",  baseCut    + fake, mu, "LepGood%d_mva >= -0.3",   xvar, yvar, npt_mu, ptbins_mu, neta_mu, etabins_mu);
+    filler.addMap("FRC_tight_el", baseCutTCB + fake, el, "LepGood%d_relIso < 0.12", xvar, yvar, npt_el, ptbins_el, neta_el, etabins_el);
+    filler.addMap("FRC_tight_mu", baseCutTCB + fake, mu, "LepGood%d_relIso < 0.12", xvar, yvar, npt_mu, ptbins_mu, neta_mu, etabins_mu);
+
     TString sample = "";
     const char *samples[4] = { "DYJetsM50", "DY1JetsM50", "DY2JetsM50", "DY3JetsM50" };
     for (int id = 0; id < 4; ++id) { 
@@ -90,15 +69,7 @@ void fillZFakeRatesFromMC(int withb=0) {
         //fillBaseWeights("W_btag_mu", baseCut + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 13", "LepGood%d_pt > 10 && LepGood%d_mva < 0.25", sample, 4);
 
         std::cout << "Processing MVA selection on " << sample << std::endl;
-        fillFR("FR_el", baseCutTC + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11", "LepGood%d_mva >= -0.3", sample, 3);
-        fillFR("FR_mu", baseCutTC + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 13", "LepGood%d_mva >= -0.3", sample, 3);
-        fillFR("FR_tight_el", baseCutTC + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11", "LepGood%d_mva >= 0.70", sample, 3);
-        fillFR("FR_tight_mu", baseCutTC + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 13", "LepGood%d_mva >= 0.70", sample, 3);
-        fillFR("FR_loose_el", baseCut   + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11", "LepGood%d_mva >= -0.3", sample, 3);
-        fillFR("FR_loose_mu", baseCut   + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 13", "LepGood%d_mva >= -0.3", sample, 3);
-        //fillFR("FR_tight2_el",baseCutTC+ "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11", "LepGood%d_mva >= 0.70", sample, 3);
-        fillFR("FRC_tight_el", baseCutTCB + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11", "LepGood%d_relIso < 0.12", sample, 3);
-        fillFR("FRC_tight_mu", baseCutTCB + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 13", "LepGood%d_relIso < 0.12", sample, 3);
+        filler.addFile(Form(gTreePath.Data(),sample.Data()));
 #if 0
         std::cout << "Processing cut-based selection on " << sample << std::endl;
         fillFR("FRC_el", baseCut + "LepGood%d_mcMatchId == 0 && abs(LepGood%d_pdgId) == 11 && (abs(LepGood%d_eta)<1.4442 || abs(LepGood%d_eta)>1.5660)", "LepGood%d_relIso < 0.25 && LepGood%d_tightId > 0.0 && abs(LepGood%d_dxy) < 0.04 && abs(LepGood%d_innerHits) <= 0", sample, triggering ? 2 : 4);
@@ -120,5 +91,10 @@ void fillZFakeRatesFromMC(int withb=0) {
 #endif
     }
 
+    filler.run(nThreads);
+
+    fOut->cd();
+    filler.write();
+
     fOut->Close();
 }
@@ -17,11 +17,13 @@ class MVAVar:
         self.var  = array('f',[0.])
         self.func = func
         self.corrfunc = corrfunc
-    def set(self,lep,ncorr): ## apply correction ncorr times
+    def set(self,lep,ncorr,index): ## apply correction ncorr times, index = lepton slot (0-based)
         self.var[0] = self.func(lep)
         if self.corrfunc:
+            ev = lep._event
             for i in range(ncorr):
-                self.var[0] = self.corrfunc(self.var[0], lep.pdgId,lep.pt,lep.eta,lep.mcMatchId,lep.mcMatchAny)
+                ## each pass smears with its own random numbers: object index 8*pass + lepton slot
+                self.var[0] = self.corrfunc(self.var[0], lep.pdgId,lep.pt,lep.eta,lep.mcMatchId,lep.mcMatchAny, ev.run,ev.lumi,ev.evt,8*i+index)
 class MVATool:
     def __init__(self,name,xml,specs,vars):
         self.name = name
@@ -32,16 +34,16 @@ class MVATool:
         for v in vars:  self.reader.AddVariable(v.name,v.var)
         #print "Would like to load %s from %s! " % (name,xml)
         self.reader.BookMVA(name,xml)
-    def __call__(self,lep,ncorr): ## apply correction ncorr times
-        for s in self.specs: s.set(lep,ncorr)
-        for s in self.vars:  s.set(lep,ncorr)
+    def __call__(self,lep,ncorr,index): ## apply correction ncorr times
+        for s in self.specs: s.set(lep,ncorr,index)
+        for s in self.vars:  s.set(lep,ncorr,index)
         return self.reader.EvaluateMVA(self.name)   
 class CategorizedMVA:
     def __init__(self,catMvaPairs):
         self.catMvaPairs = catMvaPairs
-    def __call__(self,lep,ncorr):
+    def __call__(self,lep,ncorr,index):
         for c,m in self.catMvaPairs:
-            if c(lep): return m(lep,ncorr)
+            if c(lep): return m(lep,ncorr,index)
         return -99.
 
 _CommonSpect = [ 
@@ -76,9 +78,9 @@ class LeptonMVA:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_CommonVars+_ElectronVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_CommonVars+_ElectronVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 class LepMVATreeProducer(Module):
@@ -98,12 +100,12 @@ class LepMVATreeProducer(Module):
         lep = Collection(event,"LepGood","nLepGood",8)
         for i,l in enumerate(lep):
             if self.data:
-                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0))
+                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0,index=i))
             else: 
-                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0))
+                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0,index=i))
                 #if not self.fast:
-                #    setattr(self.t, "LepGood%d_mvaNewUncorr"     % (i+1), self.mva(l,ncorr=0))
-                #    setattr(self.t, "LepGood%d_mvaNewDoubleCorr" % (i+1), self.mva(l,ncorr=2))
+                #    setattr(self.t, "LepGood%d_mvaNewUncorr"     % (i+1), self.mva(l,ncorr=0,index=i))
+                #    setattr(self.t, "LepGood%d_mvaNewDoubleCorr" % (i+1), self.mva(l,ncorr=2,index=i))
         for i in xrange(len(lep),8):
             setattr(self.t, "LepGood%d_mvaNew" % (i+1), -99.)
             #if not self.data and not self.fast:
@@ -17,11 +17,13 @@ class MVAVar:
         self.var  = array('f',[0.])
         self.func = func
         self.corrfunc = corrfunc
-    def set(self,lep,ncorr): ## apply correction ncorr times
+    def set(self,lep,ncorr,index): ## apply correction ncorr times, index = lepton slot (0-based)
         self.var[0] = self.func(lep)
         if self.corrfunc:
+            ev = lep._event
             for i in range(ncorr):
-                self.var[0] = self.corrfunc(self.var[0], lep.pdgId,lep.pt,lep.eta,lep.mcMatchId,lep.mcMatchAny)
+                ## each pass smears with its own random numbers: object index 8*pass + lepton slot
+                self.var[0] = self.corrfunc(self.var[0], lep.pdgId,lep.pt,lep.eta,lep.mcMatchId,lep.mcMatchAny, ev.run,ev.lumi,ev.evt,8*i+index)
 class MVATool:
     def __init__(self,name,xml,specs,vars):
         self.name = name
@@ -32,16 +34,16 @@ class MVATool:
         for v in vars:  self.reader.AddVariable(v.name,v.var)
         #print "Would like to load %s from %s! " % (name,xml)
         self.reader.BookMVA(name,xml)
-    def __call__(self,lep,ncorr): ## apply correction ncorr times
-        for s in self.specs: s.set(lep,ncorr)
-        for s in self.vars:  s.set(lep,ncorr)
+    def __call__(self,lep,ncorr,index): ## apply correction ncorr times
+        for s in self.specs: s.set(lep,ncorr,index)
+        for s in self.vars:  s.set(lep,ncorr,index)
         return self.reader.EvaluateMVA(self.name)   
 class CategorizedMVA:
     def __init__(self,catMvaPairs):
         self.catMvaPairs = catMvaPairs
-    def __call__(self,lep,ncorr):
+    def __call__(self,lep,ncorr,index):
         for c,m in self.catMvaPairs:
-            if c(lep): return m(lep,ncorr)
+            if c(lep): return m(lep,ncorr,index)
         return -99.
 
 _CommonSpect = [ 
@@ -124,9 +126,9 @@ class LeptonMVA:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 #=========
@@ -149,9 +151,9 @@ class LeptonMVANoIso:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -172,9 +174,9 @@ class LeptonMVANoIp:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -196,9 +198,9 @@ class LeptonMVANoJet:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -219,9 +221,9 @@ class LeptonMVANoMvaId:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -242,9 +244,9 @@ class LeptonMVANoBtag:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_SIPVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -265,9 +267,9 @@ class LeptonMVANoInnerHits:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_IpVars+_MvaIdVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -289,9 +291,9 @@ class LeptonMVANoSIP:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_IpVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -313,9 +315,9 @@ class LeptonMVANodxydz:
             ( lambda x: x.pt >  10 and abs(x.eta) >= 0.8 and abs(x.eta) <  1.479 , MVATool("BDTG",basepath%"el_pteta_high_fb",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_MvaIdVars+_InnerHitsVars) ),
             ( lambda x: x.pt >  10 and abs(x.eta) >= 1.479                       , MVATool("BDTG",basepath%"el_pteta_high_ec",_CommonSpect,_IsoVars+_JetVars+_BTagVars+_SIPVars+_MvaIdVars+_InnerHitsVars) ),
         ])
-    def __call__(self,lep,ncorr=0):
-        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr)
-        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr)
+    def __call__(self,lep,ncorr=0,index=0):
+        if   abs(lep.pdgId) == 11: return self.el(lep,ncorr,index)
+        elif abs(lep.pdgId) == 13: return self.mu(lep,ncorr,index)
         else: return -99
 
 
@@ -359,30 +361,30 @@ class LepMVATreeProducer(Module):
         lep = Collection(event,"LepGood","nLepGood",8)
         for i,l in enumerate(lep):
             if self.data:
-                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0))
+                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=0,index=i))
                 if self.others:
-                    setattr(self.t, "LepGood%d_mvaNoSIP" % (i+1), self.mvaNoSIP(l,ncorr=0))
-                    setattr(self.t, "LepGood%d_mvaNodxydz" % (i+1), self.mvaNodxydz(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoIso" % (i+1), self.mvaNoIso(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoIp" % (i+1), self.mvaNoIp(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoJet" % (i+1), self.mvaNoJet(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoMvaId" % (i+1), self.mvaNoMvaId(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoBtag" % (i+1), self.mvaNoBtag(l,ncorr=0))
-                    #setattr(self.t, "LepGood%d_mvaNoInnerHits" % (i+1), self.mvaNoInnerHits(l,ncorr=0))
+                    setattr(self.t, "LepGood%d_mvaNoSIP" % (i+1), self.mvaNoSIP(l,ncorr=0,index=i))
+                    setattr(self.t, "LepGood%d_mvaNodxydz" % (i+1), self.mvaNodxydz(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoIso" % (i+1), self.mvaNoIso(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoIp" % (i+1), self.mvaNoIp(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoJet" % (i+1), self.mvaNoJet(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoMvaId" % (i+1), self.mvaNoMvaId(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoBtag" % (i+1), self.mvaNoBtag(l,ncorr=0,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoInnerHits" % (i+1), self.mvaNoInnerHits(l,ncorr=0,index=i))
             else: 
-                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=1))
+                setattr(self.t, "LepGood%d_mvaNew" % (i+1), self.mva(l,ncorr=1,index=i))
                 if self.others:
-                    setattr(self.t, "LepGood%d_mvaNoSIP" % (i+1), self.mvaNoSIP(l,ncorr=1))
-                    setattr(self.t, "LepGood%d_mvaNodxydz" % (i+1), self.mvaNodxydz(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoIso" % (i+1), self.mvaNoIso(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoIp" % (i+1), self.mvaNoIp(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoJet" % (i+1), self.mvaNoJet(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoMvaId" % (i+1), self.mvaNoMvaId(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoBtag" % (i+1), self.mvaNoBtag(l,ncorr=1))
-                    #setattr(self.t, "LepGood%d_mvaNoInnerHits" % (i+1), self.mvaNoInnerHits(l,ncorr=1))
+                    setattr(self.t, "LepGood%d_mvaNoSIP" % (i+1), self.mvaNoSIP(l,ncorr=1,index=i))
+                    setattr(self.t, "LepGood%d_mvaNodxydz" % (i+1), self.mvaNodxydz(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoIso" % (i+1), self.mvaNoIso(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoIp" % (i+1), self.mvaNoIp(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoJet" % (i+1), self.mvaNoJet(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoMvaId" % (i+1), self.mvaNoMvaId(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoBtag" % (i+1), self.mvaNoBtag(l,ncorr=1,index=i))
+                    #setattr(self.t, "LepGood%d_mvaNoInnerHits" % (i+1), self.mvaNoInnerHits(l,ncorr=1,index=i))
                 if not self.fast:
-                    setattr(self.t, "LepGood%d_mvaNewUncorr"     % (i+1), self.mva(l,ncorr=0))
-                    setattr(self.t, "LepGood%d_mvaNewDoubleCorr" % (i+1), self.mva(l,ncorr=2))
+                    setattr(self.t, "LepGood%d_mvaNewUncorr"     % (i+1), self.mva(l,ncorr=0,index=i))
+                    setattr(self.t, "LepGood%d_mvaNewDoubleCorr" % (i+1), self.mva(l,ncorr=2,index=i))
         for i in xrange(len(lep),8):
             setattr(self.t, "LepGood%d_mvaNew" % (i+1), -99.)
             if self.others:
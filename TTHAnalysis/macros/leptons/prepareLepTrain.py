@@ -34,13 +34,13 @@ class LepTreeProducer(Module):
         self.first = True
     def analyze(self,event):
         lep = Collection(event,"LepGood","nLepGood",8)
-        for l in lep:
-            self.t.sip3d = ROOT.scaleSip3dMC(l.sip3d, l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny) if self.corr else l.sip3d
-            self.t.dz    = ROOT.scaleDzMC(   l.dz,    l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny) if self.corr else l.dz
-            self.t.dxy   = ROOT.scaleDxyMC(  l.dxy,   l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny) if self.corr else l.dxy
+        for i,l in enumerate(lep):
+            self.t.sip3d = ROOT.scaleSip3dMC(l.sip3d, l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny,event.run,event.lumi,event.evt,i) if self.corr else l.sip3d
+            self.t.dz    = ROOT.scaleDzMC(   l.dz,    l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny,event.run,event.lumi,event.evt,i) if self.corr else l.dz
+            self.t.dxy   = ROOT.scaleDxyMC(  l.dxy,   l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny,event.run,event.lumi,event.evt,i) if self.corr else l.dxy
             (dr,ptf) = (l.jetDR,l.jetPtRatio)
             self.t.jetDR  = ROOT.correctJetDRMC(dr,l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny)       if self.corr else dr
-            self.t.jetPtRatio = ROOT.correctJetPtRatioMC(ptf,l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny) if self.corr else ptf
+            self.t.jetPtRatio = ROOT.correctJetPtRatioMC(ptf,l.pdgId,l.pt,l.eta,l.mcMatchId,l.mcMatchAny,event.run,event.lumi,event.evt,i) if self.corr else ptf
             self.t.jetBTagCSV = l.jetBTagCSV
             self.t.mvaId = l.mvaId if abs(l.pdgId) == 11 else l.muonMVAIdFull
             for C in self.copyvars: setattr(self.t, C, getattr(l,C))
@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+'''Checks the closed-form kinematics of functions.cc (kinematics.h) against
+the ROOT::Math::LorentzVector sums they replaced, and compares their timing,
+one event at a time and with the batch versions.
+
+Usage: benchmarkKinematics.py [-n nEvents] [-r maxRelDiff]
+
+The masses must be identical bit for bit to the LorentzVector ones (the
+largest difference in float ulps is printed); mtop_lvb, whose W constraint
+amplifies the rounding of the old PtEtaPhiM round trips, must agree within
+maxRelDiff. Exits with status 1 if they do not.
+'''
+import os, sys, time, tempfile
+import numpy as np
+from optparse import OptionParser
+
+import ROOT
+ROOT.gROOT.SetBatch(True)
+
+parser = OptionParser(usage=__doc__)
+parser.add_option('-n', '--nevents', dest='nevents', type='int', default=1000000)
+parser.add_option('-r', '--max-rel-diff', dest='maxRel', type='float', default=1e-5)
+(options, args) = parser.parse_args()
+
+plotter = os.path.dirname(os.path.abspath(__file__))
+if "/functions_cc.so" not in ROOT.gSystem.GetLibraries():
+    ROOT.gROOT.ProcessLine(".L %s/functions.cc+O" % plotter)
+
+# the implementations before kinematics.h, and the scalar closed-form ones, looped over the events in C++
+# as the batch versions
+LEGACY = '''
+#include "Math/GenVector/LorentzVector.h"
+#include "Math/GenVector/PtEtaPhiM4D.h"
+#include "Math/GenVector/PxPyPzM4D.h"
+#include <cmath>
+typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
+typedef ROOT::Math::LorentzVector<ROOT::Math::PxPyPzM4D<double> > PxPyPzMVector;
+void legacy_mass_batch(unsigned int nobj, unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    for (unsigned int iev = 0; iev < n; ++iev) {
+        PtEtaPhiMVector sum(pt[iev],eta[iev],phi[iev],m[iev]);
+        for (unsigned int i = 1; i < nobj; ++i) sum = sum + PtEtaPhiMVector(pt[i*n+iev],eta[i*n+iev],phi[i*n+iev],m[i*n+iev]);
+        out[iev] = sum.M();
+    }
+}
+void legacy_mtop_lvb_batch(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    for (unsigned int iev = 0; iev < n; ++iev) {
+        float ptl = pt[iev], phil = phi[iev], met = pt[n+iev], metphi = phi[n+iev];
+        PtEtaPhiMVector p4l(ptl,eta[iev],phil,m[iev]);
+        PtEtaPhiMVector p4b(pt[2*n+iev],eta[2*n+iev],phi[2*n+iev],m[2*n+iev]);
+        double MW=80.4;
+        double a = (1 - std::pow(p4l.Z()/p4l.E(), 2));
+        double ppe    = met * ptl * std::cos(phil - metphi)/p4l.E();
+        double brk    = MW*MW / (2*p4l.E()) + ppe;
+        double b      = (p4l.Z()/p4l.E()) * brk;
+        double c      = met*met - brk*brk;
+        double delta   = b*b - a*c;
+        double sqdelta = delta > 0 ? std::sqrt(delta) : 0;
+        double pz1 = (b + sqdelta)/a, pz2 = (b - sqdelta)/a;
+        double pznu = (std::abs(pz1) <= std::abs(pz2) ? pz1 : pz2);
+        PxPyPzMVector p4v(met*std::cos(metphi),met*std::sin(metphi),pznu,0);
+        out[iev] = (p4l+p4b+p4v).M();
+    }
+}
+void scalar_mass_batch(unsigned int nobj, unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    for (unsigned int iev = 0; iev < n; ++iev) {
+        switch (nobj) {
+            case 2: out[iev] = kinematics::mass_2(pt[iev],eta[iev],phi[iev],m[iev], pt[n+iev],eta[n+iev],phi[n+iev],m[n+iev]); break;
+            case 3: out[iev] = kinematics::mass_3(pt[iev],eta[iev],phi[iev],m[iev], pt[n+iev],eta[n+iev],phi[n+iev],m[n+iev], pt[2*n+iev],eta[2*n+iev],phi[2*n+iev],m[2*n+iev]); break;
+            case 4: out[iev] = kinematics::mass_4(pt[iev],eta[iev],phi[iev],m[iev], pt[n+iev],eta[n+iev],phi[n+iev],m[n+iev], pt[2*n+iev],eta[2*n+iev],phi[2*n+iev],m[2*n+iev], pt[3*n+iev],eta[3*n+iev],phi[3*n+iev],m[3*n+iev]); break;
+        }
+    }
+}
+'''
+tmpdir = tempfile.mkdtemp()
+legacy = os.path.join(tmpdir, "kinematicsLegacy.cc")
+with open(legacy, "w") as f:
+    f.write('#include "%s/kinematics.h"\n' % plotter)
+    f.write(LEGACY)
+ROOT.gROOT.ProcessLine(".L %s+O" % legacy)
+
+n = options.nevents
+rng = np.random.RandomState(12345)
+def objects(nobj):
+    pt  = (5. + rng.exponential(40., nobj*n)).astype(np.float32)
+    eta = rng.uniform(-2.5, 2.5, nobj*n).astype(np.float32)
+    phi = rng.uniform(-np.pi, np.pi, nobj*n).astype(np.float32)
+    m   = rng.choice(np.array([0.000511, 0.105658, 4.8, 10.], dtype=np.float32), nobj*n)
+    return pt, eta, phi, m
+
+def ulps(a, b):
+    ia = a.view(np.int32).astype(np.int64)
+    ib = b.view(np.int32).astype(np.int64)
+    return np.abs(ia - ib)
+
+def timed(fun, *args):
+    t0 = time.time()
+    fun(*args)
+    return time.time() - t0
+
+ok = True
+print '{:<10} {:>12} {:>12} {:>12} {:>10} {:>10}'.format('', 'legacy [s]', 'scalar [s]', 'batch [s]', 'max ulps', 'identical')
+for nobj, batch in (2, ROOT.mass_2_batch), (3, ROOT.mass_3_batch), (4, ROOT.mass_4_batch):
+    pt, eta, phi, m = objects(nobj)
+    ref, scal, out = np.zeros(n, np.float32), np.zeros(n, np.float32), np.zeros(n, np.float32)
+    t_ref = timed(ROOT.legacy_mass_batch, nobj, n, pt, eta, phi, m, ref)
+    t_scal = timed(ROOT.scalar_mass_batch, nobj, n, pt, eta, phi, m, scal)
+    t_out = timed(batch, n, pt, eta, phi, m, out)
+    u = max(ulps(ref, scal).max(), ulps(ref, out).max())
+    same = np.count_nonzero(ref == out)
+    if u != 0: ok = False
+    print '{:<10} {:12.3f} {:12.3f} {:12.3f} {:10d} {:10.6f}'.format('mass_%d' % nobj, t_ref, t_scal, t_out, u, same/float(n))
+
+pt, eta, phi, m = objects(3)
+ref, out = np.zeros(n, np.float32), np.zeros(n, np.float32)
+t_ref = timed(ROOT.legacy_mtop_lvb_batch, n, pt, eta, phi, m, ref)
+t_out = timed(ROOT.mtop_lvb_batch, n, pt, eta, phi, m, out)
+rel = np.max(np.abs(ref.astype(np.float64) - out)/np.abs(ref))
+if rel > options.maxRel: ok = False
+print '{:<10} {:12.3f} {:>12} {:12.3f}   max rel. diff {:.1e}'.format('mtop_lvb', t_ref, '', t_out, rel)
+
+if not ok:
+    print 'ERROR: the closed-form kinematics do not agree with the LorentzVector ones'
+    sys.exit(1)
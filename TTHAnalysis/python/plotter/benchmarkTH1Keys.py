@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+'''Checks the native (binned, FFT) backend of TH1KeysNew against the RooNDKeysPdf
+one, and compares their timing, for a few shapes and sample sizes.
+
+Usage: benchmarkTH1Keys.py [-n nEvents[,nEvents...]] [-b nBins] [-t tolerance]
+
+For each case the two histograms must agree within tolerance times the
+content of their highest bin. Exits with status 1 if they do not.
+'''
+import os, sys, time
+import numpy as np
+from optparse import OptionParser
+
+import ROOT
+ROOT.gROOT.SetBatch(True)
+
+parser = OptionParser(usage=__doc__)
+parser.add_option('-n', '--nevents', dest='nevents', default='1000,10000,100000')
+parser.add_option('-b', '--bins', dest='bins', type='int', default=40)
+parser.add_option('-t', '--tolerance', dest='tolerance', type='float', default=0.01)
+(options, args) = parser.parse_args()
+
+plotter = os.path.dirname(os.path.abspath(__file__))
+if "/TH1Keys_cc.so" not in ROOT.gSystem.GetLibraries():
+    ROOT.gROOT.ProcessLine(".L %s/TH1Keys.cc+O" % plotter)
+
+rng = np.random.RandomState(12345)
+def gaus(n):
+    return rng.normal(5., 1., n), np.ones(n)
+def expo(n):
+    return rng.exponential(2., n), np.ones(n)
+def bimodal(n):
+    x = np.where(rng.uniform(size=n) < 0.3, rng.normal(2., 0.3, n), rng.normal(5., 1., n))
+    return x, np.ones(n)
+def weighted(n):
+    x = rng.exponential(2., n)
+    return x, rng.uniform(0.5, 1.5, n) - 1.2*(rng.uniform(size=n) < 0.05)
+
+cases = [ # name, sample, options, rho
+    ('gaus',            gaus,     "",   1.0),
+    ('gaus adaptive',   gaus,     "a",  1.0),
+    ('expo mirrored',   expo,     "am", 1.0),
+    ('bimodal',         bimodal,  "a",  1.5),
+    ('weighted',        weighted, "a",  1.0),
+]
+
+def filled(x, w, opts, rho, backend):
+    h = ROOT.TH1KeysNew("keys", "keys", options.bins, 0., 10., opts, rho)
+    h.SetBackend(backend)
+    h.FillN(len(x), x, w)
+    t0 = time.time()
+    out = np.array([h.GetHisto().GetBinContent(b) for b in xrange(1, options.bins+1)])
+    return out, time.time() - t0
+
+ok = True
+print '{:<16} {:>8} {:>12} {:>12} {:>10} {:>12}'.format('', 'events', 'roofit [s]', 'native [s]', 'speed-up', 'diff/peak')
+for n in [int(x) for x in options.nevents.split(',')]:
+    for name, sample, opts, rho in cases:
+        x, w = sample(n)
+        x, w = np.ascontiguousarray(x, dtype=np.float64), np.ascontiguousarray(w, dtype=np.float64)
+        ref, t_ref = filled(x, w, opts, rho, ROOT.TH1KeysNew.RooFitBackend)
+        out, t_out = filled(x, w, opts, rho, ROOT.TH1KeysNew.NativeBackend)
+        diff = np.max(np.abs(out - ref))/np.max(np.abs(ref))
+        if diff > options.tolerance: ok = False
+        print '{:<16} {:8d} {:12.3f} {:12.4f} {:10.1f} {:12.1e}'.format(name, n, t_ref, t_out, t_ref/max(t_out, 1e-6), diff)
+
+if not ok:
+    print 'ERROR: the native TH1KeysNew backend does not agree with RooNDKeysPdf'
+    sys.exit(1)
@@ -7,6 +7,9 @@
 #include <string>
 #include <map>
 #include <math.h>
+#include <functional>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "TFile.h"
 #include "TTree.h"
@@ -40,7 +43,7 @@
 #include <RooCBShape.h>
 #include <RooExponential.h>
 
-#include <Math/Functor.h>
+#include <Math/IFunction.h>
 #include <Fit/Fitter.h>
 
 
@@ -166,7 +169,7 @@ vector<float> doSingleFit(TH1* histo, bool isData) {
   frame->Draw();
 
   FILE *test=fopen( "plots", "r" );
-  if( test==0 ) system( "mkdir plots");
+  if( test==0 ) system( "mkdir -p plots"); //the parallel workers can race here
   else fclose( test );
 
   string name="plots/fitData_";
@@ -194,17 +197,67 @@ void appendDataBase(string name, vector<float> vs, bool appendDb, string dbname)
 }
 
 
-map<string, vector<float> > doFits(string file, bool isData, bool appendDb,
-				   string dbName, string singleCateg) {
+// runs fit(i) for i in [0, n), in nJobs forked worker processes if nJobs > 1: RooFit keeps
+// global state and is not thread safe, so each worker is a process with its own minimizers,
+// that handles the categories i = worker, worker+nJobs, ... and sends back their results
+vector<vector<float> > runFits(size_t n, int nJobs, const std::function<vector<float>(size_t)>& fit) {
 
-  bool appDb=appendDb;
+  vector<vector<float> > results(n);
+  if(nJobs<=1 || n<=1) {
+    for(size_t i=0;i<n;i++) results[i]=fit(i);
+    return results;
+  }
+
+  struct Record { unsigned int index; float v[4]; }; //written at once, atomic on a pipe
+  int fds[2];
+  if(pipe(fds)!=0) { perror("pipe"); exit(1); }
+
+  vector<pid_t> workers;
+  for(int w=0;w<nJobs && size_t(w)<n;w++) {
+    pid_t pid=fork();
+    if(pid<0) { perror("fork"); exit(1); }
+    if(pid==0) {
+      close(fds[0]);
+      for(size_t i=w;i<n;i+=nJobs) {
+	vector<float> v=fit(i);
+	Record r; r.index=i;
+	for(size_t k=0;k<4;k++) r.v[k]=(k<v.size()?v[k]:0);
+	if(write(fds[1], &r, sizeof(r))!=sizeof(r)) { perror("write"); _exit(1); }
+      }
+      cout.flush();
+      _exit(0);
+    }
+    workers.push_back(pid);
+  }
+
+  close(fds[1]);
+  Record r;
+  while(read(fds[0], &r, sizeof(r))==sizeof(r)) {
+    results[r.index]=vector<float>(r.v, r.v+4);
+  }
+  close(fds[0]);
+  for(size_t w=0;w<workers.size();w++) waitpid(workers[w], 0, 0);
+
+  for(size_t i=0;i<n;i++) {
+    if(results[i].empty()) {
+      cout<<" The fit of category "<<i<<" was lost (its worker died), please rerun with fewer jobs "<<endl;
+      exit(1);
+    }
+  }
+  return results;
+}
+
+
+map<string, vector<float> > doFits(string file, bool isData, bool appendDb,
+				   string dbName, string singleCateg, int nJobs) {
 
   TFile* f=new TFile(file.c_str(), "read");
 
-  //scan the file content
+  //scan the file content, the fits are done afterwards all together
 
   string name;
-  vector<float> vs;
+  vector<string> names;
+  vector<TH1*> histos;
   map<string, vector<float> > vals;
 
   TIter nextkey(f->GetListOfKeys());
@@ -222,11 +275,8 @@ map<string, vector<float> > doFits(string file, bool isData, bool appendDb,
 
       if(singleCateg!="" && name.find(singleCateg)==string::npos) continue;
 
-      vs = doSingleFit((TH1*)obj, isData);
-      vals[ name ] = vs;
-
-      if(appendDb) appendDataBase(name, vs, appDb, dbName);
-      if(appDb==false) appDb=true; //otherwise we overwrite the file
+      names.push_back(name);
+      histos.push_back((TH1*)obj);
 
     }
 
@@ -246,17 +296,26 @@ map<string, vector<float> > doFits(string file, bool isData, bool appendDb,
 
 	if(singleCateg!="" && name.find(singleCateg)==string::npos) continue;
 
-	vs = doSingleFit((TH1*)objD, isData);
-	vals[ name ] = vs;
-
-	if(appendDb) appendDataBase(name, vs, appDb, dbName);
-	if(appDb==false) appDb=true; //otherwise we overwrite the file
+	names.push_back(name);
+	histos.push_back((TH1*)objD);
       }
 
     }
 
   }
 
+  vector<vector<float> > results=runFits(histos.size(), nJobs,
+					 [&](size_t i) { return doSingleFit(histos[i], isData); });
+
+  //gather the results in a single table, in the order of the file
+  bool appDb=appendDb;
+  for(size_t i=0;i<names.size();i++) {
+    vals[ names[i] ] = results[i];
+
+    if(appendDb) appendDataBase(names[i], results[i], appDb, dbName);
+    if(appDb==false) appDb=true; //otherwise we overwrite the file
+  }
+
   return vals;
 
 }
@@ -311,45 +370,72 @@ float getErr(float m1, float m2, float e1, float e2) {
 }
 
 
-// function Object to be minimized
-struct Chi2 {
+// function Object to be minimized: chi2 of the flip probabilities measured in the
+// categories, modelled as the sum of the probabilities of the two electrons,
+// with the points kept in flat arrays and the analytic gradient
+class Chi2 : public ROOT::Math::IGradientFunctionMultiDim {
 
-  vector<std::pair<vector<float>, vector<int> > > _vals;
+public:
+  Chi2(): _nDim(0) {}
 
-  void setPoint(float val, float eval, float p1, float p2) {
+  void setPoint(float val, float eval, int p1, int p2) {
 
-    vector<float> vals(2,0);
-    vector<int> bins(2,0);
+    if(eval==0) eval=val;
+    _val.push_back(val);
+    _w.push_back(1./pow(eval,2));
+    _p1.push_back(p1);
+    _p2.push_back(p2);
 
-    vals[0]=val;
-    vals[1]=eval;
-    bins[0]=p1;
-    bins[1]=p2;
+  }
 
-    std::pair<vector<float>, vector<int> > p(vals,bins);
-    _vals.push_back(p);
+  void setNDim(unsigned int n) { _nDim=n; }
+  unsigned int NDim() const { return _nDim; }
+  ROOT::Math::IMultiGenFunction* Clone() const { return new Chi2(*this); }
+
+  // chi2 and its gradient in a single pass over the points
+  void FdF(const double * param, double& f, double * df) const {
+    f=0;
+    for(unsigned int i=0;i<_nDim;i++) df[i]=0;
+    for(size_t ip=0,np=_val.size();ip<np;ip++) {
+      double r=_val[ip]-(param[_p1[ip]]+param[_p2[ip]]);
+      f += r*r*_w[ip];
+      double d=-2*r*_w[ip];
+      df[_p1[ip]] += d;
+      df[_p2[ip]] += d;
+    }
+  }
 
+  void Gradient(const double * param, double * df) const {
+    double f;
+    FdF(param, f, df);
   }
 
+private:
   // implementation of the function to be minimized
-  double operator() (const double * param) {
+  double DoEval(const double * param) const {
     double chi2=0;
-
-    float val,eval;
-    int p1,p2;
-    for(unsigned int ip=0;ip<_vals.size();ip++) {
-      val=_vals[ip].first[0];
-      eval=_vals[ip].first[1];
-      p1=_vals[ip].second[0];
-      p2=_vals[ip].second[1];
-
-      if(eval==0) eval=val;
-      chi2 += pow( val-(param[p1]+param[p2]), 2)/pow(eval,2);
+    for(size_t ip=0,np=_val.size();ip<np;ip++) {
+      double r=_val[ip]-(param[_p1[ip]]+param[_p2[ip]]);
+      chi2 += r*r*_w[ip];
     }
     //cout<<" chi2: "<<chi2<<endl;
     return chi2;
   }
 
+  double DoDerivative(const double * param, unsigned int icoord) const {
+    double d=0;
+    for(size_t ip=0,np=_val.size();ip<np;ip++) {
+      if(_p1[ip]!=int(icoord) && _p2[ip]!=int(icoord)) continue;
+      double r=_val[ip]-(param[_p1[ip]]+param[_p2[ip]]);
+      d += -2*r*_w[ip]*((_p1[ip]==int(icoord))+(_p2[ip]==int(icoord)));
+    }
+    return d;
+  }
+
+  unsigned int _nDim;
+  vector<double> _val; //measured probability
+  vector<double> _w;   //1/error^2
+  vector<int> _p1, _p2; //indices of the probabilities of the two electrons
 };
 
 void fillPoints(vector<float>& binsPt, vector<float>& binsEta,
@@ -536,10 +622,11 @@ int main(int argc, char* argv[]) {
   string singleCateg="";
   bool appendDb=true;
   string dbName="database.db";
+  int nJobs=1;
 
   char c;
 
-  while ((c = getopt(argc, argv, "f:d:s:D:a:n:h")) != -1 ) {
+  while ((c = getopt(argc, argv, "f:d:s:D:a:n:j:h")) != -1 ) {
     switch (c) {
       //case 'd': { file=optarg; break;}
     case 'f': { file=string(optarg); break;}
@@ -548,11 +635,12 @@ int main(int argc, char* argv[]) {
     case 'D': { isData=bool(atoi(optarg)); break;}
     case 'a': { appendDb=bool(atoi(optarg)); break;}
     case 'n': { dbName=string(optarg); break;}
+    case 'j': { nJobs=atoi(optarg); break;}
     case 'h': {
-      cout<<"configuration options:\n -f : file to read (root or ASCII) \n -d proceed with a database reading instead of making fits (0 per default). \n -s <categ> perform a fit over a single Z category. \n -D run on data (0 per default). \n -a do not store the numbers into a b (1 per default). \n -n set the database file name for reading (database.db per default). \n -h help \n"<<endl;
+      cout<<"configuration options:\n -f : file to read (root or ASCII) \n -d proceed with a database reading instead of making fits (0 per default). \n -s <categ> perform a fit over a single Z category. \n -D run on data (0 per default). \n -a do not store the numbers into a b (1 per default). \n -n set the database file name for reading (database.db per default). \n -j <N> run the category fits in N parallel processes (1 per default). \n -h help \n"<<endl;
       return 0; }
     default : {
-      cout<<"configuration options:\n -f : file to read (root or ASCII) \n -d proceed with a database reading instead of making fits (0 per default). \n -s <categ> perform a fit over a single Z category. \n -D run on data (0 per default). \n -a do not store the numbers into a b (1 per default). \n -n set the database file name for reading (database.db per default). \n -h help \n"<<endl;
+      cout<<"configuration options:\n -f : file to read (root or ASCII) \n -d proceed with a database reading instead of making fits (0 per default). \n -s <categ> perform a fit over a single Z category. \n -D run on data (0 per default). \n -a do not store the numbers into a b (1 per default). \n -n set the database file name for reading (database.db per default). \n -j <N> run the category fits in N parallel processes (1 per default). \n -h help \n"<<endl;
       return 0; }
     }
   }
@@ -567,7 +655,7 @@ int main(int argc, char* argv[]) {
   }
   else { //read root file
     map<string, vector<float> > vals=doFits(file, isData, appendDb,
-					    dbName, singleCateg);
+					    dbName, singleCateg, nJobs);
     bins= setPoints(vals,chi2);
   }
 
@@ -576,11 +664,12 @@ int main(int argc, char* argv[]) {
   int nvars=bins.getNProb();
 
   ROOT::Fit::Fitter  fitter;
-  ROOT::Math::Functor fcn(chi2,nvars);
+  chi2.setNDim(nvars);
 
   //bloody ROOT and lack of vector handling
   double* vars= new double[nvars];
-  fitter.SetFCN(fcn,vars);
+  for (int i=0; i<nvars; ++i) vars[i]=0;
+  fitter.SetFCN(chi2,vars);
 
   // set step sizes and limits
   for (int i=0; i<nvars; ++i) {
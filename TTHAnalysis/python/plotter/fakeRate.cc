@@ -1,119 +1,221 @@
 #include <TH2.h>
 #include <TFile.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <map>
-
-TH2 * FR_mu = 0;
-TH2 * FR2_mu = 0;
-TH2 * FR3_mu = 0;
-TH2 * FR4_mu = 0;
-TH2 * FR5_mu = 0;
-TH2 * FR_el = 0;
-TH2 * FR2_el = 0;
-TH2 * FR3_el = 0;
-TH2 * FR4_el = 0;
-TH2 * FR5_el = 0;
-TH2 * QF_el = 0;
-TH2 * FRi_mu[6], *FRi_el[6];
-
-TH2 * FR_mu_FO1_QCD    = 0;
-TH2 * FR_mu_FO1_insitu = 0;
-TH2 * FR_mu_FO2_QCD    = 0;
-TH2 * FR_mu_FO2_insitu = 0;
-TH2 * FR_mu_FO3_QCD    = 0;
-TH2 * FR_mu_FO3_insitu = 0;
-TH2 * FR_mu_FO4_QCD    = 0;
-TH2 * FR_mu_FO4_insitu = 0;
-TH2 * FR_el_FO1_QCD    = 0;
-TH2 * FR_el_FO1_insitu = 0;
-TH2 * FR_el_FO2_QCD    = 0;
-TH2 * FR_el_FO2_insitu = 0;
-TH2 * FR_el_FO3_QCD    = 0;
-TH2 * FR_el_FO3_insitu = 0;
-TH2 * FR_el_FO4_QCD    = 0;
-TH2 * FR_el_FO4_insitu = 0;
-TH2 * FRi_FO_mu[8];
-TH2 * FRi_FO_el[8];
-
-TH2 * FR_mu_QCD_iso = 0;
-TH2 * FR_mu_QCD_noniso = 0;
-TH2 * FR_el_QCD_iso = 0;
-TH2 * FR_el_QCD_noniso = 0;
-TH2 * FRi_fHT_FO_mu[2];
-TH2 * FRi_fHT_FO_el[2];
-
-bool loadFRHisto(const std::string &histoName, const char *file, const char *name) {
-    TH2 **histo = 0, **hptr2 = 0;
-    if      (histoName == "FR_mu")  { histo = & FR_mu;  hptr2 = & FRi_mu[0]; }
-    else if (histoName == "FR_el")  { histo = & FR_el;  hptr2 = & FRi_el[0]; }
-    else if (histoName == "FR2_mu") { histo = & FR2_mu; hptr2 = & FRi_mu[2]; }
-    else if (histoName == "FR2_el") { histo = & FR2_el; hptr2 = & FRi_el[2]; }
-    else if (histoName == "FR3_mu") { histo = & FR3_mu; hptr2 = & FRi_mu[3]; }
-    else if (histoName == "FR3_el") { histo = & FR3_el; hptr2 = & FRi_el[3]; }
-    else if (histoName == "FR4_mu") { histo = & FR4_mu; hptr2 = & FRi_mu[4]; }
-    else if (histoName == "FR4_el") { histo = & FR4_el; hptr2 = & FRi_el[4]; }
-    else if (histoName == "FR5_mu") { histo = & FR5_mu; hptr2 = & FRi_mu[5]; }
-    else if (histoName == "FR5_el") { histo = & FR5_el; hptr2 = & FRi_el[5]; }
-    else if (histoName == "QF_el") histo = & QF_el;
-    else if (histoName == "FR_mu_FO1_QCD")  { histo = &FR_mu_FO1_QCD ;  hptr2 = & FRi_FO_mu[0]; }
-    else if (histoName == "FR_mu_FO1_insitu")  { histo = &FR_mu_FO1_insitu ;  hptr2 = & FRi_FO_mu[1]; }
-    else if (histoName == "FR_mu_FO2_QCD")  { histo = &FR_mu_FO2_QCD ;  hptr2 = & FRi_FO_mu[2]; }
-    else if (histoName == "FR_mu_FO2_insitu")  { histo = &FR_mu_FO2_insitu ;  hptr2 = & FRi_FO_mu[3]; }
-    else if (histoName == "FR_mu_FO3_QCD")  { histo = &FR_mu_FO3_QCD ;  hptr2 = & FRi_FO_mu[4]; }
-    else if (histoName == "FR_mu_FO3_insitu")  { histo = &FR_mu_FO3_insitu ;  hptr2 = & FRi_FO_mu[5]; }
-    else if (histoName == "FR_mu_FO4_QCD")  { histo = &FR_mu_FO4_QCD ;  hptr2 = & FRi_FO_mu[6]; }
-    else if (histoName == "FR_mu_FO4_insitu")  { histo = &FR_mu_FO4_insitu ;  hptr2 = & FRi_FO_mu[7]; }
-    else if (histoName == "FR_el_FO1_QCD")  { histo = &FR_el_FO1_QCD ;  hptr2 = & FRi_FO_el[0]; }
-    else if (histoName == "FR_el_FO1_insitu")  { histo = &FR_el_FO1_insitu ;  hptr2 = & FRi_FO_el[1]; }
-    else if (histoName == "FR_el_FO2_QCD")  { histo = &FR_el_FO2_QCD ;  hptr2 = & FRi_FO_el[2]; }
-    else if (histoName == "FR_el_FO2_insitu")  { histo = &FR_el_FO2_insitu ;  hptr2 = & FRi_FO_el[3]; }
-    else if (histoName == "FR_el_FO3_QCD")  { histo = &FR_el_FO3_QCD ;  hptr2 = & FRi_FO_el[4]; }
-    else if (histoName == "FR_el_FO3_insitu")  { histo = &FR_el_FO3_insitu ;  hptr2 = & FRi_FO_el[5]; }
-    else if (histoName == "FR_el_FO4_QCD")  { histo = &FR_el_FO4_QCD ;  hptr2 = & FRi_FO_el[6]; }
-    else if (histoName == "FR_el_FO4_insitu")  { histo = &FR_el_FO4_insitu ;  hptr2 = & FRi_FO_el[7]; }
-    else if (histoName == "FR_mu_QCD_iso")  { histo = &FR_mu_QCD_iso ;  hptr2 = & FRi_fHT_FO_mu[0]; }
-    else if (histoName == "FR_mu_QCD_noniso")  { histo = &FR_mu_QCD_noniso ;  hptr2 = & FRi_fHT_FO_mu[1]; }
-    else if (histoName == "FR_el_QCD_iso")  { histo = &FR_el_QCD_iso ;  hptr2 = & FRi_fHT_FO_el[0]; }
-    else if (histoName == "FR_el_QCD_noniso")  { histo = &FR_el_QCD_noniso ;  hptr2 = & FRi_fHT_FO_el[1]; }
-    if (histo == 0)  {
-        std::cerr << "ERROR: histogram " << histoName << " is not defined in fakeRate.cc." << std::endl;
-        return 0;
+#include <vector>
+
+// Fake-rate maps are kept in a registry of immutable flat tables: loadFRHisto
+// copies the bin edges and contents of the histogram once, and the weights
+// below look them up by integer handle, with the same clamping to the first
+// and last bins as TH2::FindBin before (direct computation on uniform axes,
+// binary search otherwise). Loading is serialized and a table is never
+// modified or deleted once published, so the weights can be evaluated from
+// several threads.
+
+class FRTable {
+    public:
+        FRTable(const std::string &name, const TH2 &hist) : name_(name), x_(*hist.GetXaxis()), y_(*hist.GetYaxis()) {
+            values_.resize(x_.n * y_.n);
+            for (int iy = 1; iy <= y_.n; ++iy) {
+                for (int ix = 1; ix <= x_.n; ++ix) values_[(iy-1)*x_.n + (ix-1)] = hist.GetBinContent(ix,iy);
+            }
+        }
+        // name of the histogram in its file
+        const std::string & name() const { return name_; }
+        double value(double x, double y) const { return values_[y_.bin(y)*x_.n + x_.bin(x)]; }
+        bool sameAs(const FRTable &other) const { return x_.edges == other.x_.edges && y_.edges == other.y_.edges && values_ == other.values_; }
+    private:
+        struct Axis {
+            Axis(const TAxis &axis) : n(axis.GetNbins()), uniform(axis.GetXbins()->GetSize() == 0), min(axis.GetXmin()), max(axis.GetXmax()) {
+                for (int i = 1; i <= n+1; ++i) edges.push_back(axis.GetBinLowEdge(i));
+            }
+            // 0-based bin, as std::max(1, std::min(n, axis.FindBin(x))) - 1
+            int bin(double x) const {
+                int b;
+                if (x < min) b = 0;
+                else if (!(x < max)) b = n+1;
+                else if (uniform) b = 1 + int(n*(x-min)/(max-min));
+                else b = std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+                return std::max(1, std::min(n, b)) - 1;
+            }
+            int n; bool uniform; double min, max;
+            std::vector<double> edges;
+        };
+        std::string name_;
+        Axis x_, y_;
+        std::vector<double> values_;
+};
+
+// the maps known to the weights below, with their handles
+enum FRMap { FR_mu, FR2_mu, FR3_mu, FR4_mu, FR5_mu, FR_el, FR2_el, FR3_el, FR4_el, FR5_el, QF_el,
+             FR_mu_FO1_QCD, FR_mu_FO1_insitu, FR_mu_FO2_QCD, FR_mu_FO2_insitu, FR_mu_FO3_QCD, FR_mu_FO3_insitu, FR_mu_FO4_QCD, FR_mu_FO4_insitu,
+             FR_el_FO1_QCD, FR_el_FO1_insitu, FR_el_FO2_QCD, FR_el_FO2_insitu, FR_el_FO3_QCD, FR_el_FO3_insitu, FR_el_FO4_QCD, FR_el_FO4_insitu,
+             FR_mu_QCD_iso, FR_mu_QCD_noniso, FR_el_QCD_iso, FR_el_QCD_noniso, FR_nPredefined };
+const char *FR_names[FR_nPredefined] = { "FR_mu", "FR2_mu", "FR3_mu", "FR4_mu", "FR5_mu", "FR_el", "FR2_el", "FR3_el", "FR4_el", "FR5_el", "QF_el",
+             "FR_mu_FO1_QCD", "FR_mu_FO1_insitu", "FR_mu_FO2_QCD", "FR_mu_FO2_insitu", "FR_mu_FO3_QCD", "FR_mu_FO3_insitu", "FR_mu_FO4_QCD", "FR_mu_FO4_insitu",
+             "FR_el_FO1_QCD", "FR_el_FO1_insitu", "FR_el_FO2_QCD", "FR_el_FO2_insitu", "FR_el_FO3_QCD", "FR_el_FO3_insitu", "FR_el_FO4_QCD", "FR_el_FO4_insitu",
+             "FR_mu_QCD_iso", "FR_mu_QCD_noniso", "FR_el_QCD_iso", "FR_el_QCD_noniso" };
+const int FRi_mu[6] = { FR_mu, -1, FR2_mu, FR3_mu, FR4_mu, FR5_mu };
+const int FRi_el[6] = { FR_el, -1, FR2_el, FR3_el, FR4_el, FR5_el };
+const int FRi_FO_mu[8] = { FR_mu_FO1_QCD, FR_mu_FO1_insitu, FR_mu_FO2_QCD, FR_mu_FO2_insitu, FR_mu_FO3_QCD, FR_mu_FO3_insitu, FR_mu_FO4_QCD, FR_mu_FO4_insitu };
+const int FRi_FO_el[8] = { FR_el_FO1_QCD, FR_el_FO1_insitu, FR_el_FO2_QCD, FR_el_FO2_insitu, FR_el_FO3_QCD, FR_el_FO3_insitu, FR_el_FO4_QCD, FR_el_FO4_insitu };
+const int FRi_fHT_FO_mu[2] = { FR_mu_QCD_iso, FR_mu_QCD_noniso };
+const int FRi_fHT_FO_el[2] = { FR_el_QCD_iso, FR_el_QCD_noniso };
+
+class FRRegistry {
+    public:
+        static FRRegistry & instance() { static FRRegistry registry; return registry; }
+        // handle of the map, registered (not loaded) if it is new; -1 if the registry is full
+        int handle(const std::string &mapName) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return handleLocked(mapName);
+        }
+        // handle of the map, -1 if it is unknown
+        int find(const std::string &mapName) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::map<std::string,int>::const_iterator it = handles_.find(mapName);
+            return it == handles_.end() ? -1 : it->second;
+        }
+        // the table of a handle, 0 if it is not loaded
+        const FRTable * table(int handle) const {
+            return (handle >= 0 && handle < kMaxMaps) ? tables_[handle].load(std::memory_order_acquire) : 0;
+        }
+        bool load(const std::string &mapName, const char *file, const char *name) ;
+    private:
+        enum { kMaxMaps = 256 };
+        FRRegistry() {
+            for (int i = 0; i < kMaxMaps; ++i) tables_[i].store(0);
+            for (int i = 0; i < FR_nPredefined; ++i) handleLocked(FR_names[i]);
+        }
+        int handleLocked(const std::string &mapName) {
+            std::map<std::string,int>::const_iterator it = handles_.find(mapName);
+            if (it != handles_.end()) return it->second;
+            if (int(handles_.size()) == kMaxMaps) return -1;
+            int ret = handles_.size();
+            handles_[mapName] = ret;
+            return ret;
+        }
+        mutable std::mutex mutex_;
+        std::map<std::string,int> handles_;
+        std::atomic<const FRTable *> tables_[kMaxMaps];
+        // all the tables ever loaded, replaced ones included, as other threads may still be reading them
+        std::vector<std::unique_ptr<const FRTable> > owned_;
+};
+
+bool FRRegistry::load(const std::string &mapName, const char *file, const char *name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int handle = handleLocked(mapName);
+    if (handle < 0) {
+        std::cerr << "ERROR: too many fake rate maps, cannot load " << mapName << std::endl;
+        return false;
     }
-
     TFile *f = TFile::Open(file);
-    if (*histo != 0) {
-      if (std::string(name) != (*histo)->GetName()) {
-          std::cerr << "WARNING: overwriting histogram " << (*histo)->GetName() << std::endl;
-      } else {
-          TH2* hnew = (TH2*) f->Get(name);
-          if (hnew == 0 || hnew->GetNbinsX() != (*histo)->GetNbinsX() || hnew->GetNbinsY() != (*histo)->GetNbinsY()) {
-              std::cerr << "WARNING: overwriting histogram " << (*histo)->GetName() << std::endl;
-          } else {
-              bool fail = false;
-              for (int ix = 1; ix <= (*histo)->GetNbinsX(); ++ix) {
-                  for (int iy = 1; iy <= (*histo)->GetNbinsX(); ++iy) {
-                      if ((*histo)->GetBinContent(ix,iy) != hnew->GetBinContent(ix,iy)) {
-                          fail = true; break;
-                      }
-                  }
-              }
-              if (fail) std::cerr << "WARNING: overwriting histogram " << (*histo)->GetName() << std::endl;
-          }
-      }
-      delete *histo;
+    if (f == 0) {
+        std::cerr << "ERROR: could not open " << file << std::endl;
+        return false;
+    }
+    TH2 *hist = dynamic_cast<TH2*>(f->Get(name));
+    const FRTable *newTable = hist ? new FRTable(name, *hist) : 0;
+    f->Close();
+    const FRTable *oldTable = tables_[handle].load();
+    if (oldTable != 0 && (newTable == 0 || !oldTable->sameAs(*newTable) || oldTable->name() != name)) {
+        std::cerr << "WARNING: overwriting histogram " << oldTable->name() << std::endl;
     }
-    if (f->Get(name) == 0) {
+    if (newTable == 0) {
         std::cerr << "ERROR: could not find " << name << " in " << file << std::endl;
-        *histo = 0;
     } else {
-        *histo = (TH2*) f->Get(name)->Clone(name);
-        (*histo)->SetDirectory(0);
-        if (hptr2) *hptr2 = *histo;
+        owned_.push_back(std::unique_ptr<const FRTable>(newTable));
+    }
+    tables_[handle].store(newTable, std::memory_order_release);
+    return true;
+}
+
+bool loadFRHisto(const std::string &histoName, const char *file, const char *name) {
+    return FRRegistry::instance().load(histoName, file, name);
+}
+
+// handle of a loaded map, for fetchFR; -1 if there is no map with that name
+int fakeRateHandle(const std::string &histoName) {
+    return FRRegistry::instance().find(histoName);
+}
+
+// the table of a map, 0 if it is not loaded
+const FRTable * fakeRateTable(int handle) {
+    return FRRegistry::instance().table(handle);
+}
+
+// the table of a map, which must be loaded
+const FRTable * fakeRateMap(int handle) {
+    const FRTable *ret = FRRegistry::instance().table(handle);
+    if (ret == 0) { std::cerr << "ERROR, fake rate map " << handle << " (" << (handle >= 0 && handle < FR_nPredefined ? FR_names[handle] : "") << ") is not loaded" << std::endl; std::abort(); }
+    return ret;
+}
+
+// value of a map at (pt, |eta|)
+float fetchFR(int handle, float pt, float eta) {
+    return fakeRateMap(handle)->value(pt, std::abs(eta));
+}
+
+// Application-region weight of N leptons, for nVar variations of the fake rates at once:
+// -1 times the product of -f/(1-f) over the failing leptons, i.e. +f/(1-f) for one failing
+// lepton, -f1*f2/((1-f1)*(1-f2)) for two and so on; 0 if no lepton or more than maxFail
+// leptons fail. The fake rate of a failing lepton i is looked up once, in map handle[i] at
+// (pt[i], |eta[i]|); variation v uses it multiplied by scale[v*N+i], or as it is if scale is 0.
+// Returns weight[0].
+template<unsigned int N>
+float fakeRateWeightN(const float *pt, const float *eta, const int *handle, const int *pass,
+                      unsigned int nVar, const float *scale, float *weight, unsigned int maxFail = N)
+{
+    double fr[N]; unsigned int fail[N], nfail = 0;
+    for (unsigned int i = 0; i < N; ++i) {
+        if (pass[i]) continue;
+        if (nfail == maxFail) { nfail++; break; }
+        fail[nfail] = i;
+        fr[nfail++] = fakeRateMap(handle[i])->value(pt[i], std::abs(eta[i]));
+    }
+    for (unsigned int v = 0; v < nVar; ++v) {
+        float ret = 0.0f;
+        if (nfail > 0 && nfail <= maxFail) {
+            ret = -1.0f;
+            for (unsigned int j = 0; j < nfail; ++j) {
+                double f = scale ? fr[j]*scale[v*N+fail[j]] : fr[j];
+                ret *= -f/(1.0f-f);
+            }
+        }
+        weight[v] = ret;
+    }
+    return weight[0];
+}
+
+// The same for nEvents events: N values of pt, eta, handle and pass, nVar*N scales (if any)
+// and nVar weights per event, one event after the other
+template<unsigned int N>
+void fakeRateWeightsN(unsigned int nEvents, const float *pt, const float *eta, const int *handle, const int *pass,
+                      unsigned int nVar, const float *scale, float *weight, unsigned int maxFail = N)
+{
+    for (unsigned int iev = 0; iev < nEvents; ++iev) {
+        fakeRateWeightN<N>(pt + iev*N, eta + iev*N, handle + iev*N, pass + iev*N,
+                           nVar, scale ? scale + iev*nVar*N : 0, weight + iev*nVar, maxFail);
     }
-    f->Close();
-    return histo != 0;
+}
+
+// scale factor of the fake rate in the pt and eta regions of the *Syst weights
+float fakeRateSystScale(int pdgId, float pt, float eta, float ptSplit,
+                        float mu_barrel_lowpt, float mu_barrel_highpt, float mu_endcap_lowpt, float mu_endcap_highpt,
+                        float el_cb_lowpt, float el_cb_highpt, float el_fb_lowpt, float el_fb_highpt, float el_endcap_lowpt, float el_endcap_highpt)
+{
+    if (abs(pdgId) == 11) return ( std::abs(eta) < 0.8 ? (pt < ptSplit ? el_cb_lowpt : el_cb_highpt) :
+                                  (std::abs(eta) < 1.5 ? (pt < ptSplit ? el_fb_lowpt : el_fb_highpt) :
+                                                         (pt < ptSplit ? el_endcap_lowpt : el_endcap_highpt) ));
+    else /*==13*/          return (std::abs(eta) < 1.5 ?  (pt < ptSplit ? mu_barrel_lowpt : mu_barrel_highpt) :
+                                                         (pt < ptSplit ? mu_endcap_lowpt : mu_endcap_highpt) );
 }
 
 float fakeRateWeight_2lssMVA(float l1pt, float l1eta, int l1pdgId, float l1mva,
@@ -125,21 +227,15 @@ float fakeRateWeight_2lssMVA(float l1pt, float l1eta, int l1pdgId, float l1mva,
             double fpt,feta; int fid;
             if (l1mva < l2mva) { fpt = l1pt; feta = std::abs(l1eta); fid = abs(l1pdgId); }
             else               { fpt = l2pt; feta = std::abs(l2eta); fid = abs(l2pdgId); }
-            TH2 *hist = (fid == 11 ? FR_el : FR_mu);
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(fpt)));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(feta)));
-            double fr = hist->GetBinContent(ptbin,etabin);
+            const FRTable *hist = fakeRateMap(fid == 11 ? FR_el : FR_mu);
+            double fr = hist->value(fpt, feta);
             return fr/(1-fr);
         }
         case 2: {
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FR_el : FR_mu);
-            int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-            int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-            double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-            TH2 *hist2 = (abs(l2pdgId) == 11 ? FR_el : FR_mu);
-            int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-            int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-            double fr2 = hist2->GetBinContent(ptbin2,etabin2);
+            const FRTable *hist1 = fakeRateMap(abs(l1pdgId) == 11 ? FR_el : FR_mu);
+            double fr1 = hist1->value(l1pt, std::abs(l1eta));
+            const FRTable *hist2 = fakeRateMap(abs(l2pdgId) == 11 ? FR_el : FR_mu);
+            double fr2 = hist2->value(l2pt, std::abs(l2eta));
             return -fr1*fr2/((1-fr1)*(1-fr2));
         }
         default: return 0;
@@ -157,27 +253,21 @@ float fakeRateWeight_2lssCB_i(float l1pt, float l1eta, int l1pdgId, float l1relI
             double fpt,feta; int fid;
             if (l1relIso > l2relIso) { fpt = l1pt; feta = std::abs(l1eta); fid = abs(l1pdgId); }
             else                     { fpt = l2pt; feta = std::abs(l2eta); fid = abs(l2pdgId); }
-            TH2 *hist = (fid == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
+            const FRTable *hist = fakeRateTable(fid == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
             if (hist == 0) { std::cerr << "ERROR, missing FR for pdgId " << fid << ", iFR " << iFR << std::endl; std::abort(); }
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(fpt)));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(feta)));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            if (fr <= 0)  { std::cerr << "WARNING, FR is " << fr << " for " << hist->GetName() << ", pt " << fpt << " eta " << feta << std::endl; if (fr<0) std::abort(); }
+            double fr = hist->value(fpt, feta);
+            if (fr <= 0)  { std::cerr << "WARNING, FR is " << fr << " for " << hist->name() << ", pt " << fpt << " eta " << feta << std::endl; if (fr<0) std::abort(); }
             return fr/(1-fr);
         }
         case 2: {
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
+            const FRTable *hist1 = fakeRateTable(abs(l1pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
             if (hist1 == 0) { std::cerr << "ERROR, missing FR for pdgId " << l1pdgId << ", iFR " << iFR << std::endl; std::abort(); }
-            int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-            int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-            double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-            if (fr1 <= 0)  { std::cerr << "WARNING, FR is " << fr1 << " for " << hist1->GetName() << ", pt " << l1pt << " eta " << l1eta << std::endl; if (fr1<0) std::abort(); }
-            TH2 *hist2 = (abs(l2pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
+            double fr1 = hist1->value(l1pt, std::abs(l1eta));
+            if (fr1 <= 0)  { std::cerr << "WARNING, FR is " << fr1 << " for " << hist1->name() << ", pt " << l1pt << " eta " << l1eta << std::endl; if (fr1<0) std::abort(); }
+            const FRTable *hist2 = fakeRateTable(abs(l2pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
             if (hist2 == 0) { std::cerr << "ERROR, missing FR for pdgId " << l2pdgId << ", iFR " << iFR << std::endl; std::abort(); }
-            int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-            int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-            double fr2 = hist2->GetBinContent(ptbin2,etabin2);
-            if (fr2 <= 0)  { std::cerr << "WARNING, FR is " << fr2 << " for " << hist2->GetName() << ", pt " << l2pt << " eta " << l2eta << std::endl; if (fr2<0) std::abort(); }
+            double fr2 = hist2->value(l2pt, std::abs(l2eta));
+            if (fr2 <= 0)  { std::cerr << "WARNING, FR is " << fr2 << " for " << hist2->name() << ", pt " << l2pt << " eta " << l2eta << std::endl; if (fr2<0) std::abort(); }
             return -fr1*fr2/((1-fr1)*(1-fr2));
         }
         default: return 0;
@@ -210,60 +300,30 @@ float fakeRateWeight_2lssSyst(float l1pt, float l1eta, int l1pdgId, float l1mva,
                          float mu_barrel_lowpt, float mu_barrel_highpt, float mu_endcap_lowpt, float mu_endcap_highpt,
                          float el_cb_lowpt, float el_cb_highpt, float el_fb_lowpt, float el_fb_highpt, float el_endcap_lowpt, float el_endcap_highpt)
 {
-    /// 2 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva};
     float pts[]={l1pt, l2pt};
-    float etas[]={fabs(l1eta), fabs(l2eta)};
-    int pdgids[]={l1pdgId, l2pdgId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 2 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el : FR_mu);
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            if (abs(pdgids[i]) == 11) fr *= ( std::abs(etas[i]) < 0.8 ? (pts[i] < 30 ? el_cb_lowpt : el_cb_highpt) :
-                                             (std::abs(etas[i]) < 1.5 ? (pts[i] < 30 ? el_fb_lowpt : el_fb_highpt) :
-                                                                        (pts[i] < 30 ? el_endcap_lowpt : el_endcap_highpt) ));
-            else /*==13*/             fr *= (std::abs(etas[i]) < 1.5 ?  (pts[i] < 30 ? mu_barrel_lowpt : mu_barrel_highpt) :
-                                                                        (pts[i] < 30 ? mu_endcap_lowpt : mu_endcap_highpt) );
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
-
+    float etas[]={l1eta, l2eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : FR_mu, abs(l2pdgId) == 11 ? FR_el : FR_mu};
+    int pass[]={!(l1mva < WP), !(l2mva < WP)};
+    float scales[]={fakeRateSystScale(l1pdgId, l1pt, l1eta, 30, mu_barrel_lowpt, mu_barrel_highpt, mu_endcap_lowpt, mu_endcap_highpt,
+                                      el_cb_lowpt, el_cb_highpt, el_fb_lowpt, el_fb_highpt, el_endcap_lowpt, el_endcap_highpt),
+                    fakeRateSystScale(l2pdgId, l2pt, l2eta, 30, mu_barrel_lowpt, mu_barrel_highpt, mu_endcap_lowpt, mu_endcap_highpt,
+                                      el_cb_lowpt, el_cb_highpt, el_fb_lowpt, el_fb_highpt, el_endcap_lowpt, el_endcap_highpt)};
+    float ret;
+    return fakeRateWeightN<2>(pts, etas, handles, pass, 1, scales, &ret);
 }
 float fakeRateWeight_2lssBCat(float l1pt, float l1eta, int l1pdgId, float l1mva,
                          float l2pt, float l2eta, int l2pdgId, float l2mva, float WP, 
                          int nBJetMedium25, float scaleMuBL, float scaleMuBT, float scaleElBL, float scaleElBT)
 {
-    /// 2 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva};
     float pts[]={l1pt, l2pt};
-    float etas[]={fabs(l1eta), fabs(l2eta)};
-    int pdgids[]={l1pdgId, l2pdgId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 2 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
-                                                (nBJetMedium25 > 1 ? FR2_mu : FR_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            fr *= (nBJetMedium25 > 1 ? (abs(pdgids[i]) == 11 ? scaleElBT : scaleMuBT) : 
-                                       (abs(pdgids[i]) == 11 ? scaleElBL : scaleMuBL) );
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta};
+    int handles[]={abs(l1pdgId) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el) : (nBJetMedium25 > 1 ? FR2_mu : FR_mu),
+                   abs(l2pdgId) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el) : (nBJetMedium25 > 1 ? FR2_mu : FR_mu)};
+    int pass[]={!(l1mva < WP), !(l2mva < WP)};
+    float scales[]={nBJetMedium25 > 1 ? (abs(l1pdgId) == 11 ? scaleElBT : scaleMuBT) : (abs(l1pdgId) == 11 ? scaleElBL : scaleMuBL),
+                    nBJetMedium25 > 1 ? (abs(l2pdgId) == 11 ? scaleElBT : scaleMuBT) : (abs(l2pdgId) == 11 ? scaleElBL : scaleMuBL)};
+    float ret;
+    return fakeRateWeightN<2>(pts, etas, handles, pass, 1, scales, &ret);
 }
 
 float fakeRateWeight_2lssBCatSB(float l1pt, float l1eta, int l1pdgId, float l1mva,
@@ -279,11 +339,9 @@ float fakeRateWeight_2lssBCatSB(float l1pt, float l1eta, int l1pdgId, float l1mv
         if (mvas[i] > WP) {
             continue;
         } else if (SBlow < mvas[i] && mvas[i] < SBhigh) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
+	    const FRTable *hist = fakeRateMap(abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
                                                 (nBJetMedium25 > 1 ? FR2_mu : FR_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
+            double fr = hist->value(pts[i], etas[i]);
             ret *= -fr/max(1.0f-fr,0.5);
         } else {
             ret = 0.0f; break;
@@ -308,11 +366,9 @@ float fakeRateWeight_2lssBCatX(float l1pt, float l1eta, int l1pdgId, float l1mva
         } else if (mvas[i] > WPlow) {
             continue;
         } else  {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
+	    const FRTable *hist = fakeRateMap(abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
                                                 (nBJetMedium25 > 1 ? FR2_mu : FR_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
+            double fr = hist->value(pts[i], etas[i]);
             ret *= -fr/std::max(1.0f-fr,0.5);
         }
     }
@@ -326,27 +382,13 @@ float fakeRateWeight_2lssBCatX(float l1pt, float l1eta, int l1pdgId, float l1mva
 float fakeRateWeight_2lssMuIDCat(float l1pt, float l1eta, int l1pdgId, float l1mva, float l1tightId,
                          float l2pt, float l2eta, int l2pdgId, float l2mva, float l2tightId, float WP)
 {
-    /// 2 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva};
     float pts[]={l1pt, l2pt};
-    float etas[]={fabs(l1eta), fabs(l2eta)};
-    float tightIds[]={l1tightId, l2tightId};
-    int pdgids[]={l1pdgId, l2pdgId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 2 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el: (tightIds[i] > 0 ? FR_mu : FR2_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : (l1tightId > 0 ? FR_mu : FR2_mu),
+                   abs(l2pdgId) == 11 ? FR_el : (l2tightId > 0 ? FR_mu : FR2_mu)};
+    int pass[]={!(l1mva < WP), !(l2mva < WP)};
+    float ret;
+    return fakeRateWeightN<2>(pts, etas, handles, pass, 1, 0, &ret);
 }
 
 float fakeRateWeight_2lssCB_ptRel2D(float l1pt, float l1eta, int l1pdgId, float l1relIso, float l1ptRel,
@@ -365,18 +407,14 @@ float fakeRateWeight_2lssCB_ptRel2D(float l1pt, float l1eta, int l1pdgId, float
         }
         if (relIsos[i] < WPIsoL && ptRels[i] <= WPPtRelL) {
             // iso sideband
-	    TH2 *hist = abs(pdgids[i]) == 11 ? FR2_el : FR2_mu;
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
+	    const FRTable *hist = fakeRateMap(abs(pdgids[i]) == 11 ? FR2_el : FR2_mu);
+            double fr = hist->value(pts[i], etas[i]);
             ret += fr/(1.0f-fr);
         }
         if (ptRels[i] > WPPtRelL) {
             // ptrel sideband
-	    TH2 *hist = abs(pdgids[i]) == 11 ? FR3_el : FR3_mu;
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
+	    const FRTable *hist = fakeRateMap(abs(pdgids[i]) == 11 ? FR3_el : FR3_mu);
+            double fr = hist->value(pts[i], etas[i]);
             ret += fr/(1.0f-fr);
         }
     }
@@ -390,23 +428,14 @@ float fakeRateWeight_3lMuIDCat(float l1pt, float l1eta, int l1pdgId, float l1mva
                         float l2pt, float l2eta, int l2pdgId, float l2mva, float l2tightId,
                         float l3pt, float l3eta, int l3pdgId, float l3mva, float l3tightId, float WP)
 {
-    float mvas[]={l1mva, l2mva, l3mva};
     float pts[]={l1pt, l2pt, l3pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta)};
-    int pdgids[]={l1pdgId, l2pdgId, l3pdgId};
-    float tightIds[]={l1tightId, l2tightId,l3tightId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 3 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el: (tightIds[i] > 0 ? FR_mu : FR2_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta, l3eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : (l1tightId > 0 ? FR_mu : FR2_mu),
+                   abs(l2pdgId) == 11 ? FR_el : (l2tightId > 0 ? FR_mu : FR2_mu),
+                   abs(l3pdgId) == 11 ? FR_el : (l3tightId > 0 ? FR_mu : FR2_mu)};
+    int pass[]={!(l1mva < WP), !(l2mva < WP), !(l3mva < WP)};
+    float ret;
+    return fakeRateWeightN<3>(pts, etas, handles, pass, 1, 0, &ret);
 }
 
 bool passND_LooseDen(float l1pt, float l1eta, int l1pdgId, float relIso, float dxy, float dz, float tightId) 
@@ -466,14 +495,10 @@ float fakeRateWeight_2lss_ND(float l1pt, float l1eta, int l1pdgId, float l1relIs
         case 11: {// loose-loose
             bool l1L = passND_Loose(l1pt, l1eta, l1pdgId, l1relIso, l1dxy, l1dz, l1tightId);
             bool l2L = passND_Loose(l2pt, l2eta, l2pdgId, l2relIso, l2dxy, l2dz, l2tightId);
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FR_el : FR_mu);
-            int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-            int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-            double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-            TH2 *hist2 = (abs(l2pdgId) == 11 ? FR_el : FR_mu);
-            int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-            int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-            double fr2 = hist2->GetBinContent(ptbin2,etabin2);
+            const FRTable *hist1 = fakeRateMap(abs(l1pdgId) == 11 ? FR_el : FR_mu);
+            double fr1 = hist1->value(l1pt, std::abs(l1eta));
+            const FRTable *hist2 = fakeRateMap(abs(l2pdgId) == 11 ? FR_el : FR_mu);
+            double fr2 = hist2->value(l2pt, std::abs(l2eta));
             if      ( l1L &&  l2L) return 0;
             else if ( l1L && !l2L) return fr2/(1-fr2);
             else if (!l1L &&  l2L) return fr1/(1-fr1);
@@ -482,14 +507,10 @@ float fakeRateWeight_2lss_ND(float l1pt, float l1eta, int l1pdgId, float l1relIs
         case 22: {// tight-tight 
             bool l1T = passND_Tight(l1pt, l1eta, l1pdgId, l1relIso, l1dxy, l1dz, l1tightId);
             bool l2T = passND_Tight(l2pt, l2eta, l2pdgId, l2relIso, l2dxy, l2dz, l2tightId);
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FR2_el : FR2_mu);
-            int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-            int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-            double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-            TH2 *hist2 = (abs(l2pdgId) == 11 ? FR2_el : FR2_mu);
-            int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-            int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-            double fr2 = hist2->GetBinContent(ptbin2,etabin2);
+            const FRTable *hist1 = fakeRateMap(abs(l1pdgId) == 11 ? FR2_el : FR2_mu);
+            double fr1 = hist1->value(l1pt, std::abs(l1eta));
+            const FRTable *hist2 = fakeRateMap(abs(l2pdgId) == 11 ? FR2_el : FR2_mu);
+            double fr2 = hist2->value(l2pt, std::abs(l2eta));
             if      ( l1T &&  l2T) return 0;
             else if ( l1T && !l2T) return fr2/(1-fr2);
             else if (!l1T &&  l2T) return fr1/(1-fr1);
@@ -510,14 +531,10 @@ float chargeFlipWeight_2lss(float l1pt, float l1eta, int l1pdgId,
     if (l1pdgId * l2pdgId > 0) return 0.;
     double w = 0;
     if (abs(l1pdgId) == 11) {
-        int ptbin  = std::max(1, std::min(QF_el->GetNbinsX(), QF_el->GetXaxis()->FindBin(l1pt)));
-        int etabin = std::max(1, std::min(QF_el->GetNbinsY(), QF_el->GetYaxis()->FindBin(std::abs(l1eta))));
-        w += QF_el->GetBinContent(ptbin,etabin);
+        w += fakeRateMap(QF_el)->value(l1pt, std::abs(l1eta));
     }
     if (abs(l2pdgId) == 11) {
-        int ptbin  = std::max(1, std::min(QF_el->GetNbinsX(), QF_el->GetXaxis()->FindBin(l2pt)));
-        int etabin = std::max(1, std::min(QF_el->GetNbinsY(), QF_el->GetYaxis()->FindBin(std::abs(l2eta))));
-        w += QF_el->GetBinContent(ptbin,etabin);
+        w += fakeRateMap(QF_el)->value(l2pt, std::abs(l2eta));
     }
     return w;
 }
@@ -538,32 +555,18 @@ float fakeRateWeight_3lSyst(float l1pt, float l1eta, int l1pdgId, float l1mva,
                         float mu_barrel_lowpt, float mu_barrel_highpt, float mu_endcap_lowpt, float mu_endcap_highpt,
                         float el_cb_lowpt, float el_cb_highpt, float el_fb_lowpt, float el_fb_highpt, float el_endcap_lowpt, float el_endcap_highpt)
 {
-    /// 3 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  3 fail: weight +f*f*f/((1-f)(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva, l3mva};
     float pts[]={l1pt, l2pt, l3pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta)};
+    float etas[]={l1eta, l2eta, l3eta};
     int pdgids[]={l1pdgId, l2pdgId, l3pdgId};
-    float ret = -1.0f;
+    int handles[3], pass[]={!(l1mva < WP), !(l2mva < WP), !(l3mva < WP)};
+    float scales[3];
     for (unsigned int i = 0; i < 3 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el : FR_mu);
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            if (abs(pdgids[i]) == 11) fr *= ( std::abs(etas[i]) < 0.8 ? (pts[i] < 20 ? el_cb_lowpt : el_cb_highpt) :
-                                             (std::abs(etas[i]) < 1.5 ? (pts[i] < 20 ? el_fb_lowpt : el_fb_highpt) :
-                                                                        (pts[i] < 20 ? el_endcap_lowpt : el_endcap_highpt) ));
-            else /*==13*/             fr *= (std::abs(etas[i]) < 1.5 ?  (pts[i] < 20 ? mu_barrel_lowpt : mu_barrel_highpt) :
-                                                                        (pts[i] < 20 ? mu_endcap_lowpt : mu_endcap_highpt) );
-            ret *= -fr/(1.0f-fr);
-        }
+        handles[i] = abs(pdgids[i]) == 11 ? FR_el : FR_mu;
+        scales[i] = fakeRateSystScale(pdgids[i], pts[i], etas[i], 20, mu_barrel_lowpt, mu_barrel_highpt, mu_endcap_lowpt, mu_endcap_highpt,
+                                      el_cb_lowpt, el_cb_highpt, el_fb_lowpt, el_fb_highpt, el_endcap_lowpt, el_endcap_highpt);
     }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float ret;
+    return fakeRateWeightN<3>(pts, etas, handles, pass, 1, scales, &ret);
 }
 
 float fakeRateWeight_3lMVA(float l1pt, float l1eta, int l1pdgId, float l1mva,
@@ -576,22 +579,12 @@ float fakeRateWeight_3lMVA(float l1pt, float l1eta, int l1pdgId, float l1mva,
     /// 2 fail: weight -f*f/(1-f)(1-f)
     //  3 fail: weight +f*f*f/((1-f)(1-f)(1-f)
     //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva, l3mva};
     float pts[]={l1pt, l2pt, l3pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta)};
-    int pdgids[]={l1pdgId, l2pdgId, l3pdgId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 3 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el : FR_mu);
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta, l3eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : FR_mu, abs(l2pdgId) == 11 ? FR_el : FR_mu, abs(l3pdgId) == 11 ? FR_el : FR_mu};
+    int pass[]={!(l1mva < WP), !(l2mva < WP), !(l3mva < WP)};
+    float ret;
+    return fakeRateWeightN<3>(pts, etas, handles, pass, 1, 0, &ret);
 }
 
 float fakeRateWeight_3lBCat(float l1pt, float l1eta, int l1pdgId, float l1mva,
@@ -599,30 +592,17 @@ float fakeRateWeight_3lBCat(float l1pt, float l1eta, int l1pdgId, float l1mva,
                         float l3pt, float l3eta, int l3pdgId, float l3mva,
                         float WP, int nBJetMedium25, float scaleMuBL, float scaleMuBT, float scaleElBL, float scaleElBT)
 {
-    /// 3 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  3 fail: weight +f*f*f/((1-f)(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    float mvas[]={l1mva, l2mva, l3mva};
     float pts[]={l1pt, l2pt, l3pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta)};
+    float etas[]={l1eta, l2eta, l3eta};
     int pdgids[]={l1pdgId, l2pdgId, l3pdgId};
-    float ret = -1.0f;
+    int handles[3], pass[]={!(l1mva < WP), !(l2mva < WP), !(l3mva < WP)};
+    float scales[3];
     for (unsigned int i = 0; i < 3 ; ++i) {
-        if (mvas[i] < WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el):
-                                                (nBJetMedium25 > 1 ? FR2_mu : FR_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            fr *= (nBJetMedium25 > 1 ? (abs(pdgids[i]) == 11 ? scaleElBT : scaleMuBT) : 
-                                       (abs(pdgids[i]) == 11 ? scaleElBL : scaleMuBL) );
-            ret *= -fr/(1.0f-fr);
-        }
+        handles[i] = abs(pdgids[i]) == 11 ? (nBJetMedium25 > 1 ? FR2_el : FR_el) : (nBJetMedium25 > 1 ? FR2_mu : FR_mu);
+        scales[i] = nBJetMedium25 > 1 ? (abs(pdgids[i]) == 11 ? scaleElBT : scaleMuBT) : (abs(pdgids[i]) == 11 ? scaleElBL : scaleMuBL);
     }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float ret;
+    return fakeRateWeightN<3>(pts, etas, handles, pass, 1, scales, &ret);
 }
 
 float fakeRateWeight_3lCB(float l1pt, float l1eta, int l1pdgId, float l1relIso,
@@ -630,32 +610,20 @@ float fakeRateWeight_3lCB(float l1pt, float l1eta, int l1pdgId, float l1relIso,
                         float l3pt, float l3eta, int l3pdgId, float l3relIso,
                         float WP)
 {
-    float relIsos[]={l1relIso, l2relIso, l3relIso};
     float pts[]={l1pt, l2pt, l3pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta)};
-    int pdgids[]={l1pdgId, l2pdgId, l3pdgId};
-    float ret = -1.0f;
-    for (unsigned int i = 0; i < 3 ; ++i) {
-        if (relIsos[i] > WP) {
-	    TH2 *hist = (abs(pdgids[i]) == 11 ? FR_el : FR_mu);
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta, l3eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : FR_mu, abs(l2pdgId) == 11 ? FR_el : FR_mu, abs(l3pdgId) == 11 ? FR_el : FR_mu};
+    int pass[]={!(l1relIso > WP), !(l2relIso > WP), !(l3relIso > WP)};
+    float ret;
+    return fakeRateWeightN<3>(pts, etas, handles, pass, 1, 0, &ret);
 }
 
 float fetchFR_i(float l1pt, float l1eta, int l1pdgId, int iFR) 
 {
-    TH2 *hist1 = (abs(l1pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
+    const FRTable *hist1 = fakeRateTable(abs(l1pdgId) == 11 ? FRi_el[iFR] : FRi_mu[iFR]);
     if (hist1 == 0) { std::cerr << "ERROR, missing FR for pdgId " << l1pdgId << ", iFR " << iFR << std::endl; std::abort(); }
-    int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-    int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-    double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-    if (fr1 <= 0)  { std::cerr << "WARNING, FR is " << fr1 << " for " << hist1->GetName() << ", pt " << l1pt << " eta " << l1eta << std::endl; if (fr1<0) std::abort(); }
+    double fr1 = hist1->value(l1pt, std::abs(l1eta));
+    if (fr1 <= 0)  { std::cerr << "WARNING, FR is " << fr1 << " for " << hist1->name() << ", pt " << l1pt << " eta " << l1eta << std::endl; if (fr1<0) std::abort(); }
     return fr1;
 }
    
@@ -678,31 +646,15 @@ float fakeRateWeight_4l_2wp(float l1pt, float l1eta, int l1pdgId, float l1mva,
                         float l4pt, float l4eta, int l4pdgId, float l4mva,
                         float WP, float WP2)
 {
-    /// 4 pass: weight  0
-    /// 1 fail: weight +f/(1-f)
-    /// 2 fail: weight -f*f/(1-f)(1-f)
-    //  3 fail: weight +f*f*f/((1-f)(1-f)(1-f)
-    //  so, just multiply up factors of -f/(1-f) for each failure
-    //  hope it works also for 4l....
-    float mvas[]={l1mva-WP, l2mva-WP, l3mva-WP2, l4mva-WP2};
+    /// the two leading leptons use WP and the FR maps, the two others WP2 and the FR2 maps;
+    /// as in 3l, multiply up factors of -f/(1-f) for each failure, up to two failures
     float pts[]={l1pt, l2pt, l3pt, l4pt};
-    float etas[]={fabs(l1eta), fabs(l2eta), fabs(l3eta), fabs(l4eta)};
-    int pdgids[]={l1pdgId, l2pdgId, l3pdgId, l4pdgId};
-    float ret = -1.0f;
-    int ifail = 0;
-    for (unsigned int i = 0; i < 4 ; ++i) {
-        if (mvas[i] < 0) {
-            ifail++;
-	    TH2 *hist = (i <= 1 ? (abs(pdgids[i]) == 11 ? FR_el : FR_mu) : (abs(pdgids[i]) == 11 ? FR2_el : FR2_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
-            ret *= -fr/(1.0f-fr);
-        }
-    }
-    if (ifail > 2) return 0;
-    if (ret == -1.0f) ret = 0.0f;
-    return ret;
+    float etas[]={l1eta, l2eta, l3eta, l4eta};
+    int handles[]={abs(l1pdgId) == 11 ? FR_el : FR_mu, abs(l2pdgId) == 11 ? FR_el : FR_mu,
+                   abs(l3pdgId) == 11 ? FR2_el : FR2_mu, abs(l4pdgId) == 11 ? FR2_el : FR2_mu};
+    int pass[]={!(l1mva-WP < 0), !(l2mva-WP < 0), !(l3mva-WP2 < 0), !(l4mva-WP2 < 0)};
+    float ret;
+    return fakeRateWeightN<4>(pts, etas, handles, pass, 1, 0, &ret, 2);
 }
 
 float fakeRateWeight_4l_2wp_nf(int nf, float l1pt, float l1eta, int l1pdgId, float l1mva,
@@ -726,10 +678,8 @@ float fakeRateWeight_4l_2wp_nf(int nf, float l1pt, float l1eta, int l1pdgId, flo
     for (unsigned int i = 0; i < 4 ; ++i) {
         if (mvas[i] < 0) {
             ifail++;
-	    TH2 *hist = (i <= 1 ? (abs(pdgids[i]) == 11 ? FR_el : FR_mu) : (abs(pdgids[i]) == 11 ? FR2_el : FR2_mu));
-            int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pts[i])));
-            int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(etas[i])));
-            double fr = hist->GetBinContent(ptbin,etabin);
+	    const FRTable *hist = fakeRateMap(i <= 1 ? (abs(pdgids[i]) == 11 ? FR_el : FR_mu) : (abs(pdgids[i]) == 11 ? FR2_el : FR2_mu));
+            double fr = hist->value(pts[i], etas[i]);
             ret *= fr/(1.0f-fr);
         }
     }
@@ -745,14 +695,11 @@ float fakeRate_flavour_2l_19_lead(float l1pt, float l1eta, int l1pdgId,
         case 0: return 1.;
         case 1:
         case 2:
-             TH2 *num = (histo <= 1 ? (abs(l1pdgId) == 11 ? FR_el : FR_mu) : (abs(l1pdgId) == 11 ? FR2_el : FR2_mu));
-             TH2 *den = (histo <= 1 ? (abs(l1pdgId) == 11 ? FR_mu : FR_el) : (abs(l1pdgId) == 11 ? FR2_mu : FR2_el));
-             int ptnum  = std::max(1, std::min(num->GetNbinsX(), num->GetXaxis()->FindBin(l1pt)));
-             int etanum = std::max(1, std::min(num->GetNbinsY(), num->GetYaxis()->FindBin(fabs(l1eta))));
-             int ptden  = std::max(1, std::min(den->GetNbinsX(), den->GetXaxis()->FindBin(l1pt)));
-             int etaden = std::max(1, std::min(den->GetNbinsY(), den->GetYaxis()->FindBin(fabs(l1eta))));
-             if (den->GetBinContent(ptden,etaden) == 0) return 1.0;
-             return num->GetBinContent(ptnum,etanum)/den->GetBinContent(ptden,etaden);
+             const FRTable *num = fakeRateMap(histo <= 1 ? (abs(l1pdgId) == 11 ? FR_el : FR_mu) : (abs(l1pdgId) == 11 ? FR2_el : FR2_mu));
+             const FRTable *den = fakeRateMap(histo <= 1 ? (abs(l1pdgId) == 11 ? FR_mu : FR_el) : (abs(l1pdgId) == 11 ? FR2_mu : FR2_el));
+             double frden = den->value(l1pt, fabs(l1eta));
+             if (frden == 0) return 1.0;
+             return num->value(l1pt, fabs(l1eta))/frden;
     }
     return 0.;
 }
@@ -787,25 +734,19 @@ float fakeRateReader_2lss_FO(float l1eta, float l1pt, float l2eta, float l2pt, i
             double fpt,feta; int fid;
             if (pass2)   { fpt = l1pt; feta = std::abs(l1eta); fid = abs(l1pdgId); }
             else         { fpt = l2pt; feta = std::abs(l2eta); fid = abs(l2pdgId); }
-            TH2 *hist = (fid == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
+            const FRTable *hist = fakeRateTable(fid == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
 	    if (!hist){
 	      std::cout << "Error: FR histo not filled " << fid << " " << ind << std::endl;
 	      assert(false);
 	    }
-	    int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(fpt)));
-	    int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(feta)));
-	    double fr = hist->GetBinContent(ptbin,etabin);
+	    double fr = hist->value(fpt, feta);
             return fr/(1-fr);
         }
       case 2: {
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
-	    int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-	    int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-	    double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-           TH2 *hist2 = (abs(l2pdgId) == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
-	   int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-	   int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-	   double fr2 = hist2->GetBinContent(ptbin2,etabin2);
+            const FRTable *hist1 = fakeRateMap(abs(l1pdgId) == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
+	    double fr1 = hist1->value(l1pt, std::abs(l1eta));
+           const FRTable *hist2 = fakeRateMap(abs(l2pdgId) == 11 ? FRi_FO_el[ind] : FRi_FO_mu[ind]);
+	   double fr2 = hist2->value(l2pt, std::abs(l2eta));
             return -fr1*fr2/((1-fr1)*(1-fr2));
       }
         default: return 0;
@@ -821,26 +762,20 @@ float fakeRateReader_2lss_fHT_FO(float l1eta, float l1pt, float l2eta, float l2p
             double fpt,feta; int fid;
             if (pass2)   { fpt = l1pt; feta = std::abs(l1eta); fid = abs(l1pdgId); }
             else         { fpt = l2pt; feta = std::abs(l2eta); fid = abs(l2pdgId); }
-            TH2 *hist = (fid == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
+            const FRTable *hist = fakeRateTable(fid == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
 	    if (!hist){
 	      std::cout << "Error: FR histo not filled " << fid << " " << ind << std::endl;
 	      assert(false);
 	    }
-	    int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(fpt)));
-	    int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(feta)));
-	    double fr = hist->GetBinContent(ptbin,etabin);
+	    double fr = hist->value(fpt, feta);
 	    //	    std::cout << "returning " << fr/(1-fr) << std::endl;
             return fr/(1-fr);
         }
       case 2: {
-            TH2 *hist1 = (abs(l1pdgId) == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
-	    int ptbin1  = std::max(1, std::min(hist1->GetNbinsX(), hist1->GetXaxis()->FindBin(l1pt)));
-	    int etabin1 = std::max(1, std::min(hist1->GetNbinsY(), hist1->GetYaxis()->FindBin(std::abs(l1eta))));
-	    double fr1 = hist1->GetBinContent(ptbin1,etabin1);
-           TH2 *hist2 = (abs(l2pdgId) == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
-	   int ptbin2  = std::max(1, std::min(hist2->GetNbinsX(), hist2->GetXaxis()->FindBin(l2pt)));
-	   int etabin2 = std::max(1, std::min(hist2->GetNbinsY(), hist2->GetYaxis()->FindBin(std::abs(l2eta))));
-	   double fr2 = hist2->GetBinContent(ptbin2,etabin2);
+            const FRTable *hist1 = fakeRateMap(abs(l1pdgId) == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
+	    double fr1 = hist1->value(l1pt, std::abs(l1eta));
+           const FRTable *hist2 = fakeRateMap(abs(l2pdgId) == 11 ? FRi_fHT_FO_el[ind] : FRi_fHT_FO_mu[ind]);
+	   double fr2 = hist2->value(l2pt, std::abs(l2eta));
 	   //	   std::cout << "returning " << -fr1*fr2/((1-fr1)*(1-fr2)) << std::endl;
             return -fr1*fr2/((1-fr1)*(1-fr2));
       }
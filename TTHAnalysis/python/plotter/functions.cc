@@ -1,9 +1,9 @@
 #include <cmath>
 #include "Math/GenVector/LorentzVector.h"
 #include "Math/GenVector/PtEtaPhiM4D.h"
-#include "Math/GenVector/PxPyPzM4D.h"
 #include "Math/GenVector/Boost.h"
 #include "TLorentzVector.h"
+#include "kinematics.h"
 
 //// UTILITY FUNCTIONS NOT IN TFORMULA ALREADY
 
@@ -42,10 +42,11 @@ float mt_2(float pt1, float phi1, float pt2, float phi2) {
 }
 
 float mass_2(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    return (p41+p42).M();
+    return kinematics::mass_2(pt1,eta1,phi1,m1,pt2,eta2,phi2,m2);
+}
+
+float mass_2_ene(float ene1, float eta1, float phi1, float m1, float ene2, float eta2, float phi2, float m2) {
+    return kinematics::mass_2_ene(ene1,eta1,phi1,m1,ene2,eta2,phi2,m2);
 }
 
 float phi_2(float pt1, float phi1, float pt2, float phi2) {
@@ -57,17 +58,11 @@ float phi_2(float pt1, float phi1, float pt2, float phi2) {
 }
 
 float pt_3(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3) {
-    phi2 -= phi1;
-    phi3 -= phi1;
-    return hypot(pt1 + pt2 * std::cos(phi2) + pt3 * std::cos(phi3), pt2*std::sin(phi2) + pt3*std::sin(phi3));
+    return kinematics::pt_3(pt1,phi1,pt2,phi2,pt3,phi3);
 }
 
 float mass_3(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2, float pt3, float eta3, float phi3, float m3) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    PtEtaPhiMVector p43(pt3,eta3,phi3,m3);
-    return (p41+p42+p43).M();
+    return kinematics::mass_3(pt1,eta1,phi1,m1,pt2,eta2,phi2,m2,pt3,eta3,phi3,m3);
 }
 
 float pt_4(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3, float pt4, float phi4) {
@@ -78,19 +73,11 @@ float pt_4(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3,
 }
  
 float mass_4(float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2, float pt3, float eta3, float phi3, float m3, float pt4, float eta4, float phi4, float m4) {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    PtEtaPhiMVector p41(pt1,eta1,phi1,m1);
-    PtEtaPhiMVector p42(pt2,eta2,phi2,m2);
-    PtEtaPhiMVector p43(pt3,eta3,phi3,m3);
-    PtEtaPhiMVector p44(pt4,eta4,phi4,m4);
-    return (p41+p42+p43+p44).M();
+    return kinematics::mass_4(pt1,eta1,phi1,m1,pt2,eta2,phi2,m2,pt3,eta3,phi3,m3,pt4,eta4,phi4,m4);
 }
 
 float mt_llv(float ptl1, float phil1, float ptl2, float phil2, float ptv, float phiv) {
-    float px = ptl1*std::cos(phil1) + ptl2*std::cos(phil2) + ptv*std::cos(phiv);
-    float py = ptl1*std::sin(phil1) + ptl2*std::sin(phil2) + ptv*std::sin(phiv);
-    float ht = ptl1+ptl2+ptv;
-    return std::sqrt(std::max(0.f, ht*ht - px*px - py*py));
+    return kinematics::mt_llv(ptl1,phil1,ptl2,phil2,ptv,phiv);
 }
 
 float mt_lllv(float ptl1, float phil1, float ptl2, float phil2, float ptl3, float phil3, float ptv, float phiv) {
@@ -127,22 +114,30 @@ float u2_2(float met_pt, float met_phi, float ref_pt, float ref_phi)
 // reconstructs a top from lepton, met, b-jet, applying the W mass constraint and taking the smallest neutrino pZ
 float mtop_lvb(float ptl, float etal, float phil, float ml, float met, float metphi, float ptb, float etab, float phib, float mb) 
 {
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > PtEtaPhiMVector;
-    typedef ROOT::Math::LorentzVector<ROOT::Math::PxPyPzM4D<double> > PxPyPzMVector;
-    PtEtaPhiMVector p4l(ptl,etal,phil,ml);
-    PtEtaPhiMVector p4b(ptb,etab,phib,mb);
-    double MW=80.4;
-    double a = (1 - std::pow(p4l.Z()/p4l.E(), 2));
-    double ppe    = met * ptl * std::cos(phil - metphi)/p4l.E();
-    double brk    = MW*MW / (2*p4l.E()) + ppe;
-    double b      = (p4l.Z()/p4l.E()) * brk;
-    double c      = met*met - brk*brk;
-    double delta   = b*b - a*c;
-    double sqdelta = delta > 0 ? std::sqrt(delta) : 0;
-    double pz1 = (b + sqdelta)/a, pz2 = (b - sqdelta)/a;
-    double pznu = (abs(pz1) <= abs(pz2) ? pz1 : pz2);
-    PxPyPzMVector p4v(met*std::cos(metphi),met*std::sin(metphi),pznu,0);
-    return (p4l+p4b+p4v).M();
+    return kinematics::mtop_lvb(ptl,etal,phil,ml,met,metphi,ptb,etab,phib,mb);
+}
+
+// batch versions of the above for n events, with the objects one after the other in each array
+// (pt[i*n + iev] is the pt of object i in event iev; for mtop_lvb, the lepton, met and b-jet)
+void mass_2_batch(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    kinematics::mass_N<2>(n,pt,eta,phi,m,out);
+}
+void mass_3_batch(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    kinematics::mass_N<3>(n,pt,eta,phi,m,out);
+}
+void mass_4_batch(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    kinematics::mass_N<4>(n,pt,eta,phi,m,out);
+}
+void pt_3_batch(unsigned int n, const float *pt, const float *phi, float *out) {
+    kinematics::pt_3(n,pt,phi,out);
+}
+void mt_llv_batch(unsigned int n, const float *pt, const float *phi, float *out) {
+    kinematics::mt_llv(n,pt,phi,out);
+}
+void mtop_lvb_batch(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+    for (unsigned int iev = 0; iev < n; ++iev) {
+        out[iev] = kinematics::mtop_lvb(pt[iev],eta[iev],phi[iev],m[iev],pt[n+iev],phi[n+iev],pt[2*n+iev],eta[2*n+iev],phi[2*n+iev],m[2*n+iev]);
+    }
 }
 
 float DPhi_CMLep_Zboost(float l_pt, float l_eta, float l_phi, float l_M, float l_other_pt, float l_other_eta, float l_other_phi, float l_other_M){
@@ -391,44 +386,133 @@ float puw(int nTrueInt) { if (nTrueInt<50) return _puw_true[nTrueInt]; else retu
 //float puwMu17(int nVert) { return _puw_Mu17[nVert] * (2305428/29339.)*0.002/2.26; }
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "TH2F.h"
 #include "TFile.h"
 
-TFile *_file_recoToLoose_leptonSF_mu = NULL;
-TH2F *_histo_recoToLoose_leptonSF_mu = NULL;
-TFile *_file_recoToLoose_leptonSF_el = NULL;
-TH2F *_histo_recoToLoose_leptonSF_el1 = NULL;
-TH2F *_histo_recoToLoose_leptonSF_el2 = NULL;
+// Lepton scale factors for ttH: loadLeptonSF_ttH reads the histograms once from a directory
+// and copies them into flat tables, together with the values shifted up and down by the bin
+// errors. The evaluation then does no I/O and takes no lock, with the bins clamped as with
+// TH2::FindBin before. If nothing was loaded explicitly, the first evaluation loads the
+// default directory.
+
+class LeptonSFTable {
+    public:
+        LeptonSFTable() : x_(), y_() {}
+        explicit LeptonSFTable(const TH2 &hist) : x_(*hist.GetXaxis()), y_(*hist.GetYaxis()) {
+            for (int iy = 1; iy <= y_.n; ++iy) {
+                for (int ix = 1; ix <= x_.n; ++ix) {
+                    double val = hist.GetBinContent(ix,iy), err = hist.GetBinError(ix,iy);
+                    nominal_.push_back(val); up_.push_back(val+err); down_.push_back(val-err);
+                }
+            }
+        }
+        bool empty() const { return nominal_.empty(); }
+        // var = 0 is the nominal value, +1 (-1) the value shifted up (down) by the bin error,
+        // not below zero
+        double value(double x, double y, float var = 0) const {
+            int i = y_.bin(y)*x_.n + x_.bin(x);
+            if (var == 0) return nominal_[i];
+            return std::max(0., nominal_[i] + var*(var > 0 ? up_[i]-nominal_[i] : nominal_[i]-down_[i]));
+        }
+    private:
+        struct Axis {
+            Axis() : n(0), uniform(true), min(0), max(0) {}
+            Axis(const TAxis &axis) : n(axis.GetNbins()), uniform(axis.GetXbins()->GetSize() == 0), min(axis.GetXmin()), max(axis.GetXmax()) {
+                for (int i = 1; i <= n+1; ++i) edges.push_back(axis.GetBinLowEdge(i));
+            }
+            // 0-based bin, as std::max(1, std::min(n, axis.FindBin(x))) - 1
+            int bin(double x) const {
+                int b;
+                if (x < min) b = 0;
+                else if (!(x < max)) b = n+1;
+                else if (uniform) b = 1 + int(n*(x-min)/(max-min));
+                else b = std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+                return std::max(1, std::min(n, b)) - 1;
+            }
+            int n; bool uniform; double min, max;
+            std::vector<double> edges;
+        };
+        Axis x_, y_;
+        std::vector<double> nominal_, up_, down_;
+};
+
+struct LeptonSFTables_ttH {
+    LeptonSFTable recoToLoose_mu, recoToLoose_el1, recoToLoose_el2;
+    LeptonSFTable looseToTight_mu_2lss, looseToTight_el_2lss, looseToTight_mu_3l, looseToTight_el_3l;
+};
+
+const char *_leptonSF_ttH_defaultPath = "/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files";
+std::mutex _leptonSF_ttH_mutex;
+// tables replaced by a later load are not deleted, as other threads may still be reading them
+std::atomic<const LeptonSFTables_ttH *> _leptonSF_ttH_tables(NULL);
+
+bool _loadLeptonSFTable(LeptonSFTable &table, const std::string &path, const char *file, const char *name) {
+    std::string fname = path + "/" + file;
+    TFile *f = TFile::Open(fname.c_str());
+    if (f == NULL) {
+        std::cerr << "ERROR: could not open " << fname << std::endl;
+        return false;
+    }
+    TH2 *hist = dynamic_cast<TH2*>(f->Get(name));
+    if (hist) table = LeptonSFTable(*hist);
+    else std::cerr << "ERROR: could not find " << name << " in " << fname << std::endl;
+    f->Close();
+    delete f;
+    return hist != NULL;
+}
+
+bool _loadLeptonSF_ttH(const std::string &path) {
+    LeptonSFTables_ttH *tables = new LeptonSFTables_ttH();
+    bool ok = _loadLeptonSFTable(tables->recoToLoose_mu, path, "mu_eff_recoToLoose_ttH.root", "FINAL") &&
+              _loadLeptonSFTable(tables->recoToLoose_el1, path, "kinematicBinSFele.root", "MVAVLooseFO_and_IDEmu_and_TightIP2D") &&
+              _loadLeptonSFTable(tables->recoToLoose_el2, path, "kinematicBinSFele.root", "MiniIso0p4_vs_AbsEta") &&
+              _loadLeptonSFTable(tables->looseToTight_mu_2lss, path, "lepMVAEffSF_m_2lss.root", "sf") &&
+              _loadLeptonSFTable(tables->looseToTight_el_2lss, path, "lepMVAEffSF_e_2lss.root", "sf") &&
+              _loadLeptonSFTable(tables->looseToTight_mu_3l, path, "lepMVAEffSF_m_3l.root", "sf") &&
+              _loadLeptonSFTable(tables->looseToTight_el_3l, path, "lepMVAEffSF_e_3l.root", "sf");
+    if (!ok) {
+        delete tables;
+        return false;
+    }
+    _leptonSF_ttH_tables.store(tables, std::memory_order_release);
+    return true;
+}
 
-float _get_recoToLoose_leptonSF_ttH(int pdgid, float pt, float eta, int nlep, float var){
+// load the lepton scale factors from the files in this directory, to be called before the event loop
+bool loadLeptonSF_ttH(const char *path = _leptonSF_ttH_defaultPath) {
+    std::lock_guard<std::mutex> lock(_leptonSF_ttH_mutex);
+    return _loadLeptonSF_ttH(path);
+}
 
-  if (var!=0) assert(0); // NOT IMPLEMENTED
+const LeptonSFTables_ttH & _get_leptonSF_ttH_tables() {
+    const LeptonSFTables_ttH *tables = _leptonSF_ttH_tables.load(std::memory_order_acquire);
+    if (tables == NULL) {
+        std::lock_guard<std::mutex> lock(_leptonSF_ttH_mutex);
+        tables = _leptonSF_ttH_tables.load(std::memory_order_acquire);
+        if (tables == NULL) {
+            std::cerr << "WARNING: lepton scale factors not loaded, reading them from " << _leptonSF_ttH_defaultPath << std::endl;
+            if (!_loadLeptonSF_ttH(_leptonSF_ttH_defaultPath)) std::abort();
+            tables = _leptonSF_ttH_tables.load(std::memory_order_acquire);
+        }
+    }
+    return *tables;
+}
 
-  if (!_histo_recoToLoose_leptonSF_mu) {
-    _file_recoToLoose_leptonSF_mu = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/mu_eff_recoToLoose_ttH.root","read");
-    _histo_recoToLoose_leptonSF_mu = (TH2F*)(_file_recoToLoose_leptonSF_mu->Get("FINAL"));
-  }
-  if (!_histo_recoToLoose_leptonSF_el1) {
-    _file_recoToLoose_leptonSF_el = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/kinematicBinSFele.root","read");
-    _histo_recoToLoose_leptonSF_el1 = (TH2F*)(_file_recoToLoose_leptonSF_el->Get("MVAVLooseFO_and_IDEmu_and_TightIP2D"));
-    _histo_recoToLoose_leptonSF_el2 = (TH2F*)(_file_recoToLoose_leptonSF_el->Get("MiniIso0p4_vs_AbsEta"));
-  }
+float _get_recoToLoose_leptonSF_ttH(const LeptonSFTables_ttH &tables, int pdgid, float pt, float eta, int nlep, float var){
 
   if (abs(pdgid)==13){
-    TH2F *hist = _histo_recoToLoose_leptonSF_mu;
-    int etabin = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(eta)));
-    int ptbin  = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(pt)));
-    return hist->GetBinContent(etabin,ptbin);
+    return tables.recoToLoose_mu.value(eta,pt,var);
   }
   if (abs(pdgid)==11){
-    TH2F *hist = _histo_recoToLoose_leptonSF_el1;
-    int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pt)));
-    int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(fabs(eta))));
-    float out = hist->GetBinContent(ptbin,etabin);
-    hist = _histo_recoToLoose_leptonSF_el2;
-    ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pt)));
-    etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(fabs(eta))));
-    out *= hist->GetBinContent(ptbin,etabin);
+    float out = tables.recoToLoose_el1.value(pt,fabs(eta),var);
+    out *= tables.recoToLoose_el2.value(pt,fabs(eta),var);
     return out;
   }
 
@@ -437,60 +521,40 @@ float _get_recoToLoose_leptonSF_ttH(int pdgid, float pt, float eta, int nlep, fl
 
 }
 
-TFile *_file_looseToTight_leptonSF_mu_2lss = NULL;
-TH2F *_histo_looseToTight_leptonSF_mu_2lss = NULL;
-TFile *_file_looseToTight_leptonSF_el_2lss = NULL;
-TH2F *_histo_looseToTight_leptonSF_el_2lss = NULL;
-TFile *_file_looseToTight_leptonSF_mu_3l = NULL;
-TH2F *_histo_looseToTight_leptonSF_mu_3l = NULL;
-TFile *_file_looseToTight_leptonSF_el_3l = NULL;
-TH2F *_histo_looseToTight_leptonSF_el_3l = NULL;
-
-float _get_looseToTight_leptonSF_ttH(int pdgid, float _pt, float eta, int nlep, float var){
+float _get_looseToTight_leptonSF_ttH(const LeptonSFTables_ttH &tables, int pdgid, float _pt, float eta, int nlep, float var){
 
   float pt = std::min(float(79.9),_pt);
 
-  if (var!=0) assert(0); // NOT IMPLEMENTED
+  const LeptonSFTable *table = 0;
+  if (abs(pdgid)==13) table = (nlep>2) ? &tables.looseToTight_mu_3l : &tables.looseToTight_mu_2lss;
+  else if (abs(pdgid)==11) table = (nlep>2) ? &tables.looseToTight_el_3l : &tables.looseToTight_el_2lss;
+  assert(table);
+  return table->value(pt,fabs(eta),var);
 
-  if (!_histo_looseToTight_leptonSF_mu_2lss) {
-    _file_looseToTight_leptonSF_mu_2lss = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/lepMVAEffSF_m_2lss.root","read");
-    _histo_looseToTight_leptonSF_mu_2lss = (TH2F*)(_file_looseToTight_leptonSF_mu_2lss->Get("sf"));
-  }
-  if (!_histo_looseToTight_leptonSF_el_2lss) {
-    _file_looseToTight_leptonSF_el_2lss = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/lepMVAEffSF_e_2lss.root","read");
-    _histo_looseToTight_leptonSF_el_2lss = (TH2F*)(_file_looseToTight_leptonSF_el_2lss->Get("sf"));
-  }
-  if (!_histo_looseToTight_leptonSF_mu_3l) {
-    _file_looseToTight_leptonSF_mu_3l = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/lepMVAEffSF_m_3l.root","read");
-    _histo_looseToTight_leptonSF_mu_3l = (TH2F*)(_file_looseToTight_leptonSF_mu_3l->Get("sf"));
-  }
-  if (!_histo_looseToTight_leptonSF_el_3l) {
-    _file_looseToTight_leptonSF_el_3l = new TFile("/afs/cern.ch/user/p/peruzzi/work/tthtrees/cms_utility_files/lepMVAEffSF_e_3l.root","read");
-    _histo_looseToTight_leptonSF_el_3l = (TH2F*)(_file_looseToTight_leptonSF_el_3l->Get("sf"));
-  }
+}
 
-  TH2F *hist = 0;
-  if (abs(pdgid)==13) hist = (nlep>2) ? _histo_looseToTight_leptonSF_mu_3l : _histo_looseToTight_leptonSF_mu_2lss;
-  else if (abs(pdgid)==11) hist = (nlep>2) ? _histo_looseToTight_leptonSF_el_3l : _histo_looseToTight_leptonSF_el_2lss;
-  assert(hist);
-  int ptbin  = std::max(1, std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(pt)));
-  int etabin = std::max(1, std::min(hist->GetNbinsY(), hist->GetYaxis()->FindBin(fabs(eta))));
-  return hist->GetBinContent(ptbin,etabin);
+float _get_leptonSF_ttH(const LeptonSFTables_ttH &tables, int pdgid, float pt, float eta, int nlep, float var){
+
+  float recoToLoose = _get_recoToLoose_leptonSF_ttH(tables,pdgid,pt,eta,nlep,var);
+  float looseToTight = _get_looseToTight_leptonSF_ttH(tables,pdgid,pt,eta,nlep,var);
+  float res = recoToLoose*looseToTight;
+  return std::max(res, 0.f);
 
 }
 
+// var = +1 (-1) shifts all the scale factors up (down) by their uncertainty: the reco to loose
+// and loose to tight tables, for muons and electrons, move together as if fully correlated
 float leptonSF_ttH(int pdgid, float pt, float eta, int nlep, float var=0){
+  return _get_leptonSF_ttH(_get_leptonSF_ttH_tables(),pdgid,pt,eta,nlep,var);
+}
 
-  float recoToLoose = _get_recoToLoose_leptonSF_ttH(pdgid,pt,eta,nlep,var);
-  float looseToTight = _get_looseToTight_leptonSF_ttH(pdgid,pt,eta,nlep,var);
-  float res = recoToLoose*looseToTight;
-  assert (res>0);
-  return res;
-
+// leptonSF_ttH of n leptons
+void leptonSF_ttH_batch(unsigned int n, const int *pdgid, const float *pt, const float *eta, int nlep, float var, float *out){
+  const LeptonSFTables_ttH &tables = _get_leptonSF_ttH_tables();
+  for (unsigned int i = 0; i < n; ++i) out[i] = _get_leptonSF_ttH(tables,pdgid[i],pt[i],eta[i],nlep,var);
 }
 
-float triggerSF_ttH(int pdgid1, float pt1, int pdgid2, float pt2, int nlep, float var_ee=0){
-  if (var_ee!=0) assert(0); // NOT IMPLEMENTED
+float _get_triggerSF_ttH(int pdgid1, float pt1, int pdgid2, float pt2, int nlep){
   if (nlep>2) return 1;
   if (abs(pdgid1)==11 && abs(pdgid2)==11){
     if (std::max(pt1,pt2)<40) return 0.95;
@@ -502,6 +566,24 @@ float triggerSF_ttH(int pdgid1, float pt1, int pdgid2, float pt2, int nlep, floa
   else return 0.98;
 }
 
+void _check_triggerSF_ttH_var(float var_ee){
+  if (var_ee!=0) { // NOT IMPLEMENTED
+    std::cerr << "ERROR: triggerSF_ttH has no variation, var_ee must be 0" << std::endl;
+    std::abort();
+  }
+}
+
+float triggerSF_ttH(int pdgid1, float pt1, int pdgid2, float pt2, int nlep, float var_ee=0){
+  _check_triggerSF_ttH_var(var_ee);
+  return _get_triggerSF_ttH(pdgid1,pt1,pdgid2,pt2,nlep);
+}
+
+// triggerSF_ttH of n events
+void triggerSF_ttH_batch(unsigned int n, const int *pdgid1, const float *pt1, const int *pdgid2, const float *pt2, int nlep, float var_ee, float *out){
+  _check_triggerSF_ttH_var(var_ee);
+  for (unsigned int i = 0; i < n; ++i) out[i] = _get_triggerSF_ttH(pdgid1[i],pt1[i],pdgid2[i],pt2[i],nlep);
+}
+
 
 
 void functions() {}
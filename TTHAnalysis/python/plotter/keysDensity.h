@@ -0,0 +1,182 @@
+#ifndef CMGTools_TTHAnalysis_plotter_keysDensity_h
+#define CMGTools_TTHAnalysis_plotter_keysDensity_h
+
+//
+// Binned Gaussian kernel density estimate of weighted 1D data, with the
+// bandwidths of RooNDKeysPdf (used by TH1KeysNew):
+//   - fixed:    h0  = rho * (4/3)^(1/5) * sumw^(-1/5) * sigma
+//   - adaptive: h_i = rho * (4/3)^(1/5) * sumw^(-1/5) * sqrt(sigma / (12 f0(x_i)))
+// with sigma the weighted rms of the data and f0 the density estimated with
+// h0; the kernels are truncated at 3 widths as in RooNDKeysPdf.
+//
+// Instead of summing the kernels of all the events at each point, the
+// events are binned linearly on a fine grid (and, when the bandwidth is
+// adaptive, in log(h) on a ladder of bandwidths in steps of 5%, so up to
+// 143 levels for the allowed range of bandwidths), and each bandwidth is
+// convolved with its kernel by FFT, so the cost is O(N + K G log G) instead
+// of O(N * nPoints), with K the number of levels holding entries. The grid spacing is at most
+// 1/4 of the smallest bandwidth, the binning errors are then well below the
+// percent of the peak density.
+//
+// The data can be mirrored at the low and high edges of the range, as with
+// the Mirror options of RooKeysPdf: symmetrically (+1) or anti-symmetrically
+// (-1, the mirrored events are subtracted). The density used to set the
+// adaptive bandwidths always uses the symmetric mirrors, and the mirrored
+// events take the bandwidth of their original.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace keysDensity {
+
+    // in-place radix-2 FFT, a.size() must be a power of 2; the inverse is not divided by a.size()
+    inline void fft(std::vector<std::complex<double> > &a, bool inverse) {
+        const size_t n = a.size();
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(a[i], a[j]);
+        }
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const double ang = 2*M_PI/len * (inverse ? 1 : -1);
+            const std::complex<double> wlen(std::cos(ang), std::sin(ang));
+            for (size_t i = 0; i < n; i += len) {
+                std::complex<double> w(1);
+                for (size_t j = 0; j < len/2; ++j) {
+                    const std::complex<double> u = a[i+j], v = a[i+j+len/2] * w;
+                    a[i+j] = u + v;
+                    a[i+j+len/2] = u - v;
+                    w *= wlen;
+                }
+            }
+        }
+    }
+
+    // sum over the entries (x[i], w[i]), and over their mirrors, of w * Gaussian kernel of width h[i]
+    // (or h[0] for all if h.size() == 1), evaluated at the points at
+    inline void kernelSum(const std::vector<double> &x, const std::vector<double> &w, const std::vector<double> &h,
+                          double min, double max, int mirrorLo, int mirrorHi,
+                          const std::vector<double> &at, std::vector<double> &out) {
+        const double nSigma = 3.0, ladderStep = 1.05;
+        const size_t n = x.size();
+        const bool fixed = (h.size() == 1);
+        const double range = max - min;
+        double hmin = h[0], hmax = h[0];
+        for (size_t i = 1; i < h.size(); ++i) { hmin = std::min(hmin, h[i]); hmax = std::max(hmax, h[i]); }
+
+        // bandwidth ladder h_k = hmin * step^k, k = 0 .. nH-1, with h_(nH-1) >= hmax
+        double step = 1; int nH = 1;
+        if (!fixed && hmax > hmin) {
+            step = ladderStep;
+            nH = int(std::ceil(std::log(hmax/hmin)/std::log(step))) + 1;
+        }
+        const double htop = hmin*std::pow(step, nH-1);
+
+        // grid: nodes min + (j - pad)*dx, j = 0 .. nNodes-1, with max on a node
+        const int nCells = std::min(16384, std::max(1024, int(std::ceil(4*range/hmin))));
+        const double dx = range/nCells;
+        const int pad = int(std::ceil(nSigma*htop/dx)) + 1;
+        const int nNodes = nCells + 2*pad + 1;
+        size_t nfft = 1; while (nfft < size_t(nNodes)) nfft <<= 1;
+        // entries by lower bandwidth of the ladder, and fraction of their weight to the upper one
+        std::vector<double> hfrac(n, 0.);
+        std::vector<std::vector<size_t> > byH(nH);
+        for (size_t i = 0; i < n; ++i) {
+            if (nH == 1) { byH[0].push_back(i); continue; }
+            const double t = std::log(h[i]/hmin)/std::log(step);
+            const int k = std::min(std::max(int(t), 0), nH-2);
+            hfrac[i] = std::min(std::max(t - k, 0.), 1.);
+            byH[k].push_back(i);
+        }
+
+        std::vector<std::complex<double> > sum(nfft), both(nfft);
+        std::vector<double> grid(nNodes), kernel;
+        for (int k = 0; k < nH; ++k) {
+            // linear binning of the entries of this bandwidth, and of their mirrors
+            std::fill(grid.begin(), grid.end(), 0.);
+            bool any = false;
+            for (int kk = std::max(k-1, 0); kk <= k; ++kk) {
+                for (size_t ii = 0, ni = byH[kk].size(); ii < ni; ++ii) {
+                    const size_t i = byH[kk][ii];
+                    const double wk = w[i] * (kk == k ? 1 - hfrac[i] : hfrac[i]);
+                    if (wk == 0) continue;
+                    any = true;
+                    const double y[3] = { x[i], 2*min - x[i], 2*max - x[i] };
+                    const double s[3] = { 1., double(mirrorLo), double(mirrorHi) };
+                    for (int m = 0; m < 3; ++m) {
+                        if (s[m] == 0) continue;
+                        const double u = (y[m] - min)/dx + pad;
+                        const int j = int(std::floor(u));
+                        if (j < 0 || j+1 >= nNodes) continue;
+                        const double f = u - j;
+                        grid[j]   += s[m]*wk*(1-f);
+                        grid[j+1] += s[m]*wk*f;
+                    }
+                }
+            }
+            if (!any) continue;
+            // truncated Gaussian kernel of width hk, normalized to unit integral on the grid
+            const double hk = hmin*std::pow(step, k);
+            const int half = std::min(pad-1, int(nSigma*hk/dx));
+            kernel.assign(2*half+1, 0.);
+            double norm = 0;
+            for (int j = -half; j <= half; ++j) {
+                const double z = j*dx/hk;
+                norm += (kernel[j+half] = std::exp(-0.5*z*z));
+            }
+            // transform the grid (real part) and the kernel (imaginary part) together, then separate them
+            std::fill(both.begin(), both.end(), 0.);
+            for (int j = 0; j < nNodes; ++j) both[j].real(grid[j]);
+            for (int j = -half; j <= half; ++j) both[(j + nfft) % nfft].imag(kernel[j+half]/(norm*dx));
+            fft(both, false);
+            for (size_t j = 0; j < nfft; ++j) {
+                const std::complex<double> a = both[j], b = std::conj(both[(nfft - j) % nfft]);
+                sum[j] += (a + b) * (a - b) * std::complex<double>(0, -0.25);
+            }
+        }
+        fft(sum, true);
+
+        out.resize(at.size());
+        for (size_t p = 0; p < at.size(); ++p) {
+            const double u = std::min(std::max((at[p] - min)/dx, 0.), double(nCells)) + pad;
+            const int j = std::min(int(u), nNodes-2);
+            const double f = u - j;
+            out[p] = ((1-f)*sum[j].real() + f*sum[j+1].real())/nfft;
+        }
+    }
+
+    // density (times the sum of weights) of the weighted entries x in [min, max), at the points at
+    inline void evaluate(const std::vector<double> &x, const std::vector<double> &w, double min, double max,
+                         bool adaptive, double rho, int mirrorLo, int mirrorHi,
+                         const std::vector<double> &at, std::vector<double> &out) {
+        const size_t n = x.size();
+        const double range = max - min;
+        double sw = 0, swx = 0, swx2 = 0;
+        for (size_t i = 0; i < n; ++i) { sw += w[i]; swx += w[i]*x[i]; swx2 += w[i]*x[i]*x[i]; }
+        const double mean = swx/sw;
+        double sigma = std::sqrt(std::max(swx2/sw - mean*mean, 0.));
+        if (!(sigma > 0)) sigma = range/std::sqrt(12.); // all the entries at the same point
+        const double neff = (sw > 0 ? sw : double(n));
+        const double scale = rho * std::pow(4./3., 0.2) * std::pow(neff, -0.2);
+        // the bandwidths are kept within [range/1000, range], to bound the grid
+        const double hlo = 1e-3*range, hhi = range;
+        std::vector<double> h(1, std::min(std::max(scale * sigma, hlo), hhi));
+        if (adaptive) {
+            std::vector<double> f0;
+            kernelSum(x, w, h, min, max, std::abs(mirrorLo), std::abs(mirrorHi), x, f0);
+            h.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                const double f = f0[i]/neff;
+                h[i] = (f > 0 ? std::min(std::max(scale * std::sqrt(sigma/(12*f)), hlo), hhi) : hhi);
+            }
+        }
+        kernelSum(x, w, h, min, max, mirrorLo, mirrorHi, at, out);
+    }
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef CMGTools_TTHAnalysis_plotter_kinematics_h
+#define CMGTools_TTHAnalysis_plotter_kinematics_h
+
+//
+// Closed-form kinematics of a few objects given as (pt, eta, phi, m), used by
+// functions.cc instead of sums of ROOT::Math::LorentzVector<PtEtaPhiM4D>:
+// each object is converted to cartesian coordinates once (the sin and cos of
+// phi, which the compiler evaluates together, and the sinh of eta), and the
+// sums are done on px, py, pz, E. The masses agree with the LorentzVector
+// ones up to the float rounding of the result, and are negative for a
+// negative mass squared as there.
+//
+// The batch versions take structure-of-arrays inputs, n values per object
+// one object after the other (pt[i*n + iev] is object i of event iev), and
+// loop over the events without branches.
+//
+
+#include <algorithm>
+#include <cmath>
+
+namespace kinematics {
+
+    struct P4 {
+        double px, py, pz, e;
+        P4() : px(0), py(0), pz(0), e(0) {}
+        void add(double pt, double eta, double phi, double m) {
+            const double x = pt*std::cos(phi), y = pt*std::sin(phi), z = pt*std::sinh(eta);
+            px += x; py += y; pz += z;
+            e += std::sqrt(std::max(x*x + y*y + z*z + m*std::abs(m), 0.));
+        }
+        void addXYZM(double x, double y, double z, double m) {
+            px += x; py += y; pz += z;
+            e += std::sqrt(std::max(x*x + y*y + z*z + m*std::abs(m), 0.));
+        }
+        double m2() const { return e*e - px*px - py*py - pz*pz; }
+        double m() const { const double mm = m2(); return mm >= 0 ? std::sqrt(mm) : -std::sqrt(-mm); }
+        double pt() const { return std::sqrt(px*px + py*py); }
+    };
+
+    inline double mass_2(double pt1, double eta1, double phi1, double m1, double pt2, double eta2, double phi2, double m2) {
+        P4 p4; p4.add(pt1,eta1,phi1,m1); p4.add(pt2,eta2,phi2,m2);
+        return p4.m();
+    }
+
+    inline double mass_3(double pt1, double eta1, double phi1, double m1, double pt2, double eta2, double phi2, double m2, double pt3, double eta3, double phi3, double m3) {
+        P4 p4; p4.add(pt1,eta1,phi1,m1); p4.add(pt2,eta2,phi2,m2); p4.add(pt3,eta3,phi3,m3);
+        return p4.m();
+    }
+
+    inline double mass_4(double pt1, double eta1, double phi1, double m1, double pt2, double eta2, double phi2, double m2, double pt3, double eta3, double phi3, double m3, double pt4, double eta4, double phi4, double m4) {
+        P4 p4; p4.add(pt1,eta1,phi1,m1); p4.add(pt2,eta2,phi2,m2); p4.add(pt3,eta3,phi3,m3); p4.add(pt4,eta4,phi4,m4);
+        return p4.m();
+    }
+
+    // mass of two objects given by their energy instead of their pt
+    inline double mass_2_ene(double ene1, double eta1, double phi1, double m1, double ene2, double eta2, double phi2, double m2) {
+        return mass_2(ene1/std::cosh(eta1),eta1,phi1,m1, ene2/std::cosh(eta2),eta2,phi2,m2);
+    }
+
+    // the float expressions of pt_3 and mt_llv, which were already in closed form
+    inline float pt_3(float pt1, float phi1, float pt2, float phi2, float pt3, float phi3) {
+        phi2 -= phi1;
+        phi3 -= phi1;
+        return hypot(pt1 + pt2 * std::cos(phi2) + pt3 * std::cos(phi3), pt2*std::sin(phi2) + pt3*std::sin(phi3));
+    }
+
+    inline float mt_llv(float ptl1, float phil1, float ptl2, float phil2, float ptv, float phiv) {
+        float px = ptl1*std::cos(phil1) + ptl2*std::cos(phil2) + ptv*std::cos(phiv);
+        float py = ptl1*std::sin(phil1) + ptl2*std::sin(phil2) + ptv*std::sin(phiv);
+        float ht = ptl1+ptl2+ptv;
+        return std::sqrt(std::max(0.f, ht*ht - px*px - py*py));
+    }
+
+    // top mass from lepton, met and b-jet, with the W mass constraint on the lepton and neutrino
+    // and the solution of smallest |pz| for the neutrino (the real part if there is none)
+    inline double mtop_lvb(double ptl, double etal, double phil, double ml, double met, double metphi, double ptb, double etab, double phib, double mb) {
+        P4 l; l.add(ptl,etal,phil,ml);
+        const double MW=80.4;
+        const double a = (1 - std::pow(l.pz/l.e, 2));
+        const double ppe    = met * ptl * std::cos(phil - metphi)/l.e;
+        const double brk    = MW*MW / (2*l.e) + ppe;
+        const double b      = (l.pz/l.e) * brk;
+        const double c      = met*met - brk*brk;
+        const double delta   = b*b - a*c;
+        const double sqdelta = delta > 0 ? std::sqrt(delta) : 0;
+        const double pz1 = (b + sqdelta)/a, pz2 = (b - sqdelta)/a;
+        const double pznu = (std::abs(pz1) <= std::abs(pz2) ? pz1 : pz2);
+        P4 sum = l;
+        sum.add(ptb,etab,phib,mb);
+        sum.addXYZM(met*std::cos(metphi),met*std::sin(metphi),pznu,0);
+        return sum.m();
+    }
+
+    // invariant mass of N objects in each of n events
+    template<unsigned int N>
+    void mass_N(unsigned int n, const float *pt, const float *eta, const float *phi, const float *m, float *out) {
+        for (unsigned int iev = 0; iev < n; ++iev) {
+            P4 p4;
+            for (unsigned int i = 0; i < N; ++i) p4.add(pt[i*n+iev], eta[i*n+iev], phi[i*n+iev], m[i*n+iev]);
+            out[iev] = p4.m();
+        }
+    }
+
+    // pt_3 and mt_llv of n events, with the three objects as in mass_N
+    inline void pt_3(unsigned int n, const float *pt, const float *phi, float *out) {
+        for (unsigned int iev = 0; iev < n; ++iev) out[iev] = pt_3(pt[iev], phi[iev], pt[n+iev], phi[n+iev], pt[2*n+iev], phi[2*n+iev]);
+    }
+    inline void mt_llv(unsigned int n, const float *pt, const float *phi, float *out) {
+        for (unsigned int iev = 0; iev < n; ++iev) out[iev] = mt_llv(pt[iev], phi[iev], pt[n+iev], phi[n+iev], pt[2*n+iev], phi[2*n+iev]);
+    }
+
+}
+
+#endif
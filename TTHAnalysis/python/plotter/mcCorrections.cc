@@ -4,6 +4,11 @@ using std::abs;
 using std::exp;
 using std::log;
 
+// the random numbers of each smearing are keyed by (run, lumi, event, object) and by a stream
+// per corrected quantity, see smearer.h; object is the 0-based index of the lepton in the event
+// (LepGood1 is object 0), the same in the plotter and in the macros/leptons scripts
+enum McCorrectionStream { mcSmearSip3d = 1, mcSmearDz = 2, mcSmearDxy = 3, mcSmearJetPtRatio = 4 };
+
 double scaleIpVarsMC(double ipvar, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny) {
     if (abs(pdgId) == 13) {
         if (mcMatchId > 0 || mcMatchAny <= 1) {
@@ -19,33 +24,34 @@ double scaleIpVarsMC(double ipvar, int pdgId, double pt, double eta, int mcMatch
         }
     }
 }
-double scaleSip3dMC(double sip3d, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny) {
+double scaleSip3dMC(double sip3d, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object) {
     if (abs(pdgId) == 11 && (mcMatchId > 0 || mcMatchAny <= 1) && abs(eta) >= 1.479) {
-        return logSmearMC(sip3d, 0.10, 0.2);
+        return logSmearMC(sip3d, 0.10, 0.2, run, lumi, event, object, mcSmearSip3d);
     }
     return scaleIpVarsMC(sip3d,pdgId,pt,eta,mcMatchId,mcMatchAny);
 }
-double scaleDzMC(double dz, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny) {
+double scaleDzMC(double dz, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object) {
     if (abs(pdgId) == 11 && (mcMatchId > 0 || mcMatchAny <= 1) && abs(eta) >= 1.479) {
-        return logSmearMC(dz, 0.20, 0.3);
+        return logSmearMC(dz, 0.20, 0.3, run, lumi, event, object, mcSmearDz);
     }
     return scaleIpVarsMC(dz,pdgId,pt,eta,mcMatchId,mcMatchAny);
 }
-double scaleDxyMC(double dxy, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny) {
+double scaleDxyMC(double dxy, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object) {
     if (abs(pdgId) == 11 && (mcMatchId > 0 || mcMatchAny <= 1) && abs(eta) >= 1.479) {
-        return logSmearMC(dxy, 0.07, 0.3);
+        return logSmearMC(dxy, 0.07, 0.3, run, lumi, event, object, mcSmearDxy);
     }
     return scaleIpVarsMC(dxy,pdgId,pt,eta,mcMatchId,mcMatchAny);
 }
 
-double correctJetPtRatioMC(double jetPtRatio, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny) {
+double correctJetPtRatioMC(double jetPtRatio, int pdgId, double pt, double eta, int mcMatchId, int mcMatchAny, unsigned int run, unsigned int lumi, unsigned long long event, unsigned int object) {
     if (mcMatchAny >= 2) {
         if (pt < 15 && jetPtRatio == 1) {
-            if (gSmearer_->Rndm() < 0.2) {
+            cmg::CounterRandom rnd = smearRandom(run, lumi, event, object, mcSmearJetPtRatio);
+            if (rnd.Rndm() < 0.2) {
                 if (abs(eta) < 1.5) {
-                    return gSmearer_->Gaus(0.35,0.10);
+                    return rnd.Gaus(0.35,0.10);
                 } else {
-                    return gSmearer_->Gaus(0.47,0.20);
+                    return rnd.Gaus(0.47,0.20);
                 }
             }
         } 
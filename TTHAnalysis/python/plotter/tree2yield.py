@@ -21,6 +21,8 @@ from CMGTools.TTHAnalysis.plotter.fakeRate import *
 if "/functions_cc.so" not in ROOT.gSystem.GetLibraries(): 
     ROOT.gROOT.ProcessLine(".L %s/src/CMGTools/TTHAnalysis/python/plotter/functions.cc+" % os.environ['CMSSW_BASE']);
 
+_loadedLeptonSFPaths = []
+
 def scalarToVector(x):
     x0 = x
     x = re.sub(r"(LepGood|Lep|JetFwd|Jet|GenTop|SV)(\d)_(\w+)", lambda m : "%s_%s[%d]" % (m.group(1),m.group(3),int(m.group(2))-1), x)
@@ -183,6 +185,11 @@ class TreeToYield:
             libname = macro.replace(".cc","_cc.so").replace(".cxx","_cxx.so")
             if libname not in ROOT.gSystem.GetLibraries():
                 ROOT.gROOT.ProcessLine(".L %s+" % macro);
+        lepSFPath = getattr(self._options, 'lepSFPath', None)
+        if lepSFPath and lepSFPath not in _loadedLeptonSFPaths:
+            if not ROOT.loadLeptonSF_ttH(lepSFPath):
+                raise RuntimeError, "Could not load the lepton scale factors from %s" % lepSFPath
+            _loadedLeptonSFPaths.append(lepSFPath)
         #print "Done creation  %s for task %s in pid %d " % (self._fname, self._name, os.getpid())
     def setScaleFactor(self,scaleFactor):
         if self._mcCorrs and scaleFactor and scaleFactor != 1.0:
@@ -386,6 +393,7 @@ class TreeToYield:
                 ROOT.gROOT.ProcessLine(".L %s/src/CMGTools/TTHAnalysis/python/plotter/TH1Keys.cc+" % os.environ['CMSSW_BASE']);
             (nb,xmin,xmax) = bins.split(",")
             histo = ROOT.TH1KeysNew("dummyk","dummyk",int(nb),float(xmin),float(xmax),"a",1.0)
+            if self.getOption("KeysPdfBackend","native") == "roofit": histo.SetBackend(ROOT.TH1KeysNew.RooFitBackend)
             self._tree.Draw("%s>>%s" % (expr,"dummyk"), cut, "goff", self._options.maxEntries)
             self.negativeCheck(histo)
             return histo.GetHisto().Clone(name)
@@ -459,6 +467,7 @@ def addTreeToYieldOptions(parser):
     parser.add_option("--neg", "--allow-negative-results",     dest="allowNegative",    action="store_true", default=False, help="If the total yield is negative, keep it so rather than truncating it to zero") 
     parser.add_option("--max-entries",     dest="maxEntries", default=1000000000, type="int", help="Max entries to process in each tree") 
     parser.add_option("-L", "--load-macro",  dest="loadMacro",   type="string", action="append", default=[], help="Load the following macro, with .L <file>+");
+    parser.add_option("--lepSF-path", dest="lepSFPath", type="string", default=None, help="Directory from which to load the lepton scale factors of leptonSF_ttH before the event loop");
 
 def mergeReports(reports):
     import copy
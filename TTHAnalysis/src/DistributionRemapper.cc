@@ -2,17 +2,18 @@
 
 #include <cmath>
 #include <cstdio>
+#include <algorithm>
 #include <TH1.h>
 #include <TAxis.h>
+#include <Math/Interpolator.h>
 
-DistributionRemapper::DistributionRemapper(const TH1 *source, const TH1 *target) :
+DistributionRemapper::DistributionRemapper(const TH1 *source, const TH1 *target, unsigned int nTable) :
     xmin_(source->GetXaxis()->GetXmin()),
     ymin_(target->GetXaxis()->GetXmin()),
     xmax_(source->GetXaxis()->GetXmax()),
     ymax_(target->GetXaxis()->GetXmax()),
     x_(source->GetNbinsX()+1),
-    y_(source->GetNbinsX()+1),
-    interp_(0)
+    y_(source->GetNbinsX()+1)
 {
     int ns = source->GetNbinsX();
     int nt = target->GetNbinsX(); 
@@ -62,22 +63,68 @@ DistributionRemapper::DistributionRemapper(const TH1 *source, const TH1 *target)
         x_[i] = axt->GetBinUpEdge(i);
         y_[i] = tinv.Eval(srun);
     }
+
+    buildTable(nTable);
 }
 
 DistributionRemapper::~DistributionRemapper() 
 {
-    delete interp_; interp_ = 0;
 }
 
-double DistributionRemapper::Eval(double x) const 
+void DistributionRemapper::Eval(unsigned int n, const double *x, double *y) const 
+{
+    for (unsigned int i = 0; i < n; ++i) y[i] = Eval(x[i]);
+}
+
+void DistributionRemapper::Eval(unsigned int n, const float *x, float *y) const 
 {
-    if (!interp_) init();
-    if (x < xmin_) return ymin_;
-    if (x > xmax_) return ymax_;
-    return interp_->Eval(x);
+    for (unsigned int i = 0; i < n; ++i) y[i] = Eval(x[i]);
 }
 
-void DistributionRemapper::init() const 
+void DistributionRemapper::buildTable(unsigned int nTable) 
 {
-    interp_ = new ROOT::Math::Interpolator(x_, y_, ROOT::Math::Interpolation::kCSPLINE);
+    // natural cubic spline through (x_, y_), as gsl_interp_cspline: on [x_i, x_i+1]
+    // S(x) = y_i + b_i dx + c_i dx^2 + d_i dx^3, with c = S''/2 from the tridiagonal system
+    unsigned int n = x_.size();
+    std::vector<double> c(n, 0.), b(n, 0.), d(n, 0.);
+    if (n > 2) {
+        std::vector<double> diag(n), rhs(n);
+        for (unsigned int i = 1; i+1 < n; ++i) {
+            double h0 = x_[i]-x_[i-1], h1 = x_[i+1]-x_[i];
+            diag[i] = 2*(h0+h1);
+            rhs[i]  = 3*((y_[i+1]-y_[i])/h1 - (y_[i]-y_[i-1])/h0);
+        }
+        for (unsigned int i = 2; i+1 < n; ++i) { // forward elimination, off-diagonal h_(i-1)
+            double h = x_[i]-x_[i-1], m = h/diag[i-1];
+            diag[i] -= m*h;
+            rhs[i]  -= m*rhs[i-1];
+        }
+        for (unsigned int i = n-2; i >= 1; --i) {
+            c[i] = (rhs[i] - (i+2 < n ? (x_[i+1]-x_[i])*c[i+1] : 0))/diag[i];
+        }
+    }
+    double maxS2 = 0;
+    for (unsigned int i = 0; i+1 < n; ++i) {
+        double h = x_[i+1]-x_[i];
+        b[i] = (y_[i+1]-y_[i])/h - h*(c[i+1]+2*c[i])/3;
+        d[i] = (c[i+1]-c[i])/(3*h);
+        maxS2 = std::max(maxS2, std::abs(2*c[i]));
+    }
+    if (n) maxS2 = std::max(maxS2, std::abs(2*c[n-1]));
+
+    // uniform table of the spline between the first and last point, made non-decreasing
+    t0_ = x_.front();
+    double step = (x_.back() - x_.front())/nTable;
+    invStep_ = 1.0/step;
+    table_.resize(nTable+1);
+    double maxShift = 0;
+    for (unsigned int k = 0, i = 0; k <= nTable; ++k) {
+        double t = (k == nTable ? x_.back() : t0_ + k*step);
+        while (i+2 < n && x_[i+1] <= t) ++i;
+        double dx = t - x_[i];
+        double s = y_[i] + dx*(b[i] + dx*(c[i] + dx*d[i]));
+        table_[k] = (k > 0 ? std::max(s, table_[k-1]) : s);
+        maxShift = std::max(maxShift, table_[k] - s);
+    }
+    maxError_ = step*step/8*maxS2 + maxShift;
 }